@@ -0,0 +1,36 @@
+#!/bin/bash
+
+## =================================================================
+## BUSTUB PAGE SIZE BENCHMARKS
+##
+## This script builds BusTub once for every supported page size,
+## each in its own build directory, and runs the page size
+## benchmark of every build.
+##
+## Usage: build_support/run_page_size_benchmarks.sh [cmake args...]
+##
+## Run it from the root of the repository. Build directories go to
+## build-page-size-<bytes>, or under $BUILD_ROOT if it is set. Any
+## arguments are passed on to cmake. Build output goes to build.log
+## in each build directory.
+## =================================================================
+
+main() {
+  set -o errexit
+
+  local build_root="${BUILD_ROOT:-.}"
+  for page_size in 4096 8192 16384 32768 65536; do
+    local build_dir="${build_root}/build-page-size-${page_size}"
+    mkdir -p "${build_dir}"
+    if ! { cmake -S . -B "${build_dir}" -DCMAKE_BUILD_TYPE=Release -DBUSTUB_PAGE_SIZE="${page_size}" "$@" &&
+           cmake --build "${build_dir}" --target disk_manager_benchmark_test -j "$(nproc)"; } \
+         > "${build_dir}/build.log" 2>&1; then
+      echo "Building with BUSTUB_PAGE_SIZE=${page_size} failed, see ${build_dir}/build.log."
+      exit 1
+    fi
+    (cd "${build_dir}/test" && ./disk_manager_benchmark_test --gtest_filter='DiskManagerBenchmark.PageSize' \
+      | grep -v '^\[')
+  done
+}
+
+main "$@"
@@ -0,0 +1,238 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+ARCReplacer::ARCReplacer(size_t num_pages, size_t correlated_reference_period)
+    : capacity_(num_pages), correlated_reference_period_(correlated_reference_period), frames_(num_pages) {}
+
+ARCReplacer::~ARCReplacer() = default;
+
+bool ARCReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock(latch_);
+  // Take from T1 while it is over its target, from T2 otherwise, and from the other list if the preferred one has
+  // nothing evictable. Only evictable frames are linked, so the victim is the head of a list.
+  bool prefer_t1 = num_t1_ > target_t1_size_;
+  std::list<frame_id_t> *victims = prefer_t1 ? &t1_ : &t2_;
+  if (victims->empty()) {
+    victims = prefer_t1 ? &t2_ : &t1_;
+    if (victims->empty()) {
+      return false;
+    }
+  }
+  *frame_id = victims->front();
+
+  FrameEntry &frame = frames_[*frame_id];
+  ListType from = frame.list_;
+  Unlink(*frame_id);
+  if (frame.page_id_ != INVALID_PAGE_ID) {
+    AddGhost(from == ListType::T1 ? &b1_ : &b2_, frame.page_id_);
+  }
+  // The page id stays until the frame is refilled, in case the buffer pool fails to claim the frame.
+  frame.evicted_from_ = from;
+  frame.prefetched_ = false;
+  frame.prefetched_ghost_ = ListType::NONE;
+  return true;
+}
+
+void ARCReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  FrameEntry &frame = frames_[frame_id];
+  if (frame.list_ == ListType::NONE) {
+    return;
+  }
+  // A reference to a resident page makes it frequent, unless it is the first one after read-ahead brought it in or
+  // follows the previous one within the correlated reference period.
+  uint64_t now = ++current_timestamp_;
+  bool correlated = now - frame.last_reference_ < correlated_reference_period_;
+  frame.last_reference_ = now;
+  if (frame.prefetched_) {
+    // Read-ahead held back the ghost hit of a page it brought back; this is the reference that comes back.
+    frame.prefetched_ = false;
+    if (frame.prefetched_ghost_ != ListType::NONE) {
+      AdaptTarget(frame.prefetched_ghost_);
+      frame.prefetched_ghost_ = ListType::NONE;
+      MoveTo(frame_id, ListType::T2);
+    }
+  } else if (!correlated) {
+    MoveTo(frame_id, ListType::T2);
+  }
+  SetEvictable(frame_id, false);
+}
+
+void ARCReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  FrameEntry &frame = frames_[frame_id];
+  if (frame.evicted_from_ != ListType::NONE) {
+    // The buffer pool could not claim the victim, as it was pinned again, so its page is still resident: it is no
+    // ghost, and goes back to the list it was taken from.
+    EraseGhost(frame.evicted_from_ == ListType::T1 ? &b1_ : &b2_, frame.page_id_);
+    MoveTo(frame_id, frame.evicted_from_);
+    frame.evicted_from_ = ListType::NONE;
+  } else if (frame.list_ == ListType::NONE) {
+    // Not admitted through us, so there is no page to remember; treat it as seen once.
+    MoveTo(frame_id, ListType::T1);
+  }
+  SetEvictable(frame_id, true);
+}
+
+void ARCReplacer::Admit(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  FrameEntry &frame = frames_[frame_id];
+  SetEvictable(frame_id, false);
+  frame.last_reference_ = ++current_timestamp_;
+  ListType ghost = TakeGhost(&frame, page_id);
+  // A ghost hit means the page would have stayed resident had the list it was evicted from been larger.
+  if (ghost != ListType::NONE) {
+    AdaptTarget(ghost);
+    MoveTo(frame_id, ListType::T2);
+    return;
+  }
+  MoveTo(frame_id, ListType::T1);
+}
+
+void ARCReplacer::AdmitPrefetched(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  FrameEntry &frame = frames_[frame_id];
+  // Read-ahead is not a reference, so a ghost hit only counts once the page is pinned; until then it sits on T1.
+  frame.prefetched_ghost_ = TakeGhost(&frame, page_id);
+  frame.prefetched_ = true;
+  MoveTo(frame_id, ListType::T1);
+  SetEvictable(frame_id, true);
+}
+
+void ARCReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  FrameEntry &frame = frames_[frame_id];
+  frame.evicted_from_ = ListType::NONE;
+  if (frame.list_ == ListType::NONE) {
+    frame.page_id_ = INVALID_PAGE_ID;
+    return;
+  }
+  Unlink(frame_id);
+  frame.page_id_ = INVALID_PAGE_ID;
+  frame.prefetched_ = false;
+  frame.prefetched_ghost_ = ListType::NONE;
+}
+
+size_t ARCReplacer::Size() {
+  std::scoped_lock lock(latch_);
+  return num_evictable_;
+}
+
+std::vector<frame_id_t> ARCReplacer::GetEvictionOrder() {
+  std::scoped_lock lock(latch_);
+  // Which list a victim comes from depends on the adaptation target at the time, so list the frames seen once ahead of
+  // the frames seen again, each from least recently used.
+  std::vector<frame_id_t> order(t1_.begin(), t1_.end());
+  order.insert(order.end(), t2_.begin(), t2_.end());
+  return order;
+}
+
+ARCReplacerStats ARCReplacer::GetStats() {
+  std::scoped_lock lock(latch_);
+  return {target_t1_size_, num_t1_, num_t2_, b1_.pages_.size(), b2_.pages_.size()};
+}
+
+void ARCReplacer::MoveTo(frame_id_t frame_id, ListType list) {
+  FrameEntry &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    ListOf(frame.list_)->erase(frame.pos_);
+  }
+  if (frame.list_ != ListType::NONE) {
+    (frame.list_ == ListType::T1 ? num_t1_ : num_t2_)--;
+  }
+  frame.list_ = list;
+  (list == ListType::T1 ? num_t1_ : num_t2_)++;
+  if (frame.evictable_) {
+    frame.pos_ = ListOf(list)->insert(ListOf(list)->end(), frame_id);
+  }
+}
+
+void ARCReplacer::Unlink(frame_id_t frame_id) {
+  SetEvictable(frame_id, false);
+  FrameEntry &frame = frames_[frame_id];
+  if (frame.list_ != ListType::NONE) {
+    (frame.list_ == ListType::T1 ? num_t1_ : num_t2_)--;
+  }
+  frame.list_ = ListType::NONE;
+}
+
+void ARCReplacer::SetEvictable(frame_id_t frame_id, bool evictable) {
+  FrameEntry &frame = frames_[frame_id];
+  if (frame.evictable_ == evictable) {
+    return;
+  }
+  frame.evictable_ = evictable;
+  if (evictable) {
+    frame.pos_ = ListOf(frame.list_)->insert(ListOf(frame.list_)->end(), frame_id);
+    num_evictable_++;
+  } else {
+    ListOf(frame.list_)->erase(frame.pos_);
+    num_evictable_--;
+  }
+}
+
+ARCReplacer::ListType ARCReplacer::TakeGhost(FrameEntry *frame, page_id_t page_id) {
+  frame->page_id_ = page_id;
+  frame->evicted_from_ = ListType::NONE;
+  frame->prefetched_ = false;
+  frame->prefetched_ghost_ = ListType::NONE;
+  if (EraseGhost(&b1_, page_id)) {
+    return ListType::T1;
+  }
+  if (EraseGhost(&b2_, page_id)) {
+    return ListType::T2;
+  }
+  return ListType::NONE;
+}
+
+void ARCReplacer::AdaptTarget(ListType ghost) {
+  // Grow the T1 target on a B1 hit and shrink it on a B2 hit, faster the smaller the ghost list hit is.
+  if (ghost == ListType::T1) {
+    size_t delta = std::max<size_t>(1, b2_.pages_.size() / std::max<size_t>(1, b1_.pages_.size() + 1));
+    target_t1_size_ = std::min(capacity_, target_t1_size_ + delta);
+  } else {
+    size_t delta = std::max<size_t>(1, b1_.pages_.size() / std::max<size_t>(1, b2_.pages_.size() + 1));
+    target_t1_size_ = target_t1_size_ > delta ? target_t1_size_ - delta : 0;
+  }
+}
+
+void ARCReplacer::AddGhost(GhostList *ghost, page_id_t page_id) {
+  // A page is a ghost at most once, whichever list it was last evicted from.
+  EraseGhost(&b1_, page_id);
+  EraseGhost(&b2_, page_id);
+  ghost->index_[page_id] = ghost->pages_.insert(ghost->pages_.end(), page_id);
+  // Ghosts never outnumber frames. B1 is trimmed first once T1 and B1 together exceed the pool, which bounds how
+  // long a page seen only once is remembered.
+  while (b1_.pages_.size() + b2_.pages_.size() > capacity_) {
+    GhostList *victim = (num_t1_ + b1_.pages_.size() > capacity_ || b2_.pages_.empty()) ? &b1_ : &b2_;
+    victim->index_.erase(victim->pages_.front());
+    victim->pages_.pop_front();
+  }
+}
+
+bool ARCReplacer::EraseGhost(GhostList *ghost, page_id_t page_id) {
+  auto it = ghost->index_.find(page_id);
+  if (it == ghost->index_.end()) {
+    return false;
+  }
+  ghost->pages_.erase(it->second);
+  ghost->index_.erase(it);
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,45 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.cpp
+//
+// Identification: src/buffer/buffer_access_strategy.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+#include <algorithm>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+BufferAccessStrategy::BufferAccessStrategy(size_t ring_size, size_t activation_threshold)
+    : ring_size_(ring_size), activation_threshold_(activation_threshold) {
+  BUSTUB_ASSERT(ring_size > 0, "A buffer ring needs at least one frame");
+}
+
+std::shared_ptr<BufferAccessStrategy> BufferAccessStrategy::ForBulkRead(BufferPoolManager *bpm) {
+  size_t pool_size = bpm->GetPoolSize();
+  // Read-ahead fills the ring ahead of the scan; a smaller ring would recycle pages before the scan gets to them.
+  size_t ring_size = std::max(std::min(BULK_READ_RING_SIZE, pool_size / 4), bpm->GetReadAheadDistance() + 2);
+  auto activation_threshold = static_cast<size_t>(BULK_READ_THRESHOLD_RATIO * static_cast<double>(pool_size));
+  return std::make_shared<BufferAccessStrategy>(ring_size, activation_threshold);
+}
+
+size_t BufferAccessStrategy::GetNumReads() {
+  std::scoped_lock lock(latch_);
+  return num_reads_;
+}
+
+size_t BufferAccessStrategy::GetNumRecycled() {
+  std::scoped_lock lock(latch_);
+  return num_recycled_;
+}
+
+}  // namespace bustub
@@ -0,0 +1,205 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager.cpp
+//
+// Identification: src/buffer/buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_manager.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+/** Start of a hot page file. The page ids follow, hottest first. */
+struct HotPagesHeader {
+  uint64_t magic_;
+  uint64_t num_pages_;
+};
+
+static constexpr uint64_t HOT_PAGES_MAGIC = 0x544f484255545342;  // "BSTUBHOT"
+
+BufferPoolManager::~BufferPoolManager() {
+  StopPrefetchWorker();
+  ShutDownWarmUp();
+}
+
+BasicPageGuard BufferPoolManager::FetchPageBasic(page_id_t page_id) { return {this, FetchPage(page_id)}; }
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page == nullptr) {
+    return {};
+  }
+  page->RLatch();
+  return {this, page};
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page == nullptr) {
+    return {};
+  }
+  page->WLatch();
+  return {this, page};
+}
+
+BasicPageGuard BufferPoolManager::NewPageGuarded(page_id_t *page_id) { return {this, NewPage(page_id)}; }
+
+void BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  for (page_id_t page_id : page_ids) {
+    EnqueuePrefetch({page_id, 1, nullptr, nullptr, nullptr});
+  }
+}
+
+void BufferPoolManager::PrefetchPageChain(page_id_t first_page_id, size_t count, next_page_id_fn next_page_id,
+                                          std::shared_ptr<BufferAccessStrategy> strategy,
+                                          std::shared_ptr<std::atomic<page_id_t>> chain_end) {
+  EnqueuePrefetch({first_page_id, count, next_page_id, std::move(strategy), std::move(chain_end)});
+}
+
+void BufferPoolManager::EnqueuePrefetch(const PrefetchRequest &request) {
+  if (request.page_id_ == INVALID_PAGE_ID || request.count_ == 0) {
+    if (request.chain_end_ != nullptr) {
+      request.chain_end_->store(request.page_id_, std::memory_order_release);
+    }
+    return;
+  }
+  {
+    std::scoped_lock lock(prefetch_latch_);
+    if (prefetch_worker_stopped_ || prefetch_queue_.size() >= MAX_QUEUED_PREFETCHES) {
+      if (request.chain_end_ != nullptr) {
+        request.chain_end_->store(request.page_id_, std::memory_order_release);
+      }
+      return;
+    }
+    if (!prefetch_worker_running_) {
+      prefetch_worker_running_ = true;
+      prefetch_worker_ = std::thread(&BufferPoolManager::PrefetchWorkerLoop, this);
+    }
+    prefetch_queue_.push_back(request);
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::StopPrefetchWorker() {
+  {
+    std::scoped_lock lock(prefetch_latch_);
+    prefetch_worker_stopped_ = true;
+    prefetch_queue_.clear();
+    if (!prefetch_worker_running_) {
+      return;
+    }
+  }
+  prefetch_cv_.notify_one();
+  if (prefetch_worker_.joinable()) {
+    prefetch_worker_.join();
+  }
+}
+
+bool BufferPoolManager::SaveHotPages(const std::string &path) {
+  std::vector<page_id_t> page_ids = GetHotPages();
+  // Written next to the file and renamed over it, so a crash leaves either the old list or the new one.
+  std::string tmp_path = path + ".tmp";
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open hot page file");
+    return false;
+  }
+  HotPagesHeader header{HOT_PAGES_MAGIC, page_ids.size()};
+  auto size = static_cast<ssize_t>(page_ids.size() * sizeof(page_id_t));
+  bool ok = pwrite(fd, &header, sizeof(header), 0) == sizeof(header) &&
+            pwrite(fd, page_ids.data(), size, sizeof(header)) == size && fdatasync(fd) == 0;
+  close(fd);
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG_DEBUG("I/O error while writing hot page file");
+    remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::vector<page_id_t> BufferPoolManager::LoadHotPages(const std::string &path) {
+  std::vector<page_id_t> page_ids;
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return page_ids;
+  }
+  HotPagesHeader header;
+  struct stat stat_buf;
+  if (pread(fd, &header, sizeof(header), 0) == sizeof(header) && header.magic_ == HOT_PAGES_MAGIC &&
+      fstat(fd, &stat_buf) == 0 &&
+      static_cast<uint64_t>(stat_buf.st_size) == sizeof(header) + header.num_pages_ * sizeof(page_id_t)) {
+    page_ids.resize(header.num_pages_);
+    auto size = static_cast<ssize_t>(page_ids.size() * sizeof(page_id_t));
+    if (pread(fd, page_ids.data(), size, sizeof(header)) != size) {
+      page_ids.clear();
+    }
+  }
+  close(fd);
+  return page_ids;
+}
+
+void BufferPoolManager::EnableWarmUp(const std::string &path) {
+  warm_up_path_ = path;
+  warm_up_thread_ = std::thread([this] { num_warmed_up_ = WarmUp(LoadHotPages(warm_up_path_)); });
+}
+
+size_t BufferPoolManager::WaitForWarmUp() {
+  if (warm_up_thread_.joinable()) {
+    warm_up_thread_.join();
+  }
+  return num_warmed_up_;
+}
+
+void BufferPoolManager::ShutDownWarmUp() {
+  WaitForWarmUp();
+  if (!warm_up_path_.empty()) {
+    SaveHotPages(warm_up_path_);
+    // Only save once, even though the base destructor calls this again.
+    warm_up_path_.clear();
+  }
+}
+
+void BufferPoolManager::PrefetchWorkerLoop() {
+  std::unique_lock lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [&] { return prefetch_worker_stopped_ || !prefetch_queue_.empty(); });
+    if (prefetch_worker_stopped_) {
+      return;
+    }
+    PrefetchRequest request = std::move(prefetch_queue_.front());
+    prefetch_queue_.pop_front();
+    lock.unlock();
+
+    page_id_t page_id = request.page_id_;
+    for (size_t i = 0; i < request.count_ && page_id != INVALID_PAGE_ID; i++) {
+      page_id_t next = INVALID_PAGE_ID;
+      // The link out of the last page is only needed to tell the caller where to carry on.
+      bool need_next = i + 1 < request.count_ || request.chain_end_ != nullptr;
+      if (!PrefetchPgImp(page_id, need_next ? request.next_page_id_ : nullptr, &next, request.strategy_.get())) {
+        break;
+      }
+      page_id = next;
+    }
+    if (request.chain_end_ != nullptr) {
+      request.chain_end_->store(page_id, std::memory_order_release);
+    }
+
+    lock.lock();
+  }
+}
+
+}  // namespace bustub
@@ -12,90 +12,776 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t replacer_k)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_type, replacer_k) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type, size_t replacer_k)
     : pool_size_(pool_size),
       num_instances_(num_instances),
       instance_index_(instance_index),
-      next_page_id_(instance_index),
+      frame_arena_(pool_size),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      page_table_(pool_size) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // Frame data lives in the arena, so the metadata array stays small and each frame's data stays page-aligned.
+  pages_ = static_cast<Page *>(operator new[](pool_size_ * sizeof(Page)));
+  for (size_t i = 0; i < pool_size_; ++i) {
+    new (&pages_[i]) Page(frame_arena_.GetFrameData(i));
+  }
+  switch (replacer_type) {
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(pool_size, replacer_k);
+      break;
+    case ReplacerType::ARC:
+      replacer_ = new ARCReplacer(pool_size);
+      break;
+    case ReplacerType::LRU:
+    default:
+      replacer_ = new LRUReplacer(pool_size);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].pin_count_.store(Page::PIN_COUNT_LOCKED, std::memory_order_relaxed);
     free_list_.emplace_back(static_cast<int>(i));
   }
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  ShutDownWarmUp();
+  StopPrefetchWorker();
+  StopBackgroundWriter();
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  operator delete[](pages_);
   delete replacer_;
 }
 
 bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
-  // Make sure you call DiskManager::WritePage!
-  return false;
+  frame_id_t frame_id;
+  {
+    // Pin the frame to keep it mapped, but latch the page only after releasing latch_: a writer holding the page
+    // latch may be waiting for latch_.
+    std::scoped_lock lock(latch_);
+    if (page_id == INVALID_PAGE_ID || !page_table_.Find(page_id, &frame_id)) {
+      return false;
+    }
+    if (pages_[frame_id].pin_count_.fetch_add(1, std::memory_order_acquire) == 0) {
+      num_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  // The read latch keeps the write from being torn. The dirty flag is cleared first, so that a change made after the
+  // write sets it again.
+  Page *page = &pages_[frame_id];
+  page->RLatch();
+  page->is_dirty_.store(false, std::memory_order_release);
+  disk_manager_->WritePage(page_id, page->GetData());
+  page->RUnlatch();
+  UnpinFrame(frame_id);
+  return true;
 }
 
-void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
+void BufferPoolManagerInstance::FlushAllPgsImp() { FlushInstances({this}); }
+
+void BufferPoolManagerInstance::FlushInstances(const std::vector<BufferPoolManagerInstance *> &instances) {
+  // Pin the dirty frames of each instance under its latch, so that they stay mapped once it is released.
+  std::vector<std::tuple<page_id_t, BufferPoolManagerInstance *, frame_id_t>> frames;
+  for (BufferPoolManagerInstance *instance : instances) {
+    BUSTUB_ASSERT(instance->disk_manager_ == instances[0]->disk_manager_, "instances must share a disk manager");
+    std::scoped_lock lock(instance->latch_);
+    for (size_t i = 0; i < instance->pool_size_; i++) {
+      Page *page = &instance->pages_[i];
+      // Frames on the free list are the only ones left locked while we hold the latch.
+      if (!page->IsDirty() || page->pin_count_.load(std::memory_order_acquire) == Page::PIN_COUNT_LOCKED) {
+        continue;
+      }
+      if (page->pin_count_.fetch_add(1, std::memory_order_acquire) == 0) {
+        instance->num_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+      }
+      frames.emplace_back(page->GetPageId(), instance, static_cast<frame_id_t>(i));
+    }
+  }
+  if (frames.empty()) {
+    return;
+  }
+
+  // Copy the pages a batch at a time, each under its read latch so the copy is not torn, and clear the dirty flag
+  // before copying: a writer that modifies the page afterwards sets it again. The frames stay pinned until the batch
+  // is on disk, since a frame that looks clean could otherwise be evicted and its old image read back. Sorting by page
+  // id first keeps pages of different instances with consecutive ids in the same batch, to be coalesced into the same
+  // write.
+  std::sort(frames.begin(), frames.end());
+  const size_t batch_size = std::min(FLUSH_BATCH_SIZE, frames.size());
+  auto free_buffer = [](char *data) { operator delete[](data, std::align_val_t{PAGE_SIZE}); };
+  std::unique_ptr<char[], decltype(free_buffer)> buffer(new (std::align_val_t{PAGE_SIZE}) char[batch_size * PAGE_SIZE],
+                                                        free_buffer);
+  for (size_t start = 0; start < frames.size(); start += batch_size) {
+    std::vector<std::pair<page_id_t, const char *>> writes;
+    for (size_t i = start; i < std::min(frames.size(), start + batch_size); i++) {
+      auto [page_id, instance, frame_id] = frames[i];
+      Page *page = &instance->pages_[frame_id];
+      page->RLatch();
+      if (page->IsDirty()) {
+        page->is_dirty_.store(false, std::memory_order_release);
+        char *copy = buffer.get() + writes.size() * PAGE_SIZE;
+        memcpy(copy, page->GetData(), PAGE_SIZE);
+        writes.emplace_back(page_id, copy);
+      }
+      page->RUnlatch();
+    }
+    if (!writes.empty()) {
+      instances[0]->disk_manager_->WritePages(std::move(writes));
+    }
+    for (size_t i = start; i < std::min(frames.size(), start + batch_size); i++) {
+      auto [page_id, instance, frame_id] = frames[i];
+      instance->UnpinFrame(frame_id);
+    }
+  }
 }
 
-Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
-  // 0.   Make sure you call AllocatePage!
-  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
-  // 4.   Set the page ID output parameter. Return a pointer to P.
-  return nullptr;
+Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) { return NewPgNearImp(page_id, INVALID_PAGE_ID); }
+
+Page *BufferPoolManagerInstance::NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) {
+  auto lock = LockLatch();
+  frame_id_t frame_id;
+  if (!GetVictimFrame(&frame_id)) {
+    return nullptr;
+  }
+  *page_id = AllocatePage(near_page_id);
+
+  Page *page = &pages_[frame_id];
+  page->ResetMemory();
+  page->page_id_.store(*page_id, std::memory_order_relaxed);
+  page->is_dirty_.store(false, std::memory_order_relaxed);
+  page_table_.Insert(*page_id, frame_id);
+  // Not tracked by the replacer yet, but history-based policies count this as the first reference.
+  replacer_->Admit(frame_id, *page_id);
+  num_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+  // Publishes the new identity of the frame to lock-free fetches.
+  page->pin_count_.store(1, std::memory_order_release);
+  return page;
 }
 
-Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
-  // 1.     Search the page table for the requested page (P).
-  // 1.1    If P exists, pin it and return it immediately.
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  // 2.     If R is dirty, write it back to the disk.
-  // 3.     Delete R from the page table and insert P.
-  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  return nullptr;
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) { return FetchPgWithStrategyImp(page_id, nullptr); }
+
+Page *BufferPoolManagerInstance::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  // Fast path: a hit only touches the page table and the frame's pin count.
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id) && TryPinResident(frame_id, page_id)) {
+    counters_.Add(HITS);
+    return &pages_[frame_id];
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto lock = LockLatch();
+  AwaitReadIn(&lock, page_id);
+  // The page may have been brought in while we waited for the latch. Mapped frames cannot be locked by anyone else
+  // while we hold it, so a plain increment is enough.
+  if (page_table_.Find(page_id, &frame_id)) {
+    if (pages_[frame_id].pin_count_.fetch_add(1, std::memory_order_acquire) == 0) {
+      num_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+      replacer_->Pin(frame_id);
+    }
+    counters_.Add(HITS);
+    return &pages_[frame_id];
+  }
+  counters_.Add(MISSES);
+
+  page_id_t write_back_page_id;
+  if (!GetVictimFrame(&frame_id, page_id, strategy, &write_back_page_id)) {
+    return nullptr;
+  }
+  ReadIntoFrame(&lock, frame_id, page_id, write_back_page_id);
+  Page *page = &pages_[frame_id];
+  page->page_id_.store(page_id, std::memory_order_relaxed);
+  page->is_dirty_.store(false, std::memory_order_relaxed);
+  page_table_.Insert(page_id, frame_id);
+  replacer_->Admit(frame_id, page_id);
+  num_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+  page->pin_count_.store(1, std::memory_order_release);
+  miss_latency_.Record(std::chrono::steady_clock::now() - start);
+  return page;
 }
 
 bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
-  // 0.   Make sure you call DeallocatePage!
-  // 1.   Search the page table for the requested page (P).
-  // 1.   If P does not exist, return true.
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  return false;
+  std::unique_lock lock(latch_);
+  AwaitReadIn(&lock, page_id);
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    DeallocatePage(page_id);
+    return true;
+  }
+  Page *page = &pages_[frame_id];
+  int pin_count = 0;
+  if (!page->pin_count_.compare_exchange_strong(pin_count, Page::PIN_COUNT_LOCKED, std::memory_order_acq_rel)) {
+    return false;
+  }
+  page_table_.Erase(page_id);
+  replacer_->Remove(frame_id);
+  DeallocatePage(page_id);
+
+  page->ResetMemory();
+  page->page_id_.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+  page->is_dirty_.store(false, std::memory_order_relaxed);
+  free_list_.push_back(frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id, next_page_id_fn next_page_id, page_id_t *next,
+                                              BufferAccessStrategy *strategy) {
+  // Already resident: only the link is needed, so peek at it under a pin that the replacer does not see.
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id) && TryPinResident(frame_id, page_id, false)) {
+    Page *page = &pages_[frame_id];
+    if (next_page_id != nullptr) {
+      page->RLatch();
+      *next = next_page_id(page->GetData());
+      page->RUnlatch();
+    }
+    UnpinFrame(frame_id);
+    return true;
+  }
+
+  std::unique_lock lock(latch_);
+  AwaitReadIn(&lock, page_id);
+  if (page_table_.Find(page_id, &frame_id)) {
+    // Brought in by someone else meanwhile. Pin it to keep it mapped, but latch it only after releasing latch_: a
+    // writer holding the page latch may be waiting for latch_.
+    Page *page = &pages_[frame_id];
+    if (page->pin_count_.fetch_add(1, std::memory_order_acquire) == 0) {
+      num_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+    lock.unlock();
+    if (next_page_id != nullptr) {
+      page->RLatch();
+      *next = next_page_id(page->GetData());
+      page->RUnlatch();
+    }
+    UnpinFrame(frame_id);
+    return true;
+  }
+
+  page_id_t write_back_page_id;
+  if (!GetVictimFrame(&frame_id, page_id, strategy, &write_back_page_id)) {
+    return false;
+  }
+  try {
+    ReadIntoFrame(&lock, frame_id, page_id, write_back_page_id);
+  } catch (Exception &) {
+    // Read-ahead is only a hint; the fetch that needs the page will report the corruption.
+    return false;
+  }
+  counters_.Add(PREFETCHES);
+  Page *page = &pages_[frame_id];
+  page->page_id_.store(page_id, std::memory_order_relaxed);
+  page->is_dirty_.store(false, std::memory_order_relaxed);
+  // Nobody else can reach the frame until it is unlocked below.
+  if (next_page_id != nullptr) {
+    *next = next_page_id(page->GetData());
+  }
+  page_table_.Insert(page_id, frame_id);
+  // Victim searches need latch_, so the frame cannot be picked before its pin count is published.
+  replacer_->AdmitPrefetched(frame_id, page_id);
+  page->pin_count_.store(0, std::memory_order_release);
+  return true;
 }
 
-bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) { return false; }
+bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
+  frame_id_t frame_id;
+  // The caller holds a pin, so the mapping cannot change underneath us.
+  if (!page_table_.Find(page_id, &frame_id) || pages_[frame_id].GetPageId() != page_id) {
+    return false;
+  }
+  if (is_dirty) {
+    pages_[frame_id].is_dirty_.store(true, std::memory_order_release);
+  }
+  return UnpinFrame(frame_id);
+}
 
-page_id_t BufferPoolManagerInstance::AllocatePage() {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
-  ValidatePageId(next_page_id);
-  return next_page_id;
+page_id_t BufferPoolManagerInstance::AllocatePage(page_id_t near_page_id) {
+  const page_id_t page_id = disk_manager_->AllocatePage(near_page_id, num_instances_, instance_index_);
+  ValidatePageId(page_id);
+  return page_id;
 }
 
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
   assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
 }
 
+bool BufferPoolManagerInstance::TryPinResident(frame_id_t frame_id, page_id_t page_id, bool reference) {
+  Page *page = &pages_[frame_id];
+  int pin_count = page->pin_count_.load(std::memory_order_relaxed);
+  do {
+    if (pin_count < 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1, std::memory_order_acquire,
+                                                   std::memory_order_relaxed));
+  if (pin_count == 0) {
+    num_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Our pin keeps the frame from being refilled, so this check is stable: the lookup may have raced with an eviction.
+  if (page->page_id_.load(std::memory_order_acquire) != page_id) {
+    UnpinFrame(frame_id);
+    return false;
+  }
+  if (pin_count == 0 && reference) {
+    replacer_->Pin(frame_id);
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  int pin_count = page->pin_count_.load(std::memory_order_relaxed);
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+  if (pin_count == 1) {
+    num_pinned_frames_.fetch_sub(1, std::memory_order_relaxed);
+    replacer_->Unpin(frame_id);
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::GetVictimFrame(frame_id_t *frame_id, page_id_t *deferred_write_back) {
+  if (deferred_write_back != nullptr) {
+    *deferred_write_back = INVALID_PAGE_ID;
+  }
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  while (replacer_->Victim(frame_id)) {
+    Page *page = &pages_[*frame_id];
+    int pin_count = 0;
+    // A lock-free fetch may have pinned the frame after it was handed to the replacer. Skip it; the frame goes back
+    // to the replacer when that pin is released.
+    if (!page->pin_count_.compare_exchange_strong(pin_count, Page::PIN_COUNT_LOCKED, std::memory_order_acq_rel)) {
+      continue;
+    }
+    EvictFrame(*frame_id, deferred_write_back);
+    return true;
+  }
+  return false;
+}
+
+bool BufferPoolManagerInstance::GetVictimFrame(frame_id_t *frame_id, page_id_t page_id, BufferAccessStrategy *strategy,
+                                               page_id_t *deferred_write_back) {
+  if (strategy == nullptr) {
+    return GetVictimFrame(frame_id, deferred_write_back);
+  }
+  std::scoped_lock ring_lock(strategy->latch_);
+  if (strategy->num_reads_++ < strategy->activation_threshold_) {
+    return GetVictimFrame(frame_id, deferred_write_back);
+  }
+
+  BufferAccessStrategy::Ring &ring = strategy->rings_[this];
+  if (ring.slots_.empty()) {
+    ring.slots_.resize(strategy->ring_size_);
+  }
+  BufferAccessStrategy::Slot &slot = ring.slots_[ring.next_];
+  ring.next_ = (ring.next_ + 1) % ring.slots_.size();
+
+  // Page ids only change under latch_, so the check cannot go stale before the frame is locked.
+  bool recycled = false;
+  if (slot.page_id_ != INVALID_PAGE_ID && pages_[slot.frame_id_].GetPageId() == slot.page_id_) {
+    Page *page = &pages_[slot.frame_id_];
+    int pin_count = 0;
+    if (page->pin_count_.compare_exchange_strong(pin_count, Page::PIN_COUNT_LOCKED, std::memory_order_acq_rel)) {
+      replacer_->Remove(slot.frame_id_);
+      if (deferred_write_back != nullptr) {
+        *deferred_write_back = INVALID_PAGE_ID;
+      }
+      EvictFrame(slot.frame_id_, deferred_write_back);
+      *frame_id = slot.frame_id_;
+      strategy->num_recycled_++;
+      recycled = true;
+    }
+  }
+  // The slot was empty, or its frame is in use elsewhere now: give the ring a regular victim instead.
+  if (!recycled && !GetVictimFrame(frame_id, deferred_write_back)) {
+    slot = {};
+    return false;
+  }
+  slot = {*frame_id, page_id};
+  return true;
+}
+
+void BufferPoolManagerInstance::EvictFrame(frame_id_t frame_id, page_id_t *deferred_write_back) {
+  Page *page = &pages_[frame_id];
+  page_table_.Erase(page->GetPageId());
+  counters_.Add(EVICTIONS);
+  if (page->IsDirty()) {
+    counters_.Add(DIRTY_WRITE_BACKS);
+    if (deferred_write_back != nullptr && disk_scheduler_ != nullptr) {
+      *deferred_write_back = page->GetPageId();
+    } else {
+      disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    }
+    page->is_dirty_.store(false, std::memory_order_relaxed);
+    // The writer is falling behind; don't wait for its next round.
+    {
+      std::scoped_lock writer_lock(background_writer_latch_);
+      background_writer_wakeup_ = true;
+    }
+    background_writer_cv_.notify_one();
+  }
+}
+
+void BufferPoolManagerInstance::ReadIntoFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id,
+                                              page_id_t page_id, page_id_t write_back_page_id) {
+  // The frame is locked and unmapped, so nobody else touches it while latch_ is released for the I/O. Misses on the
+  // page, or on the one being written back, which would otherwise read it from disk too early, wait for us instead.
+  reading_in_.insert(page_id);
+  if (write_back_page_id != INVALID_PAGE_ID) {
+    reading_in_.insert(write_back_page_id);
+  }
+  lock->unlock();
+  char *data = pages_[frame_id].GetData();
+  std::exception_ptr error;
+  try {
+    if (disk_scheduler_ == nullptr) {
+      disk_manager_->ReadPage(page_id, data);
+    } else {
+      // The write-back must have copied the old contents out before the read lands, so the two go out linked.
+      std::vector<DiskRequest> requests;
+      if (write_back_page_id != INVALID_PAGE_ID) {
+        requests.push_back({true, data, write_back_page_id, disk_scheduler_->CreatePromise(), true});
+      }
+      requests.push_back({false, data, page_id, disk_scheduler_->CreatePromise()});
+      auto read_done = requests.back().callback_.get_future();
+      disk_scheduler_->Schedule(std::move(requests));
+      read_done.get();
+    }
+  } catch (Exception &) {
+    error = std::current_exception();
+  }
+  lock->lock();
+  reading_in_.erase(page_id);
+  reading_in_.erase(write_back_page_id);
+  // The waiters only get latch_ after the caller has mapped the page and released it.
+  read_in_cv_.notify_all();
+  if (error != nullptr) {
+    // The page failed its checksum. The frame is still locked and unmapped, so it can go straight to the free list.
+    Page *page = &pages_[frame_id];
+    page->ResetMemory();
+    page->page_id_.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+    page->is_dirty_.store(false, std::memory_order_relaxed);
+    free_list_.push_back(frame_id);
+    std::rethrow_exception(error);
+  }
+}
+
+void BufferPoolManagerInstance::StartBackgroundWriter(double target_clean_ratio, size_t batch_size) {
+  std::scoped_lock lock(background_writer_latch_);
+  if (background_writer_running_) {
+    return;
+  }
+  target_clean_ratio_ = std::clamp(target_clean_ratio, 0.0, 1.0);
+  write_batch_size_ = std::max<size_t>(batch_size, 1);
+  background_writer_running_ = true;
+  background_writer_ = std::thread(&BufferPoolManagerInstance::BackgroundWriterLoop, this);
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  {
+    std::scoped_lock lock(background_writer_latch_);
+    if (!background_writer_running_) {
+      return;
+    }
+    background_writer_running_ = false;
+  }
+  background_writer_cv_.notify_one();
+  background_writer_.join();
+}
+
+size_t BufferPoolManagerInstance::GetNumCleanFrames() {
+  size_t num_clean = 0;
+  for (size_t i = 0; i < pool_size_; i++) {
+    int pin_count = pages_[i].pin_count_.load(std::memory_order_acquire);
+    // Free frames are locked and clean; frames being refilled are also locked and about to be pinned, but are rare.
+    if (pin_count == Page::PIN_COUNT_LOCKED || (pin_count == 0 && !pages_[i].IsDirty())) {
+      num_clean++;
+    }
+  }
+  return num_clean;
+}
+
+void BufferPoolManagerInstance::BackgroundWriterLoop() {
+  std::unique_lock lock(background_writer_latch_);
+  while (background_writer_running_) {
+    background_writer_wakeup_ = false;
+    const auto target = static_cast<size_t>(std::ceil(target_clean_ratio_ * static_cast<double>(pool_size_)));
+    const size_t batch_size = write_batch_size_;
+    lock.unlock();
+
+    size_t num_written = 0;
+    size_t num_clean = GetNumCleanFrames();
+    if (num_clean < target) {
+      num_written = WriteBackColdFrames(std::min(batch_size, target - num_clean));
+    }
+
+    lock.lock();
+    // A full batch means there is probably more to do, so go again right away.
+    if (num_written < batch_size) {
+      background_writer_cv_.wait_for(lock, bg_writer_interval,
+                                     [&] { return !background_writer_running_ || background_writer_wakeup_; });
+    }
+  }
+}
+
+size_t BufferPoolManagerInstance::WriteBackColdFrames(size_t max_pages) {
+  std::vector<frame_id_t> frame_ids;
+  for (size_t i = 0; i < pool_size_ && frame_ids.size() < max_pages; i++) {
+    auto frame_id = static_cast<frame_id_t>(background_writer_hand_);
+    background_writer_hand_ = (background_writer_hand_ + 1) % pool_size_;
+    if (TryBeginWriteBack(frame_id)) {
+      frame_ids.push_back(frame_id);
+    }
+  }
+
+  if (disk_scheduler_ == nullptr) {
+    for (auto frame_id : frame_ids) {
+      disk_manager_->WritePage(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
+      EndWriteBack(frame_id);
+    }
+  } else {
+    // The whole round goes to the disk in as few submissions as the scheduler allows.
+    for (size_t start = 0; start < frame_ids.size(); start += disk_scheduler_->GetQueueDepth()) {
+      size_t end = std::min(frame_ids.size(), start + disk_scheduler_->GetQueueDepth());
+      std::vector<DiskRequest> requests;
+      std::vector<std::future<bool>> done;
+      for (size_t i = start; i < end; i++) {
+        Page *page = &pages_[frame_ids[i]];
+        requests.push_back({true, page->GetData(), page->GetPageId(), disk_scheduler_->CreatePromise()});
+        done.push_back(requests.back().callback_.get_future());
+      }
+      disk_scheduler_->Schedule(std::move(requests));
+      for (size_t i = start; i < end; i++) {
+        done[i - start].get();
+        EndWriteBack(frame_ids[i]);
+      }
+    }
+  }
+  counters_.Add(BACKGROUND_WRITES, frame_ids.size());
+  return frame_ids.size();
+}
+
+bool BufferPoolManagerInstance::TryBeginWriteBack(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  if (!page->IsDirty()) {
+    return false;
+  }
+  // Only frames nobody is using are cold enough to be worth writing ahead of eviction. Taking the pin directly keeps
+  // the frame where it is in the replacer; if a victim search picks it meanwhile, it is skipped and handed back to the
+  // replacer when UnpinFrame drops our pin.
+  int pin_count = 0;
+  if (!page->pin_count_.compare_exchange_strong(pin_count, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+    return false;
+  }
+  num_pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+
+  // The read latch keeps writers out while the page is copied to disk. Anyone modifying it later holds a pin and sets
+  // the dirty flag again when they unpin.
+  page->RLatch();
+  bool wal_allows = !enable_logging || log_manager_ == nullptr || page->GetLSN() <= log_manager_->GetPersistentLSN();
+  if (page->IsDirty() && wal_allows) {
+    page->is_dirty_.store(false, std::memory_order_release);
+    return true;
+  }
+  EndWriteBack(frame_id);
+  return false;
+}
+
+void BufferPoolManagerInstance::EndWriteBack(frame_id_t frame_id) {
+  pages_[frame_id].RUnlatch();
+  UnpinFrame(frame_id);
+}
+
+std::unique_lock<std::mutex> BufferPoolManagerInstance::LockLatch() {
+  std::unique_lock lock(latch_, std::try_to_lock);
+  // Only a wait is timed, so an uncontended latch costs no clock reads.
+  if (!lock.owns_lock()) {
+    auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    counters_.Add(PIN_WAITS);
+    counters_.Add(PIN_WAIT_NS, wait.count());
+  }
+  return lock;
+}
+
+BufferPoolStats BufferPoolManagerInstance::GetStats() {
+  BufferPoolStats stats;
+  stats.num_hits_ = counters_.Get(HITS);
+  stats.num_misses_ = counters_.Get(MISSES);
+  stats.num_prefetches_ = counters_.Get(PREFETCHES);
+  stats.num_evictions_ = counters_.Get(EVICTIONS);
+  stats.num_dirty_write_backs_ = counters_.Get(DIRTY_WRITE_BACKS);
+  stats.num_background_writes_ = counters_.Get(BACKGROUND_WRITES);
+  stats.num_pin_waits_ = counters_.Get(PIN_WAITS);
+  stats.pin_wait_ns_ = counters_.Get(PIN_WAIT_NS);
+  stats.num_pinned_frames_ = num_pinned_frames_.load(std::memory_order_relaxed);
+  stats.miss_latency_ = miss_latency_.GetSnapshot();
+  std::scoped_lock lock(latch_);
+  stats.free_list_length_ = free_list_.size();
+  return stats;
+}
+
+std::vector<page_id_t> BufferPoolManagerInstance::GetHotPages() {
+  // Page ids only change under latch_, and the only frames locked while we hold it are the free ones.
+  std::scoped_lock lock(latch_);
+  std::vector<frame_id_t> eviction_order = replacer_->GetEvictionOrder();
+  std::vector<bool> evictable(pool_size_, false);
+  for (frame_id_t frame_id : eviction_order) {
+    evictable[frame_id] = true;
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (!evictable[i] && pages_[i].pin_count_.load(std::memory_order_acquire) != Page::PIN_COUNT_LOCKED) {
+      page_ids.push_back(pages_[i].GetPageId());
+    }
+  }
+  for (auto it = eviction_order.rbegin(); it != eviction_order.rend(); ++it) {
+    page_ids.push_back(pages_[*it].GetPageId());
+  }
+  return page_ids;
+}
+
+size_t BufferPoolManagerInstance::WarmUp(const std::vector<page_id_t> &page_ids) {
+  std::unordered_set<page_id_t> seen;
+  std::vector<page_id_t> batch;
+  std::vector<std::pair<page_id_t, frame_id_t>> loads;
+  size_t num_loaded = 0;
+  size_t next = 0;
+  while (next < page_ids.size()) {
+    {
+      std::scoped_lock lock(latch_);
+      // Only free frames are filled: whatever requests brought in meanwhile is hotter than a list saved at shutdown.
+      if (free_list_.empty()) {
+        break;
+      }
+      // The hottest pages go first, as many at a time as there are free frames for, each batch read in page id order.
+      batch.clear();
+      const size_t batch_size = std::min(WARM_UP_BATCH_SIZE, free_list_.size());
+      for (; next < page_ids.size() && batch.size() < batch_size; next++) {
+        page_id_t page_id = page_ids[next];
+        frame_id_t frame_id;
+        if (page_id >= 0 && static_cast<uint32_t>(page_id) % num_instances_ == instance_index_ &&
+            seen.insert(page_id).second && !page_table_.Find(page_id, &frame_id) && reading_in_.count(page_id) == 0 &&
+            disk_manager_->IsPageAllocated(page_id)) {
+          batch.push_back(page_id);
+        }
+      }
+      std::sort(batch.begin(), batch.end());
+      // Frames on the free list are locked, so taking them off it is enough to keep them ours while the latch is
+      // released for the reads. Misses on these pages wait for the batch instead of reading them a second time.
+      loads.clear();
+      for (page_id_t page_id : batch) {
+        loads.emplace_back(page_id, free_list_.front());
+        free_list_.pop_front();
+        reading_in_.insert(page_id);
+      }
+    }
+
+    std::vector<bool> read_ok(loads.size(), true);
+    if (disk_scheduler_ == nullptr) {
+      for (size_t i = 0; i < loads.size(); i++) {
+        try {
+          disk_manager_->ReadPage(loads[i].first, pages_[loads[i].second].GetData());
+        } catch (Exception &) {
+          read_ok[i] = false;
+        }
+      }
+    } else {
+      for (size_t start = 0; start < loads.size(); start += disk_scheduler_->GetQueueDepth()) {
+        size_t end = std::min(loads.size(), start + disk_scheduler_->GetQueueDepth());
+        std::vector<DiskRequest> requests;
+        std::vector<std::future<bool>> done;
+        for (size_t i = start; i < end; i++) {
+          requests.push_back(
+              {false, pages_[loads[i].second].GetData(), loads[i].first, disk_scheduler_->CreatePromise()});
+          done.push_back(requests.back().callback_.get_future());
+        }
+        disk_scheduler_->Schedule(std::move(requests));
+        for (size_t i = start; i < end; i++) {
+          try {
+            done[i - start].get();
+          } catch (Exception &) {
+            read_ok[i] = false;
+          }
+        }
+      }
+    }
+
+    {
+      std::scoped_lock lock(latch_);
+      for (size_t i = 0; i < loads.size(); i++) {
+        auto [page_id, frame_id] = loads[i];
+        Page *page = &pages_[frame_id];
+        reading_in_.erase(page_id);
+        if (!read_ok[i]) {
+          // Warm-up is only a hint; the fetch that needs the page will report the corruption.
+          page->ResetMemory();
+          free_list_.push_back(frame_id);
+          continue;
+        }
+        page->page_id_.store(page_id, std::memory_order_relaxed);
+        page->is_dirty_.store(false, std::memory_order_relaxed);
+        page_table_.Insert(page_id, frame_id);
+        replacer_->AdmitPrefetched(frame_id, page_id);
+        page->pin_count_.store(0, std::memory_order_release);
+        num_loaded++;
+        counters_.Add(PREFETCHES);
+      }
+    }
+    read_in_cv_.notify_all();
+  }
+  return num_loaded;
+}
+
+void BufferPoolManagerInstance::AwaitReadIn(std::unique_lock<std::mutex> *lock, page_id_t page_id) {
+  read_in_cv_.wait(*lock, [&] { return reading_in_.count(page_id) == 0; });
+}
+
 }  // namespace bustub
@@ -0,0 +1,52 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace bustub {
+
+BufferPoolStats &BufferPoolStats::operator+=(const BufferPoolStats &other) {
+  num_hits_ += other.num_hits_;
+  num_misses_ += other.num_misses_;
+  num_prefetches_ += other.num_prefetches_;
+  num_evictions_ += other.num_evictions_;
+  num_dirty_write_backs_ += other.num_dirty_write_backs_;
+  num_background_writes_ += other.num_background_writes_;
+  num_pin_waits_ += other.num_pin_waits_;
+  pin_wait_ns_ += other.pin_wait_ns_;
+  free_list_length_ += other.free_list_length_;
+  num_pinned_frames_ += other.num_pinned_frames_;
+  miss_latency_ += other.miss_latency_;
+  return *this;
+}
+
+double BufferPoolStats::HitRatio() const {
+  uint64_t num_fetches = num_hits_ + num_misses_;
+  return num_fetches == 0 ? 0 : static_cast<double>(num_hits_) / static_cast<double>(num_fetches);
+}
+
+std::string BufferPoolStats::ToString() const {
+  char buf[512];
+  snprintf(buf, sizeof(buf),
+           "hits %" PRIu64 ", misses %" PRIu64 " (hit ratio %.3f), prefetches %" PRIu64 ", evictions %" PRIu64
+           " (%" PRIu64 " dirty), background writes %" PRIu64 ", pin waits %" PRIu64 " (%.3f ms), free frames %zu"
+           ", pinned frames %zu, miss latency: %s",
+           num_hits_, num_misses_, HitRatio(), num_prefetches_, num_evictions_, num_dirty_write_backs_,
+           num_background_writes_, num_pin_waits_, static_cast<double>(pin_wait_ns_) / 1e6, free_list_length_,
+           num_pinned_frames_, miss_latency_.ToString().c_str());
+  return buf;
+}
+
+}  // namespace bustub
@@ -14,16 +14,69 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : in_replacer_(num_pages, false), ref_bits_(num_pages, false) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock(latch_);
+  if (size_ == 0) {
+    return false;
+  }
+  // At most two sweeps: the first one clears every reference bit it passes.
+  while (true) {
+    if (in_replacer_[hand_]) {
+      if (!ref_bits_[hand_]) {
+        *frame_id = static_cast<frame_id_t>(hand_);
+        in_replacer_[hand_] = false;
+        size_--;
+        hand_ = (hand_ + 1) % in_replacer_.size();
+        return true;
+      }
+      ref_bits_[hand_] = false;
+    }
+    hand_ = (hand_ + 1) % in_replacer_.size();
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  if (!in_replacer_[frame_id]) {
+    return;
+  }
+  in_replacer_[frame_id] = false;
+  size_--;
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  if (in_replacer_[frame_id]) {
+    return;
+  }
+  in_replacer_[frame_id] = true;
+  ref_bits_[frame_id] = true;
+  size_++;
+}
 
-size_t ClockReplacer::Size() { return 0; }
+size_t ClockReplacer::Size() {
+  std::scoped_lock lock(latch_);
+  return size_;
+}
+
+std::vector<frame_id_t> ClockReplacer::GetEvictionOrder() {
+  std::scoped_lock lock(latch_);
+  // The hand takes the frames whose reference bit is clear on its first sweep, and the rest on its second.
+  std::vector<frame_id_t> order;
+  order.reserve(size_);
+  for (bool referenced : {false, true}) {
+    for (size_t i = 0; i < in_replacer_.size(); i++) {
+      size_t frame = (hand_ + i) % in_replacer_.size();
+      if (in_replacer_[frame] && ref_bits_[frame] == referenced) {
+        order.push_back(static_cast<frame_id_t>(frame));
+      }
+    }
+  }
+  return order;
+}
 
 }  // namespace bustub
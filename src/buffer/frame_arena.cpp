@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, bool use_huge_pages)
+    : num_frames_(num_frames), backing_(Backing::REGULAR_PAGES) {
+  size_t data_size = std::max<size_t>(num_frames, 1) * PAGE_SIZE;
+  // Below one huge page there is nothing to gain from huge pages, and a reserved huge page would be mostly wasted.
+  bool want_huge_pages = use_huge_pages && data_size >= HUGE_PAGE_SIZE;
+
+#ifdef MAP_HUGETLB
+  if (want_huge_pages) {
+    size_t huge_size = (data_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *mapping = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mapping != MAP_FAILED) {
+      mapping_ = mapping;
+      mapping_size_ = huge_size;
+      data_ = static_cast<char *>(mapping);
+      backing_ = Backing::HUGETLB;
+      return;
+    }
+  }
+#endif
+
+  // Regular pages. mmap only aligns to the OS page size, which may be smaller than PAGE_SIZE, so map enough to align
+  // the data by hand.
+  size_t alignment = want_huge_pages ? HUGE_PAGE_SIZE : PAGE_SIZE;
+  auto os_page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  mapping_size_ = data_size + (alignment > os_page_size ? alignment : 0);
+  void *mapping = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "FrameArena: cannot map frame data");
+  }
+  mapping_ = mapping;
+  auto start = reinterpret_cast<uintptr_t>(mapping);
+  data_ = reinterpret_cast<char *>((start + alignment - 1) / alignment * alignment);
+#ifdef MADV_HUGEPAGE
+  if (want_huge_pages && madvise(data_, data_size, MADV_HUGEPAGE) == 0) {
+    backing_ = Backing::TRANSPARENT_HUGE_PAGES;
+  }
+#endif
+}
+
+FrameArena::~FrameArena() {
+  if (mapping_ != nullptr && munmap(mapping_, mapping_size_) != 0) {
+    LOG_WARN("FrameArena: munmap failed");
+  }
+}
+
+}  // namespace bustub
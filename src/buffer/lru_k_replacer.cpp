@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_reference_period)
+    : k_(k), correlated_reference_period_(correlated_reference_period) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to track at least one reference");
+  frames_.reserve(num_pages);
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock(latch_);
+  // Prefer frames outside their correlated reference period; fall back to the plain LRU-K order otherwise.
+  EvictionQueue::iterator victim;
+  EvictionQueue *queue = nullptr;
+  for (EvictionQueue *candidates : {&infinite_distance_, &k_distance_}) {
+    for (auto it = candidates->begin(); it != candidates->end(); ++it) {
+      if (!InCorrelatedPeriod(frames_[it->second])) {
+        victim = it;
+        queue = candidates;
+        break;
+      }
+    }
+    if (queue != nullptr) {
+      break;
+    }
+  }
+  if (queue == nullptr) {
+    queue = infinite_distance_.empty() ? &k_distance_ : &infinite_distance_;
+    if (queue->empty()) {
+      return false;
+    }
+    victim = queue->begin();
+  }
+
+  *frame_id = victim->second;
+  queue->erase(victim);
+  frames_.erase(*frame_id);
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    auto [queue, key] = QueueOf(frame);
+    queue->erase({key, frame_id});
+    frame.evictable_ = false;
+  }
+  if (frame.prefetched_) {
+    frame.prefetched_ = false;
+    frame.history_.clear();
+  }
+  RecordReference(frame_id, &frame);
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    return;
+  }
+  // A frame that was never pinned through us still needs a reference to be ordered by.
+  if (frame.history_.empty()) {
+    RecordReference(frame_id, &frame);
+  }
+  frame.evictable_ = true;
+  auto [queue, key] = QueueOf(frame);
+  queue->emplace(key, frame_id);
+}
+
+void LRUKReplacer::AdmitPrefetched(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    return;
+  }
+  // Order the frame by the time it was read in, so unused read-ahead ages out like a page referenced once.
+  frame.history_.clear();
+  RecordReference(frame_id, &frame);
+  frame.prefetched_ = true;
+  frame.evictable_ = true;
+  auto [queue, key] = QueueOf(frame);
+  queue->emplace(key, frame_id);
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  auto it = frames_.find(frame_id);
+  if (it == frames_.end()) {
+    return;
+  }
+  if (it->second.evictable_) {
+    auto [queue, key] = QueueOf(it->second);
+    queue->erase({key, frame_id});
+  }
+  frames_.erase(it);
+}
+
+size_t LRUKReplacer::Size() {
+  std::scoped_lock lock(latch_);
+  return infinite_distance_.size() + k_distance_.size();
+}
+
+std::vector<frame_id_t> LRUKReplacer::GetEvictionOrder() {
+  std::scoped_lock lock(latch_);
+  // Frames inside their correlated reference period are listed in queue order too; they only delay their eviction.
+  std::vector<frame_id_t> order;
+  order.reserve(infinite_distance_.size() + k_distance_.size());
+  for (const EvictionQueue *queue : {&infinite_distance_, &k_distance_}) {
+    for (const auto &entry : *queue) {
+      order.push_back(entry.second);
+    }
+  }
+  return order;
+}
+
+void LRUKReplacer::RecordReference(frame_id_t frame_id, FrameHistory *frame) {
+  timestamp_t now = ++current_timestamp_;
+  bool correlated = !frame->history_.empty() && InCorrelatedPeriod(*frame);
+  frame->last_reference_ = now;
+  if (correlated) {
+    return;
+  }
+  frame->history_.push_back(now);
+  if (frame->history_.size() > k_) {
+    frame->history_.pop_front();
+  }
+}
+
+std::pair<LRUKReplacer::EvictionQueue *, LRUKReplacer::timestamp_t> LRUKReplacer::QueueOf(const FrameHistory &frame) {
+  // With fewer than k references the front is the first reference, otherwise it is the k-th most recent one.
+  if (frame.history_.size() < k_) {
+    return {&infinite_distance_, frame.history_.front()};
+  }
+  return {&k_distance_, frame.history_.front()};
+}
+
+bool LRUKReplacer::InCorrelatedPeriod(const FrameHistory &frame) const {
+  return current_timestamp_ - frame.last_reference_ < correlated_reference_period_;
+}
+
+}  // namespace bustub
@@ -14,16 +14,48 @@
 
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages) : num_pages_(num_pages) { lru_map_.reserve(num_pages); }
 
 LRUReplacer::~LRUReplacer() = default;
 
-bool LRUReplacer::Victim(frame_id_t *frame_id) { return false; }
-
-void LRUReplacer::Pin(frame_id_t frame_id) {}
-
-void LRUReplacer::Unpin(frame_id_t frame_id) {}
-
-size_t LRUReplacer::Size() { return 0; }
+bool LRUReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock(latch_);
+  if (lru_list_.empty()) {
+    return false;
+  }
+  *frame_id = lru_list_.front();
+  lru_map_.erase(*frame_id);
+  lru_list_.pop_front();
+  return true;
+}
+
+void LRUReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  auto it = lru_map_.find(frame_id);
+  if (it == lru_map_.end()) {
+    return;
+  }
+  lru_list_.erase(it->second);
+  lru_map_.erase(it);
+}
+
+void LRUReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  // Unpinning a frame that is already tracked does not refresh its position.
+  if (lru_map_.count(frame_id) != 0 || lru_list_.size() >= num_pages_) {
+    return;
+  }
+  lru_map_.emplace(frame_id, lru_list_.insert(lru_list_.end(), frame_id));
+}
+
+size_t LRUReplacer::Size() {
+  std::scoped_lock lock(latch_);
+  return lru_list_.size();
+}
+
+std::vector<frame_id_t> LRUReplacer::GetEvictionOrder() {
+  std::scoped_lock lock(latch_);
+  return {lru_list_.begin(), lru_list_.end()};
+}
 
 }  // namespace bustub
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_frames) {
+  // Keep the load factor at or below 1/2 so probe sequences stay short.
+  capacity_ = 2;
+  shift_ = 63;
+  while (capacity_ < 2 * num_frames) {
+    capacity_ <<= 1;
+    shift_--;
+  }
+  mask_ = capacity_ - 1;
+  slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity_);
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+}
+
+bool PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const {
+  size_t idx = HomeSlot(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++, idx = (idx + 1) & mask_) {
+    uint64_t slot = slots_[idx].load(std::memory_order_acquire);
+    if (slot == EMPTY_SLOT) {
+      return false;
+    }
+    if (slot != TOMBSTONE_SLOT && SlotPageId(slot) == page_id) {
+      *frame_id = SlotFrameId(slot);
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  size_t idx = HomeSlot(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++, idx = (idx + 1) & mask_) {
+    uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    // Keys are unique and writers are serialized, so the first reusable slot on the probe path is safe to take.
+    if (slot == EMPTY_SLOT || slot == TOMBSTONE_SLOT) {
+      slots_[idx].store(Pack(page_id, frame_id), std::memory_order_release);
+      return;
+    }
+    BUSTUB_ASSERT(SlotPageId(slot) != page_id, "page is already mapped");
+  }
+  UNREACHABLE("page table is full");
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+  size_t idx = HomeSlot(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++, idx = (idx + 1) & mask_) {
+    uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) {
+      return false;
+    }
+    if (slot == TOMBSTONE_SLOT || SlotPageId(slot) != page_id) {
+      continue;
+    }
+    // If the next slot is empty no probe sequence runs through this one, so it (and any tombstones directly before
+    // it) can go back to empty instead of lengthening future probes.
+    if (slots_[(idx + 1) & mask_].load(std::memory_order_relaxed) != EMPTY_SLOT) {
+      slots_[idx].store(TOMBSTONE_SLOT, std::memory_order_release);
+      return true;
+    }
+    slots_[idx].store(EMPTY_SLOT, std::memory_order_release);
+    for (size_t prev = (idx - 1) & mask_; slots_[prev].load(std::memory_order_relaxed) == TOMBSTONE_SLOT;
+         prev = (prev - 1) & mask_) {
+      slots_[prev].store(EMPTY_SLOT, std::memory_order_release);
+    }
+    return true;
+  }
+  return false;
+}
+
+}  // namespace bustub
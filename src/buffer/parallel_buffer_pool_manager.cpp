@@ -12,58 +12,173 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <algorithm>
+#include <functional>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager) {
-  // Allocate and create individual BufferPoolManagerInstances
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t replacer_k) {
+  BUSTUB_ASSERT(num_instances > 0, "A parallel buffer pool needs at least one instance");
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.push_back(new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager,
+                                                       replacer_type, replacer_k));
+  }
 }
 
-// Update constructor to destruct all BufferPoolManagerInstances and deallocate any associated memory
-ParallelBufferPoolManager::~ParallelBufferPoolManager() = default;
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // Warm-up and read-ahead forward to the instances, so they must be done before the instances are gone.
+  ShutDownWarmUp();
+  StopPrefetchWorker();
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
 
 size_t ParallelBufferPoolManager::GetPoolSize() {
-  // Get size of all BufferPoolManagerInstances
-  return 0;
+  size_t pool_size = 0;
+  for (auto *instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto *instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
 }
 
 BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
-  // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
-  return nullptr;
+  // Instance i allocates exactly the page ids that are i modulo the number of instances.
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
 }
 
 Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) {
-  // Fetch page for page_id from responsible BufferPoolManagerInstance
-  return nullptr;
+  return GetBufferPoolManager(page_id)->FetchPgImp(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetBufferPoolManager(page_id)->FetchPgWithStrategyImp(page_id, strategy);
 }
 
 bool ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) {
-  // Unpin page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->UnpinPgImp(page_id, is_dirty);
 }
 
 bool ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) {
-  // Flush page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->FlushPgImp(page_id);
 }
 
-Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
-  // create new page. We will request page allocation in a round robin manner from the underlying
-  // BufferPoolManagerInstances
-  // 1.   From a starting index of the BPMIs, call NewPageImpl until either 1) success and return 2) looped around to
-  // starting index and return nullptr
-  // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
-  // is called
+size_t ParallelBufferPoolManager::GetHomeInstanceIndex() const {
+  // Threads are numbered in the order they first ask, which spreads them evenly over the instances.
+  static std::atomic<size_t> next_thread_number{0};
+  thread_local size_t thread_number = next_thread_number.fetch_add(1, std::memory_order_relaxed);
+  return thread_number % instances_.size();
+}
+
+Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) { return NewPgNearImp(page_id, INVALID_PAGE_ID); }
+
+Page *ParallelBufferPoolManager::NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) {
+  size_t num_instances = instances_.size();
+  size_t preferred;
+  if (near_page_id != INVALID_PAGE_ID) {
+    preferred = (near_page_id + 1) % num_instances;
+  } else if (thread_affinity_.load(std::memory_order_relaxed)) {
+    preferred = GetHomeInstanceIndex();
+  } else {
+    preferred = next_instance_.fetch_add(1, std::memory_order_relaxed) % num_instances;
+  }
+  if (instances_[preferred]->GetNumUnpinnedFrames() > 0) {
+    BufferPoolManager *instance = instances_[preferred];
+    Page *page = instance->NewPgNearImp(page_id, near_page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+
+  // The preferred instance is full. Try the others, most unpinned frames first, and skip those with none instead of
+  // queueing up on their latches.
+  std::vector<std::pair<size_t, size_t>> candidates;
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t num_unpinned = instances_[i]->GetNumUnpinnedFrames();
+    if (i != preferred && num_unpinned > 0) {
+      candidates.emplace_back(num_unpinned, i);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), std::greater<>());
+  for (const auto &candidate : candidates) {
+    BufferPoolManager *instance = instances_[candidate.second];
+    Page *page = instance->NewPgNearImp(page_id, near_page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
   return nullptr;
 }
 
 bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
-  // Delete page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->DeletePgImp(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() { BufferPoolManagerInstance::FlushInstances(instances_); }
+
+bool ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id, next_page_id_fn next_page_id, page_id_t *next,
+                                              BufferAccessStrategy *strategy) {
+  return GetBufferPoolManager(page_id)->PrefetchPgImp(page_id, next_page_id, next, strategy);
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetHotPages() {
+  std::vector<std::vector<page_id_t>> instance_pages;
+  size_t num_pages = 0;
+  for (auto *instance : instances_) {
+    instance_pages.push_back(instance->GetHotPages());
+    num_pages += instance_pages.back().size();
+  }
+  std::vector<page_id_t> page_ids;
+  page_ids.reserve(num_pages);
+  for (size_t rank = 0; page_ids.size() < num_pages; rank++) {
+    for (const auto &pages : instance_pages) {
+      if (rank < pages.size()) {
+        page_ids.push_back(pages[rank]);
+      }
+    }
+  }
+  return page_ids;
 }
 
-void ParallelBufferPoolManager::FlushAllPgsImp() {
-  // flush all pages from all BufferPoolManagerInstances
+size_t ParallelBufferPoolManager::WarmUp(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> instance_pages(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    if (page_id >= 0) {
+      instance_pages[page_id % instances_.size()].push_back(page_id);
+    }
+  }
+  // Every instance has its own latch, so they can all read at once.
+  std::vector<size_t> num_loaded(instances_.size(), 0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!instance_pages[i].empty()) {
+      threads.emplace_back([&, i] { num_loaded[i] = instances_[i]->WarmUp(instance_pages[i]); });
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  size_t total = 0;
+  for (size_t n : num_loaded) {
+    total += n;
+  }
+  return total;
 }
 
 }  // namespace bustub
@@ -0,0 +1,165 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch.cpp
+//
+// Identification: src/common/rwlatch.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/rwlatch.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <climits>
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "the futex syscall works on the plain word of an atomic");
+
+/** Tells the core that the thread is spinning, to save power and let a sibling hyperthread run. */
+static inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+void ReaderWriterLatch::Wait(std::atomic<uint32_t> *word, uint32_t value, int round) {
+  if (round < SPIN_LIMIT) {
+    CpuRelax();
+    return;
+  }
+#ifdef __linux__
+  // Returns right away if the word no longer holds value, so a wakeup between the caller's check and here is not lost.
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+#else
+  std::this_thread::yield();
+#endif
+}
+
+void ReaderWriterLatch::WakeAll(std::atomic<uint32_t> *word) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+void ReaderWriterLatch::WLockSlow() {
+  // Enter ahead of the other writers first, which also keeps new readers out, then wait for the readers to leave.
+  for (int round = 0;; round++) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & WRITER) == 0) {
+      if (state_.compare_exchange_weak(state, state | WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+        break;
+      }
+      continue;
+    }
+    WaitForChange(state, round);
+  }
+  for (int round = 0;; round++) {
+    uint32_t state = state_.load(std::memory_order_acquire);
+    if ((state & READER_MASK) == 0) {
+      return;
+    }
+    WaitForChange(state, round);
+  }
+}
+
+void ReaderWriterLatch::RLockSlow() {
+  for (int round = 0;; round++) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & WRITER) == 0) {
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    WaitForChange(state, round);
+  }
+}
+
+void ReaderWriterLatch::WaitForChange(uint32_t state, int round) {
+  if (round >= SPIN_LIMIT && (state & WAITERS) == 0) {
+    // Whoever changes the word next sees the flag and wakes us. If the word changed already, look at it again.
+    if (!state_.compare_exchange_strong(state, state | WAITERS, std::memory_order_relaxed)) {
+      return;
+    }
+    state |= WAITERS;
+  }
+  Wait(&state_, state, round);
+}
+
+void ShardedReaderWriterLatch::WLock() {
+  writer_latch_.WLock();
+  writer_.store(WRITER_IN);
+  for (int round = 0;; round++) {
+    if (round == ReaderWriterLatch::SPIN_LIMIT) {
+      // From now on, readers leaving wake us.
+      writer_.fetch_or(WRITER_PARKED);
+    }
+    // Taken before the readers are counted, so a reader leaving after the count changes it and the wait returns.
+    uint32_t epoch = drain_epoch_.load();
+    if (NumReaders() == 0) {
+      return;
+    }
+    ReaderWriterLatch::Wait(&drain_epoch_, epoch, round);
+  }
+}
+
+void ShardedReaderWriterLatch::WUnlock() {
+  if ((writer_.exchange(0) & READERS_PARKED) != 0) {
+    ReaderWriterLatch::WakeAll(&writer_);
+  }
+  writer_latch_.WUnlock();
+}
+
+void ShardedReaderWriterLatch::RLockSlow(std::atomic<uint32_t> *readers) {
+  do {
+    // A writer is in or on its way in: back out, so that it does not wait for us, until it has left.
+    readers->fetch_sub(1);
+    if ((writer_.load() & WRITER_PARKED) != 0) {
+      NotifyWriter();
+    }
+    for (int round = 0;; round++) {
+      uint32_t writer = writer_.load();
+      if (writer == 0) {
+        break;
+      }
+      if (round >= ReaderWriterLatch::SPIN_LIMIT && (writer & READERS_PARKED) == 0) {
+        // WUnlock sees the flag and wakes us. If the word changed already, look at it again.
+        if (!writer_.compare_exchange_strong(writer, writer | READERS_PARKED)) {
+          continue;
+        }
+        writer |= READERS_PARKED;
+      }
+      ReaderWriterLatch::Wait(&writer_, writer, round);
+    }
+    readers->fetch_add(1);
+  } while (writer_.load() != 0);
+}
+
+void ShardedReaderWriterLatch::NotifyWriter() {
+  drain_epoch_.fetch_add(1);
+  ReaderWriterLatch::WakeAll(&drain_epoch_);
+}
+
+uint32_t ShardedReaderWriterLatch::NumReaders() const {
+  // Wraps around correctly when a read latch was taken on one shard and released on another.
+  uint32_t num_readers = 0;
+  for (const Shard &shard : shards_) {
+    num_readers += shard.readers_.load();
+  }
+  return num_readers;
+}
+
+}  // namespace bustub
@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.cpp
+//
+// Identification: src/common/util/crc32c.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** The CRC-32C polynomial, bit-reversed. */
+constexpr uint32_t POLY = 0x82f63b78;
+
+/** Table for the byte-at-a-time software version. */
+std::array<uint32_t, 256> MakeByteTable() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t n = 0; n < 256; n++) {
+    uint32_t crc = n;
+    for (int k = 0; k < 8; k++) {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ POLY : crc >> 1;
+    }
+    table[n] = crc;
+  }
+  return table;
+}
+
+const std::array<uint32_t, 256> BYTE_TABLE = MakeByteTable();
+
+#if defined(__x86_64__)
+
+/** Lengths of the three interleaved streams of the hardware version. Both must be powers of two. */
+constexpr size_t LONG_BLOCK = 1024;
+constexpr size_t SHORT_BLOCK = 256;
+
+/*
+ * Combining the interleaved streams needs the CRC of a stream shifted over the bytes of the streams after it, i.e.
+ * multiplied by x^(8 * length) modulo the polynomial. That multiplication is linear over GF(2), so it is done with a
+ * 32x32 bit matrix, applied a byte at a time through four lookup tables. This follows Mark Adler's crc32c.c.
+ */
+
+uint32_t Gf2MatrixTimes(const uint32_t *matrix, uint32_t vector) {
+  uint32_t sum = 0;
+  for (; vector != 0; vector >>= 1, matrix++) {
+    if ((vector & 1) != 0) {
+      sum ^= *matrix;
+    }
+  }
+  return sum;
+}
+
+void Gf2MatrixSquare(uint32_t *square, const uint32_t *matrix) {
+  for (int n = 0; n < 32; n++) {
+    square[n] = Gf2MatrixTimes(matrix, matrix[n]);
+  }
+}
+
+/** Builds the operator that shifts a CRC over length zero bytes. length must be a power of two. */
+void ZerosOperator(uint32_t *even, size_t length) {
+  uint32_t odd[32];
+  // the operator for one zero bit
+  odd[0] = POLY;
+  uint32_t row = 1;
+  for (int n = 1; n < 32; n++) {
+    odd[n] = row;
+    row <<= 1;
+  }
+  // two, then four zero bits
+  Gf2MatrixSquare(even, odd);
+  Gf2MatrixSquare(odd, even);
+  // Each square doubles the number of zero bits: even holds one zero byte after the first square below.
+  while (true) {
+    Gf2MatrixSquare(even, odd);
+    length >>= 1;
+    if (length == 0) {
+      return;
+    }
+    Gf2MatrixSquare(odd, even);
+    length >>= 1;
+    if (length == 0) {
+      memcpy(even, odd, sizeof(odd));
+      return;
+    }
+  }
+}
+
+using ShiftTable = std::array<std::array<uint32_t, 256>, 4>;
+
+ShiftTable MakeShiftTable(size_t length) {
+  uint32_t op[32];
+  ZerosOperator(op, length);
+  ShiftTable table;
+  for (uint32_t n = 0; n < 256; n++) {
+    table[0][n] = Gf2MatrixTimes(op, n);
+    table[1][n] = Gf2MatrixTimes(op, n << 8);
+    table[2][n] = Gf2MatrixTimes(op, n << 16);
+    table[3][n] = Gf2MatrixTimes(op, n << 24);
+  }
+  return table;
+}
+
+uint32_t Shift(const ShiftTable &table, uint32_t crc) {
+  return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^ table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+
+const ShiftTable LONG_SHIFT = MakeShiftTable(LONG_BLOCK);
+const ShiftTable SHORT_SHIFT = MakeShiftTable(SHORT_BLOCK);
+
+// Runs before main, so the CPU model has to be initialized by hand.
+const bool HAS_SSE42 = [] {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2") != 0;
+}();
+
+uint64_t LoadWord(const char *data) {
+  uint64_t word;
+  memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+/** Checksums three consecutive blocks of block bytes at once and folds them into crc. */
+__attribute__((target("sse4.2"))) uint64_t HardwareBlocks(const char **data, size_t *length, uint64_t crc,
+                                                          size_t block, const ShiftTable &shift) {
+  while (*length >= 3 * block) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    const char *next = *data;
+    const char *end = next + block;
+    // The three crc32 chains are independent, so their latencies overlap.
+    for (; next < end; next += sizeof(uint64_t)) {
+      crc = _mm_crc32_u64(crc, LoadWord(next));
+      crc1 = _mm_crc32_u64(crc1, LoadWord(next + block));
+      crc2 = _mm_crc32_u64(crc2, LoadWord(next + 2 * block));
+    }
+    crc = Shift(shift, static_cast<uint32_t>(crc)) ^ crc1;
+    crc = Shift(shift, static_cast<uint32_t>(crc)) ^ crc2;
+    *data += 3 * block;
+    *length -= 3 * block;
+  }
+  return crc;
+}
+
+__attribute__((target("sse4.2"))) uint32_t ComputeHardware(const char *data, size_t length, uint32_t crc) {
+  uint64_t crc64 = ~crc;
+  crc64 = HardwareBlocks(&data, &length, crc64, LONG_BLOCK, LONG_SHIFT);
+  crc64 = HardwareBlocks(&data, &length, crc64, SHORT_BLOCK, SHORT_SHIFT);
+  for (; length >= sizeof(uint64_t); data += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+    crc64 = _mm_crc32_u64(crc64, LoadWord(data));
+  }
+  auto crc32 = static_cast<uint32_t>(crc64);
+  for (; length > 0; data++, length--) {
+    crc32 = _mm_crc32_u8(crc32, static_cast<uint8_t>(*data));
+  }
+  return ~crc32;
+}
+
+#endif
+
+}  // namespace
+
+uint32_t Crc32c::Compute(const char *data, size_t length, uint32_t crc) {
+#if defined(__x86_64__)
+  if (HAS_SSE42) {
+    return ComputeHardware(data, length, crc);
+  }
+#endif
+  return ComputeSoftware(data, length, crc);
+}
+
+uint32_t Crc32c::ComputeSoftware(const char *data, size_t length, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = BYTE_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+bool Crc32c::IsHardwareAccelerated() {
+#if defined(__x86_64__)
+  return HAS_SSE42;
+#else
+  return false;
+#endif
+}
+
+}  // namespace bustub
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// latency_histogram.cpp
+//
+// Identification: src/common/util/latency_histogram.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/latency_histogram.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+namespace bustub {
+
+void LatencyHistogram::Record(std::chrono::nanoseconds duration) {
+  auto ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+  // floor(log2(ns)), with 0 and 1 both in bucket 0
+  size_t bucket = 63 - __builtin_clzll(ns | 1);
+  counters_.Add(std::min(bucket, NUM_BUCKETS - 1));
+  counters_.Add(NUM_BUCKETS, ns);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const {
+  Snapshot snapshot;
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    snapshot.counts_[i] = counters_.Get(i);
+    snapshot.count_ += snapshot.counts_[i];
+  }
+  snapshot.total_ns_ = counters_.Get(NUM_BUCKETS);
+  return snapshot;
+}
+
+uint64_t LatencyHistogram::BucketLimitNanos(size_t bucket) {
+  return bucket + 1 >= NUM_BUCKETS ? UINT64_MAX : uint64_t{2} << bucket;
+}
+
+LatencyHistogram::Snapshot &LatencyHistogram::Snapshot::operator+=(const Snapshot &other) {
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  total_ns_ += other.total_ns_;
+  return *this;
+}
+
+double LatencyHistogram::Snapshot::MeanNanos() const {
+  return count_ == 0 ? 0 : static_cast<double>(total_ns_) / static_cast<double>(count_);
+}
+
+uint64_t LatencyHistogram::Snapshot::PercentileNanos(double fraction) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  // The rank of the percentile among the durations recorded, counting from 1.
+  auto rank = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count_)));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return BucketLimitNanos(i);
+    }
+  }
+  return BucketLimitNanos(NUM_BUCKETS - 1);
+}
+
+std::string LatencyHistogram::Snapshot::ToString() const {
+  char buf[160];
+  snprintf(buf, sizeof(buf), "count %" PRIu64 ", mean %.0f ns, p50 < %" PRIu64 " ns, p99 < %" PRIu64
+           " ns, p99.9 < %" PRIu64 " ns", count_, MeanNanos(), PercentileNanos(0.5), PercentileNanos(0.99),
+           PercentileNanos(0.999));
+  return buf;
+}
+
+}  // namespace bustub
@@ -10,8 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <array>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -22,11 +26,63 @@
 
 namespace bustub {
 
+namespace {
+
+/** Holds the table latch, shared or exclusive, until the end of the scope, so that exceptions release it too. */
+class TableLatchGuard {
+ public:
+  TableLatchGuard(ShardedReaderWriterLatch *latch, bool exclusive) : latch_(latch), exclusive_(exclusive) {
+    if (exclusive_) {
+      latch_->WLock();
+    } else {
+      latch_->RLock();
+    }
+  }
+
+  ~TableLatchGuard() {
+    if (exclusive_) {
+      latch_->WUnlock();
+    } else {
+      latch_->RUnlock();
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(TableLatchGuard);
+
+ private:
+  ShardedReaderWriterLatch *latch_;
+  bool exclusive_;
+};
+
+}  // namespace
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                      const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
+  // The table starts out with a header, a single directory page and a single bucket, at global depth 0.
+  std::array<page_id_t, 3> page_ids;
+  std::array<BasicPageGuard, 3> guards;
+  for (size_t i = 0; i < guards.size(); i++) {
+    guards[i] = buffer_pool_manager_->NewPageGuarded(&page_ids[i]);
+    if (!guards[i].IsValid()) {
+      for (size_t j = 0; j < i; j++) {
+        guards[j].Drop();
+        buffer_pool_manager_->DeletePage(page_ids[j]);
+      }
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left to create the hash table");
+    }
+  }
+  header_page_id_ = page_ids[0];
+  auto *header_page = guards[0].AsMut<ExtendibleHashTableHeaderPage>();
+  header_page->SetPageId(header_page_id_);
+  header_page->SetDirectoryPageId(0, page_ids[1]);
+  auto *dir_page = guards[1].AsMut<HashTableDirectoryPage>();
+  dir_page->SetPageId(page_ids[1]);
+  dir_page->SetBucketPageId(0, page_ids[2]);
+  dir_page->SetLocalDepth(0, 0);
+  // An empty bucket is all zeros, as the new page already is, but it has to be written all the same.
+  guards[2].AsMut<HASH_TABLE_BUCKET_TYPE>();
 }
 
 /*****************************************************************************
@@ -45,23 +101,103 @@ uint32_t HASH_TABLE_TYPE::Hash(KeyType key) {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) {
-  return 0;
+uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, const ExtendibleHashTableHeaderPage *header_page) {
+  return Hash(key) & header_page->GetGlobalDepthMask();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-page_id_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) {
-  return 0;
+BasicPageGuard HASH_TABLE_TYPE::FetchHeaderPage() {
+  return {buffer_pool_manager_, FetchHashTablePage(header_page_id_)};
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
-  return nullptr;
+Page *HASH_TABLE_TYPE::FetchDirectoryPage(const ExtendibleHashTableHeaderPage *header_page, uint32_t bucket_idx) {
+  return FetchHashTablePage(GetDirectoryPageId(header_page, ExtendibleHashTableHeaderPage::DirectoryIndex(bucket_idx)));
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
-  return nullptr;
+page_id_t HASH_TABLE_TYPE::GetDirectoryPageId(const ExtendibleHashTableHeaderPage *header_page,
+                                              uint32_t directory_idx) {
+  if (header_page->NumDirectoryPages() <= HEADER_ARRAY_SIZE) {
+    return header_page->GetDirectoryPageId(directory_idx);
+  }
+  BasicPageGuard index_guard(buffer_pool_manager_,
+                             FetchHashTablePage(header_page->GetDirectoryPageId(directory_idx / HEADER_ARRAY_SIZE)));
+  return index_guard.As<ExtendibleHashTableHeaderPage>()->GetDirectoryPageId(directory_idx % HEADER_ARRAY_SIZE);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *HASH_TABLE_TYPE::FetchHashTablePage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left for a hash table page");
+  }
+  return page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t HASH_TABLE_TYPE::LookUpBucketPageId(uint32_t bucket_idx, Page *dir_page) {
+  // Every operation looks the directory up, so it is read optimistically rather than under its read latch, whose
+  // cache line all threads would write to.
+  auto *directory = reinterpret_cast<HashTableDirectoryPage *>(dir_page->GetData());
+  uint32_t slot = ExtendibleHashTableHeaderPage::DirectorySlot(bucket_idx);
+  uint64_t version;
+  if (dir_page->TryOptimisticRead(&version)) {
+    page_id_t bucket_page_id = directory->GetBucketPageId(slot);
+    if (dir_page->ValidateOptimisticRead(version)) {
+      return bucket_page_id;
+    }
+  }
+  dir_page->RLatch();
+  page_id_t bucket_page_id = directory->GetBucketPageId(slot);
+  dir_page->RUnlatch();
+  return bucket_page_id;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename BucketGuard>
+BucketGuard HASH_TABLE_TYPE::LatchBucketPage(uint32_t bucket_idx, Page *dir_page) {
+  while (true) {
+    page_id_t bucket_page_id = LookUpBucketPageId(bucket_idx, dir_page);
+    BasicPageGuard guard(buffer_pool_manager_, FetchHashTablePage(bucket_page_id));
+    BucketGuard bucket_guard;
+    if constexpr (std::is_same_v<BucketGuard, WritePageGuard>) {
+      bucket_guard = guard.UpgradeWrite();
+    } else {
+      bucket_guard = guard.UpgradeRead();
+    }
+    // Splits write to the directory while they hold the bucket's write latch, so once the bucket is latched, the
+    // entries that point to it stay put. Bucket pages are only deleted under the exclusive table latch, so the page
+    // id cannot have been reused for another page meanwhile.
+    if (LookUpBucketPageId(bucket_idx, dir_page) == bucket_page_id) {
+      return bucket_guard;
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename EntryFn>
+void HASH_TABLE_TYPE::ForEachDirectoryEntry(const ExtendibleHashTableHeaderPage *header_page, uint32_t first,
+                                            uint32_t stride, bool write, EntryFn &&fn) {
+  uint32_t size = header_page->Size();
+  uint32_t bucket_idx = first;
+  while (bucket_idx < size) {
+    uint32_t directory_idx = ExtendibleHashTableHeaderPage::DirectoryIndex(bucket_idx);
+    Page *dir_page = FetchDirectoryPage(header_page, bucket_idx);
+    BasicPageGuard guard(buffer_pool_manager_, dir_page);
+    auto *directory = reinterpret_cast<HashTableDirectoryPage *>(write ? guard.GetDataMut() : dir_page->GetData());
+    ReadPageGuard read_guard;
+    WritePageGuard write_guard;
+    if (write) {
+      write_guard = guard.UpgradeWrite();
+    } else {
+      read_guard = guard.UpgradeRead();
+    }
+    for (; bucket_idx < size && ExtendibleHashTableHeaderPage::DirectoryIndex(bucket_idx) == directory_idx;
+         bucket_idx += stride) {
+      fn(directory, ExtendibleHashTableHeaderPage::DirectorySlot(bucket_idx), bucket_idx);
+    }
+  }
 }
 
 /*****************************************************************************
@@ -69,7 +205,13 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+  TableLatchGuard table_guard(&table_latch_, false);
+  BasicPageGuard header_guard = FetchHeaderPage();
+  uint32_t bucket_idx = KeyToDirectoryIndex(key, header_guard.As<ExtendibleHashTableHeaderPage>());
+  Page *dir_page = FetchDirectoryPage(header_guard.As<ExtendibleHashTableHeaderPage>(), bucket_idx);
+  BasicPageGuard dir_guard(buffer_pool_manager_, dir_page);
+  ReadPageGuard bucket_guard = LatchBucketPage<ReadPageGuard>(bucket_idx, dir_page);
+  return bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetValue(key, comparator_, result);
 }
 
 /*****************************************************************************
@@ -77,12 +219,189 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  {
+    TableLatchGuard table_guard(&table_latch_, false);
+    BasicPageGuard header_guard = FetchHeaderPage();
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, header_guard.As<ExtendibleHashTableHeaderPage>());
+    Page *dir_page = FetchDirectoryPage(header_guard.As<ExtendibleHashTableHeaderPage>(), bucket_idx);
+    BasicPageGuard dir_guard(buffer_pool_manager_, dir_page);
+    WritePageGuard bucket_guard = LatchBucketPage<WritePageGuard>(bucket_idx, dir_page);
+    const auto *bucket = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
+    if (!bucket->IsFull()) {
+      return InsertIntoBucket(&bucket_guard, key, value);
+    }
+  }
+  return SplitInsert(transaction, key, value);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  while (true) {
+    bool split = false;
+    {
+      TableLatchGuard table_guard(&table_latch_, false);
+      BasicPageGuard header_guard = FetchHeaderPage();
+      const auto *header_page = header_guard.As<ExtendibleHashTableHeaderPage>();
+      uint32_t bucket_idx = KeyToDirectoryIndex(key, header_page);
+      Page *dir_page = FetchDirectoryPage(header_page, bucket_idx);
+      BasicPageGuard dir_guard(buffer_pool_manager_, dir_page);
+      WritePageGuard bucket_guard = LatchBucketPage<WritePageGuard>(bucket_idx, dir_page);
+      const auto *bucket = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
+
+      // Another thread may have split the bucket or removed from it since it was found full.
+      if (!bucket->IsFull()) {
+        return InsertIntoBucket(&bucket_guard, key, value);
+      }
+      if (bucket->FindSlot(key, value, comparator_) != BUCKET_ARRAY_SIZE) {
+        return false;
+      }
+
+      // Only the holder of a bucket's write latch, or of the exclusive table latch, changes the bucket's directory
+      // entries, so its local depth can be read without the directory latch.
+      uint32_t local_depth = reinterpret_cast<HashTableDirectoryPage *>(dir_page->GetData())
+                                 ->GetLocalDepth(ExtendibleHashTableHeaderPage::DirectorySlot(bucket_idx));
+      if (local_depth < header_page->GetGlobalDepth()) {
+        if (!SplitBucket(header_page, bucket_idx, local_depth, &bucket_guard)) {
+          throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left to split a hash table bucket");
+        }
+        split = true;
+      }
+    }
+    if (!split && !GrowDirectory(key)) {
+      return false;
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::InsertIntoBucket(WritePageGuard *bucket_guard, const KeyType &key, const ValueType &value) {
+  // A duplicate pair leaves the page clean.
+  uint32_t slot = bucket_guard->As<HASH_TABLE_BUCKET_TYPE>()->FindInsertSlot(key, value, comparator_);
+  if (slot == BUCKET_ARRAY_SIZE) {
+    return false;
+  }
+  bucket_guard->AsMut<HASH_TABLE_BUCKET_TYPE>()->InsertAt(slot, key, value);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::SplitBucket(const ExtendibleHashTableHeaderPage *header_page, uint32_t bucket_idx,
+                                  uint32_t local_depth, WritePageGuard *bucket_guard) {
+  page_id_t image_page_id;
+  BasicPageGuard image_guard = buffer_pool_manager_->NewPageGuarded(&image_page_id);
+  if (!image_guard.IsValid()) {
+    return false;
+  }
+  auto *bucket = bucket_guard->AsMut<HASH_TABLE_BUCKET_TYPE>();
+  auto *image = image_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+
+  // Threads that find the image in the directory wait on its latch until its pairs are in place.
+  WritePageGuard image_write_guard = image_guard.UpgradeWrite();
+  uint32_t high_bit = 1U << local_depth;
+  for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE && bucket->IsOccupied(slot); slot++) {
+    if (bucket->IsReadable(slot) && (Hash(bucket->KeyAt(slot)) & high_bit) != 0) {
+      image->Insert(bucket->KeyAt(slot), bucket->ValueAt(slot), comparator_);
+      bucket->RemoveAt(slot);
+    }
+  }
+
+  // The entries that point to the bucket are those that agree with bucket_idx on the bits below the high bit. The
+  // ones with the high bit set now point to the image.
+  ForEachDirectoryEntry(header_page, bucket_idx & (high_bit - 1), high_bit, true,
+                        [&](HashTableDirectoryPage *directory, uint32_t slot, uint32_t entry_idx) {
+                          directory->IncrLocalDepth(slot);
+                          if ((entry_idx & high_bit) != 0) {
+                            directory->SetBucketPageId(slot, image_page_id);
+                          }
+                        });
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GrowDirectory(const KeyType &key) {
+  TableLatchGuard table_guard(&table_latch_, true);
+  BasicPageGuard header_guard = FetchHeaderPage();
+  const auto *header_page = header_guard.As<ExtendibleHashTableHeaderPage>();
+  uint32_t global_depth = header_page->GetGlobalDepth();
+  // Another thread may have doubled the directory since.
+  uint32_t bucket_idx = KeyToDirectoryIndex(key, header_page);
+  Page *dir_page = FetchDirectoryPage(header_page, bucket_idx);
+  BasicPageGuard dir_guard(buffer_pool_manager_, dir_page);
+  bool grow = reinterpret_cast<HashTableDirectoryPage *>(dir_page->GetData())
+                  ->GetLocalDepth(ExtendibleHashTableHeaderPage::DirectorySlot(bucket_idx)) == global_depth;
+  dir_guard.Drop();
+  if (!grow) {
+    return true;
+  }
+  if (global_depth >= ExtendibleHashTableHeaderPage::MAX_GLOBAL_DEPTH) {
+    return false;
+  }
+
+  if (global_depth < HashTableDirectoryPage::MAX_GLOBAL_DEPTH) {
+    // The directory still fits in its page, which doubles in place.
+    BasicPageGuard first_guard(buffer_pool_manager_, FetchDirectoryPage(header_page, 0));
+    first_guard.AsMut<HashTableDirectoryPage>()->IncrGlobalDepth();
+  } else {
+    // Every directory page is full: the new upper half of the directory is a copy of the lower half, page by page.
+    // The copies only become part of the directory once their page ids are in place and the global depth goes up.
+    uint32_t num_pages = header_page->NumDirectoryPages();
+    std::vector<page_id_t> new_page_ids;
+    try {
+      std::vector<page_id_t> copy_page_ids;
+      for (uint32_t directory_idx = 0; directory_idx < num_pages; directory_idx++) {
+        BasicPageGuard source_guard(buffer_pool_manager_,
+                                    FetchHashTablePage(GetDirectoryPageId(header_page, directory_idx)));
+        page_id_t copy_page_id;
+        BasicPageGuard copy_guard = buffer_pool_manager_->NewPageGuarded(&copy_page_id);
+        if (!copy_guard.IsValid()) {
+          throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left to grow the hash table directory");
+        }
+        new_page_ids.push_back(copy_page_id);
+        memcpy(copy_guard.GetDataMut(), source_guard.GetData(), PAGE_SIZE);
+        copy_guard.AsMut<HashTableDirectoryPage>()->SetPageId(copy_page_id);
+        copy_page_ids.push_back(copy_page_id);
+      }
+      if (2 * num_pages <= HEADER_ARRAY_SIZE) {
+        auto *header = header_guard.AsMut<ExtendibleHashTableHeaderPage>();
+        for (uint32_t directory_idx = 0; directory_idx < num_pages; directory_idx++) {
+          header->SetDirectoryPageId(num_pages + directory_idx, copy_page_ids[directory_idx]);
+        }
+      } else {
+        // The directory pages outgrow the header, which then points to index pages. The first doubling past it
+        // moves the header's page ids to the first index page; later ones add index pages for the copies.
+        uint32_t first_index_idx = num_pages > HEADER_ARRAY_SIZE ? num_pages / HEADER_ARRAY_SIZE : 0;
+        std::vector<page_id_t> index_page_ids;
+        for (uint32_t index_idx = first_index_idx; index_idx < 2 * num_pages / HEADER_ARRAY_SIZE; index_idx++) {
+          page_id_t index_page_id;
+          BasicPageGuard index_guard = buffer_pool_manager_->NewPageGuarded(&index_page_id);
+          if (!index_guard.IsValid()) {
+            throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left to grow the hash table directory");
+          }
+          new_page_ids.push_back(index_page_id);
+          index_page_ids.push_back(index_page_id);
+          auto *index = index_guard.AsMut<ExtendibleHashTableHeaderPage>();
+          index->SetPageId(index_page_id);
+          for (uint32_t slot = 0; slot < HEADER_ARRAY_SIZE; slot++) {
+            uint32_t directory_idx = index_idx * HEADER_ARRAY_SIZE + slot;
+            index->SetDirectoryPageId(slot, directory_idx < num_pages ? header_page->GetDirectoryPageId(directory_idx)
+                                                                      : copy_page_ids[directory_idx - num_pages]);
+          }
+        }
+        auto *header = header_guard.AsMut<ExtendibleHashTableHeaderPage>();
+        for (uint32_t i = 0; i < index_page_ids.size(); i++) {
+          header->SetDirectoryPageId(first_index_idx + i, index_page_ids[i]);
+        }
+      }
+    } catch (Exception &) {
+      // The guards of the pages fetched meanwhile are gone, so the new pages are unpinned and can be deleted.
+      for (page_id_t page_id : new_page_ids) {
+        buffer_pool_manager_->DeletePage(page_id);
+      }
+      throw;
+    }
+  }
+  header_guard.AsMut<ExtendibleHashTableHeaderPage>()->IncrGlobalDepth();
+  return true;
 }
 
 /*****************************************************************************
@@ -90,38 +409,186 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  bool removed;
+  bool empty = false;
+  {
+    TableLatchGuard table_guard(&table_latch_, false);
+    BasicPageGuard header_guard = FetchHeaderPage();
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, header_guard.As<ExtendibleHashTableHeaderPage>());
+    Page *dir_page = FetchDirectoryPage(header_guard.As<ExtendibleHashTableHeaderPage>(), bucket_idx);
+    BasicPageGuard dir_guard(buffer_pool_manager_, dir_page);
+    WritePageGuard bucket_guard = LatchBucketPage<WritePageGuard>(bucket_idx, dir_page);
+    // A pair that is not there leaves the page clean.
+    uint32_t slot = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->FindSlot(key, value, comparator_);
+    removed = slot != BUCKET_ARRAY_SIZE;
+    if (removed) {
+      auto *bucket = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+      bucket->RemoveAt(slot);
+      empty = bucket->IsEmpty();
+    }
+  }
+  if (empty) {
+    Merge(transaction, key, value);
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  TableLatchGuard table_guard(&table_latch_, true);
+  BasicPageGuard header_guard = FetchHeaderPage();
+  const auto *header_page = header_guard.As<ExtendibleHashTableHeaderPage>();
+  uint32_t bucket_idx = KeyToDirectoryIndex(key, header_page);
+  Page *dir_page = FetchDirectoryPage(header_page, bucket_idx);
+  BasicPageGuard dir_guard(buffer_pool_manager_, dir_page);
+  auto *directory = reinterpret_cast<HashTableDirectoryPage *>(dir_page->GetData());
+  uint32_t local_depth = directory->GetLocalDepth(ExtendibleHashTableHeaderPage::DirectorySlot(bucket_idx));
+  page_id_t bucket_page_id = directory->GetBucketPageId(ExtendibleHashTableHeaderPage::DirectorySlot(bucket_idx));
+  dir_guard.Drop();
+
+  bool merge = local_depth > 0;
+  uint32_t image_bit = merge ? 1U << (local_depth - 1) : 0;
+  page_id_t image_page_id = INVALID_PAGE_ID;
+  if (merge) {
+    // The split image may be on another directory page.
+    uint32_t image_idx = bucket_idx ^ image_bit;
+    Page *image_dir_page = FetchDirectoryPage(header_page, image_idx);
+    BasicPageGuard image_dir_guard(buffer_pool_manager_, image_dir_page);
+    auto *image_directory = reinterpret_cast<HashTableDirectoryPage *>(image_dir_page->GetData());
+    merge = image_directory->GetLocalDepth(ExtendibleHashTableHeaderPage::DirectorySlot(image_idx)) == local_depth;
+    image_page_id = image_directory->GetBucketPageId(ExtendibleHashTableHeaderPage::DirectorySlot(image_idx));
+  }
+  if (merge) {
+    // Inserts may have refilled the bucket since Remove emptied it.
+    BasicPageGuard bucket_guard(buffer_pool_manager_, FetchHashTablePage(bucket_page_id));
+    merge = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->IsEmpty();
+  }
+  if (merge) {
+    // A flush may hold the bucket pinned for a moment, in which case the bucket stays and the merge is skipped.
+    merge = buffer_pool_manager_->DeletePage(bucket_page_id);
+  }
+  if (merge) {
+    // The entries of the bucket and its image are those that agree with bucket_idx below the image bit.
+    ForEachDirectoryEntry(header_page, bucket_idx & (image_bit - 1), image_bit, true,
+                          [&](HashTableDirectoryPage *directory, uint32_t slot, uint32_t entry_idx) {
+                            directory->SetBucketPageId(slot, image_page_id);
+                            directory->DecrLocalDepth(slot);
+                          });
+    ShrinkDirectory(header_guard.AsMut<ExtendibleHashTableHeaderPage>());
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::ShrinkDirectory(ExtendibleHashTableHeaderPage *header_page) {
+  bool shrunk = false;
+  while (header_page->GetGlobalDepth() > 0) {
+    uint32_t global_depth = header_page->GetGlobalDepth();
+    bool can_shrink = true;
+    ForEachDirectoryEntry(header_page, 0, 1, false,
+                          [&](HashTableDirectoryPage *directory, uint32_t slot, uint32_t entry_idx) {
+                            can_shrink = can_shrink && directory->GetLocalDepth(slot) < global_depth;
+                          });
+    if (!can_shrink) {
+      break;
+    }
+    if (global_depth <= HashTableDirectoryPage::MAX_GLOBAL_DEPTH) {
+      BasicPageGuard first_guard(buffer_pool_manager_, FetchDirectoryPage(header_page, 0));
+      first_guard.AsMut<HashTableDirectoryPage>()->DecrGlobalDepth();
+    } else {
+      // The upper half of the directory pages mirrors the lower half. Their page ids are looked up before the header
+      // changes, so that running out of frames for the index pages leaves the directory as it was.
+      uint32_t num_pages = header_page->NumDirectoryPages();
+      std::vector<page_id_t> page_ids;
+      for (uint32_t directory_idx = num_pages / 2; directory_idx < num_pages; directory_idx++) {
+        page_ids.push_back(GetDirectoryPageId(header_page, directory_idx));
+      }
+      if (num_pages <= HEADER_ARRAY_SIZE) {
+        for (uint32_t directory_idx = num_pages / 2; directory_idx < num_pages; directory_idx++) {
+          header_page->SetDirectoryPageId(directory_idx, INVALID_PAGE_ID);
+        }
+      } else if (num_pages == 2 * HEADER_ARRAY_SIZE) {
+        // The directory pages fit in the header again, which takes the page ids back from the first index page.
+        page_id_t first_index_page_id = header_page->GetDirectoryPageId(0);
+        page_id_t second_index_page_id = header_page->GetDirectoryPageId(1);
+        {
+          BasicPageGuard index_guard(buffer_pool_manager_, FetchHashTablePage(first_index_page_id));
+          const auto *index = index_guard.As<ExtendibleHashTableHeaderPage>();
+          for (uint32_t directory_idx = 0; directory_idx < HEADER_ARRAY_SIZE; directory_idx++) {
+            header_page->SetDirectoryPageId(directory_idx, index->GetDirectoryPageId(directory_idx));
+          }
+        }
+        page_ids.push_back(first_index_page_id);
+        page_ids.push_back(second_index_page_id);
+      } else {
+        for (uint32_t index_idx = num_pages / 2 / HEADER_ARRAY_SIZE; index_idx < num_pages / HEADER_ARRAY_SIZE;
+             index_idx++) {
+          page_ids.push_back(header_page->GetDirectoryPageId(index_idx));
+          header_page->SetDirectoryPageId(index_idx, INVALID_PAGE_ID);
+        }
+      }
+      for (page_id_t page_id : page_ids) {
+        buffer_pool_manager_->DeletePage(page_id);
+      }
+    }
+    header_page->DecrGlobalDepth();
+    shrunk = true;
+  }
+  return shrunk;
+}
 
 /*****************************************************************************
- * GETGLOBALDEPTH - DO NOT TOUCH
+ * GETGLOBALDEPTH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
-  table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
-  table_latch_.RUnlock();
-  return global_depth;
+  TableLatchGuard table_guard(&table_latch_, false);
+  BasicPageGuard header_guard = FetchHeaderPage();
+  return header_guard.As<ExtendibleHashTableHeaderPage>()->GetGlobalDepth();
 }
 
 /*****************************************************************************
- * VERIFY INTEGRITY - DO NOT TOUCH
+ * VERIFY INTEGRITY
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
-  table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
-  table_latch_.RUnlock();
+  TableLatchGuard table_guard(&table_latch_, false);
+  BasicPageGuard header_guard = FetchHeaderPage();
+  const auto *header_page = header_guard.As<ExtendibleHashTableHeaderPage>();
+  uint32_t global_depth = header_page->GetGlobalDepth();
+  if (global_depth <= HashTableDirectoryPage::MAX_GLOBAL_DEPTH) {
+    Page *dir_page = FetchDirectoryPage(header_page, 0);
+    BasicPageGuard dir_guard(buffer_pool_manager_, dir_page);
+    auto *directory = reinterpret_cast<HashTableDirectoryPage *>(dir_page->GetData());
+    assert(directory->GetGlobalDepth() == global_depth);
+    directory->VerifyIntegrity();
+  } else {
+    // The invariants HashTableDirectoryPage::VerifyIntegrity checks, over all directory pages.
+    std::unordered_map<page_id_t, uint32_t> page_id_to_count;
+    std::unordered_map<page_id_t, uint32_t> page_id_to_ld;
+    ForEachDirectoryEntry(header_page, 0, 1, false,
+                          [&](HashTableDirectoryPage *directory, uint32_t slot, uint32_t entry_idx) {
+                            page_id_t page_id = directory->GetBucketPageId(slot);
+                            uint32_t local_depth = directory->GetLocalDepth(slot);
+                            uint32_t first_ld = page_id_to_ld.emplace(page_id, local_depth).first->second;
+                            if (local_depth > global_depth || local_depth != first_ld) {
+                              LOG_WARN("Verify Integrity: local_depth: %u, first_local_depth %u, for page_id: %d",
+                                       local_depth, first_ld, page_id);
+                              assert(local_depth <= global_depth && local_depth == first_ld);
+                            }
+                            ++page_id_to_count[page_id];
+                          });
+    for (const auto &entry : page_id_to_count) {
+      uint32_t required_count = 1U << (global_depth - page_id_to_ld[entry.first]);
+      if (entry.second != required_count) {
+        LOG_WARN("Verify Integrity: curr_count: %u, required_count %u, for page_id: %d", entry.second, required_count,
+                 entry.first);
+        assert(entry.second == required_count);
+      }
+    }
+  }
 }
 
 /*****************************************************************************
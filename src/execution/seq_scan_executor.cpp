@@ -14,10 +14,36 @@
 
 namespace bustub {
 
-SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx) {}
+SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
 
-void SeqScanExecutor::Init() {}
+void SeqScanExecutor::Init() {
+  table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+  // A fresh strategy per scan, so that a scan only ever recycles frames it filled itself.
+  iter_ = std::make_unique<TableIterator>(
+      table_info_->table_->Begin(exec_ctx_->GetTransaction(), exec_ctx_->MakeScanStrategy()));
+}
 
-bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
+  const Schema &table_schema = table_info_->schema_;
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  while (*iter_ != table_info_->table_->End()) {
+    const Tuple &current = **iter_;
+    if (predicate == nullptr || predicate->Evaluate(&current, &table_schema).GetAs<bool>()) {
+      const Schema *output_schema = GetOutputSchema();
+      std::vector<Value> values;
+      values.reserve(output_schema->GetColumnCount());
+      for (const Column &column : output_schema->GetColumns()) {
+        values.push_back(column.GetExpr()->Evaluate(&current, &table_schema));
+      }
+      *tuple = Tuple(values, output_schema);
+      *rid = current.GetRid();
+      ++*iter_;
+      return true;
+    }
+    ++*iter_;
+  }
+  return false;
+}
 
 }  // namespace bustub
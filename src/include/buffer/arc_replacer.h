@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/** A snapshot of the ARC lists and of the adaptation target. */
+struct ARCReplacerStats {
+  /** Target size of the recency list T1, in frames. Grows on B1 ghost hits, shrinks on B2 ghost hits. */
+  size_t target_t1_size_;
+  /** Resident frames referenced once since they were admitted. */
+  size_t t1_size_;
+  /** Resident frames referenced more than once. */
+  size_t t2_size_;
+  /** Ids of pages recently evicted from T1. */
+  size_t b1_size_;
+  /** Ids of pages recently evicted from T2. */
+  size_t b2_size_;
+};
+
+/**
+ * ARCReplacer implements Adaptive Replacement Cache (Megiddo & Modha, FAST '03).
+ *
+ * Resident frames live on T1 (seen once) or T2 (seen again while resident). Page ids of frames evicted from either
+ * list are remembered on the ghost lists B1 and B2, which together hold at most as many entries as there are frames.
+ * A page that comes back while on B1 means T1 was too small and grows the T1 target; one that comes back from B2
+ * shrinks it. Victims are taken from T1 while it exceeds the target and from T2 otherwise, so the policy leans
+ * towards recency for scan-heavy phases and towards frequency for point-lookup phases.
+ *
+ * A Pin within the correlated reference period of the frame's previous reference does not make the page frequent: a
+ * scan fetches the page it is on once per tuple, and must not move it to T2.
+ */
+class ARCReplacer : public Replacer {
+ public:
+  /**
+   * Create a new ARCReplacer.
+   * @param num_pages the maximum number of pages the ARCReplacer will be required to store
+   * @param correlated_reference_period references closer together than this many clock ticks count as one
+   */
+  explicit ARCReplacer(size_t num_pages, size_t correlated_reference_period = ARC_CORRELATED_REFERENCE_PERIOD);
+
+  /**
+   * Destroys the ARCReplacer.
+   */
+  ~ARCReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Admit(frame_id_t frame_id, page_id_t page_id) override;
+
+  void AdmitPrefetched(frame_id_t frame_id, page_id_t page_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
+  /** @return the current adaptation target and list sizes */
+  ARCReplacerStats GetStats();
+
+ private:
+  enum class ListType { NONE, T1, T2 };
+
+  struct FrameEntry {
+    /** The list the resident page belongs to, whether or not the frame is evictable. */
+    ListType list_{ListType::NONE};
+    /** Where the frame is linked on t1_ or t2_, while it is evictable. */
+    std::list<frame_id_t>::iterator pos_;
+    page_id_t page_id_{INVALID_PAGE_ID};
+    bool evictable_{false};
+    /** Filled by read-ahead and not referenced since, so the first Pin must not promote it to T2. */
+    bool prefetched_{false};
+    /**
+     * The list Victim took the frame from, until the frame is refilled. If the buffer pool fails to claim the victim,
+     * the next Unpin puts the still resident page back there and takes it off the ghost list.
+     */
+    ListType evicted_from_{ListType::NONE};
+    /** The ghost list read-ahead found the page on, to be counted as a ghost hit when the page is first pinned. */
+    ListType prefetched_ghost_{ListType::NONE};
+    /** Time of the last reference, including ones folded into a correlated period. */
+    uint64_t last_reference_{0};
+  };
+
+  struct GhostList {
+    std::list<page_id_t> pages_;
+    std::unordered_map<page_id_t, std::list<page_id_t>::iterator> index_;
+  };
+
+  /** Moves a frame to list, at the MRU end if it is evictable. Must hold latch_. */
+  void MoveTo(frame_id_t frame_id, ListType list);
+
+  /** Takes a frame off T1/T2, leaving it not evictable. Must hold latch_. */
+  void Unlink(frame_id_t frame_id);
+
+  /**
+   * Links a frame at the MRU end of its list when it becomes evictable, and unlinks it when it is pinned. The frame must
+   * be on T1 or T2 to become evictable. Must hold latch_.
+   */
+  void SetEvictable(frame_id_t frame_id, bool evictable);
+
+  /** @return t1_ or t2_ */
+  std::list<frame_id_t> *ListOf(ListType list) { return list == ListType::T1 ? &t1_ : &t2_; }
+
+  /**
+   * Gives a frame a newly admitted page and takes the page off the ghost lists. Must hold latch_.
+   * @return T1 or T2 if the page was a ghost on B1 or B2, NONE otherwise
+   */
+  ListType TakeGhost(FrameEntry *frame, page_id_t page_id);
+
+  /** Moves the T1 target after a hit on the ghost list of list. Must hold latch_. */
+  void AdaptTarget(ListType list);
+
+  /** Remembers page_id on the MRU end of ghost, trimming the ghost lists to their budget. Must hold latch_. */
+  void AddGhost(GhostList *ghost, page_id_t page_id);
+
+  /** Forgets page_id if ghost holds it. Must hold latch_. @return true if it was there */
+  bool EraseGhost(GhostList *ghost, page_id_t page_id);
+
+  /** Number of frames, c in the paper. */
+  const size_t capacity_;
+  const size_t correlated_reference_period_;
+  /** Logical clock, advanced on every reference. */
+  uint64_t current_timestamp_{0};
+  /** Target size of T1, p in the paper. */
+  size_t target_t1_size_{0};
+  std::vector<FrameEntry> frames_;
+  /**
+   * The evictable frames of T1 and T2, least recently unpinned at the front. Pinned frames are left out, so that a
+   * victim is always at the front.
+   */
+  std::list<frame_id_t> t1_;
+  std::list<frame_id_t> t2_;
+  /** Resident frames on T1 and T2, pinned or not: |T1| and |T2| in the paper. */
+  size_t num_t1_{0};
+  size_t num_t2_{0};
+  GhostList b1_;
+  GhostList b2_;
+  /** Number of evictable frames, i.e. of frames linked on t1_ and t2_. */
+  size_t num_evictable_{0};
+  /** Protects all of the above. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * BufferAccessStrategy keeps a bulk operation, such as a sequential scan of a large table, from evicting the rest of
+ * the buffer pool.
+ *
+ * The first activation_threshold pages the operation reads come into the pool as usual, so scans of small tables stay
+ * cached. After that, every page the operation reads goes into a small ring of frames that it keeps recycling. The
+ * pages are ordinary buffer pool pages: anyone can hit on them, and a ring frame that is pinned or has been given to
+ * another page is not recycled, but replaced in the ring by a regular victim.
+ *
+ * A strategy is shared by the operation and its queued read-ahead, so it is handed around as a shared_ptr.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param ring_size number of frames the operation recycles once the ring is active
+   * @param activation_threshold number of pages the operation reads into the pool as usual before using the ring
+   */
+  BufferAccessStrategy(size_t ring_size, size_t activation_threshold);
+
+  /**
+   * Creates the strategy for a sequential scan through bpm. The ring holds BULK_READ_RING_SIZE frames, capped at a
+   * quarter of the pool but large enough to hold the scan's read-ahead window. It becomes active once the scan has
+   * read BULK_READ_THRESHOLD_RATIO of the pool.
+   * @param bpm the buffer pool the scan reads through
+   * @return the strategy
+   */
+  static std::shared_ptr<BufferAccessStrategy> ForBulkRead(BufferPoolManager *bpm);
+
+  /** @return number of frames in the ring */
+  size_t GetRingSize() const { return ring_size_; }
+
+  /** @return number of pages read through this strategy so far */
+  size_t GetNumReads();
+
+  /** @return number of times a ring frame was recycled for the next page */
+  size_t GetNumRecycled();
+
+ private:
+  friend class BufferPoolManagerInstance;
+
+  /** A ring slot remembers which page it put in which frame, to recognize the frame as still its own. */
+  struct Slot {
+    frame_id_t frame_id_{-1};
+    page_id_t page_id_{INVALID_PAGE_ID};
+  };
+
+  /** Frame ids are per buffer pool instance, so each instance the operation reads from gets its own ring. */
+  struct Ring {
+    std::vector<Slot> slots_;
+    size_t next_{0};
+  };
+
+  const size_t ring_size_;
+  const size_t activation_threshold_;
+  /** Protects the members below. Taken by the buffer pool while it holds its own latch. */
+  std::mutex latch_;
+  std::unordered_map<const BufferPoolManager *, Ring> rings_;
+  size_t num_reads_{0};
+  size_t num_recycled_{0};
+};
+
+}  // namespace bustub
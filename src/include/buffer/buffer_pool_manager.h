@@ -12,14 +12,24 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -30,12 +40,14 @@ class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows a page in a chain, e.g. the next table heap page or B+ tree leaf. */
+  using next_page_id_fn = page_id_t (*)(const char *data);
 
   BufferPoolManager() = default;
   /**
    * Destroys an existing BufferPoolManager.
    */
-  virtual ~BufferPoolManager() = default;
+  virtual ~BufferPoolManager();
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
@@ -84,9 +96,126 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Creates a new page like NewPage, placed on disk right after near_page_id where possible so that pages used
+   * together, e.g. the pages of one table, stay contiguous for sequential I/O.
+   * @param[out] page_id id of created page
+   * @param near_page_id the page the new one should follow, or INVALID_PAGE_ID for no preference
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageNear(page_id_t *page_id, page_id_t near_page_id) { return NewPgNearImp(page_id, near_page_id); }
+
+  /**
+   * Fetches a page like FetchPage, except that a miss brings the page into the frames strategy allows.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the operation fetching the page, nullptr to use the whole pool
+   * @return the requested page, nullptr if no frame was available
+   */
+  Page *FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) {
+    return FetchPgWithStrategyImp(page_id, strategy);
+  }
+
+  /**
+   * Fetches a page and wraps its pin in a guard that unpins it when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return a guard for the page, empty if no frame was available
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id);
+
+  /**
+   * Fetches and read-latches a page. The guard releases the latch and then the pin.
+   * @param page_id id of page to be fetched
+   * @return a read guard for the page, empty if no frame was available
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+
+  /**
+   * Fetches and write-latches a page. The guard releases the latch and then the pin.
+   * @param page_id id of page to be fetched
+   * @return a write guard for the page, empty if no frame was available
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  /**
+   * Creates a new page and wraps its pin in a guard. The page is written back if it is modified through the guard.
+   * @param[out] page_id id of created page
+   * @return a guard for the new page, empty if no new page could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id);
+
+  /**
+   * Asks the I/O worker to bring pages into the buffer pool ahead of use, and returns right away. The pages are not
+   * pinned, and bringing them in does not count as a reference for the replacement policy. Pages that are already
+   * resident, or for which no frame can be freed, are skipped.
+   * @param page_ids ids of the pages to read ahead
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Asks the I/O worker to bring in up to count pages of a chain, starting at first_page_id and following the links
+   * read by next_page_id. The walk stops early at INVALID_PAGE_ID or when a page cannot be brought in.
+   * @param first_page_id id of the first page of the chain to read ahead
+   * @param count maximum number of pages to read ahead
+   * @param next_page_id reads the id of a page's successor out of its data
+   * @param strategy the access strategy of the operation the read-ahead is for, nullptr to use the whole pool
+   * @param chain_end if not null, set once the request is done or dropped to the id of the first page of the chain it
+   * did not bring in, INVALID_PAGE_ID if it reached the end of the chain; lets a caller carry on where it stopped
+   */
+  void PrefetchPageChain(page_id_t first_page_id, size_t count, next_page_id_fn next_page_id,
+                         std::shared_ptr<BufferAccessStrategy> strategy = nullptr,
+                         std::shared_ptr<std::atomic<page_id_t>> chain_end = nullptr);
+
+  /** @return how many pages sequential scans should read ahead, capped so read-ahead cannot crowd out the pool */
+  size_t GetReadAheadDistance() { return std::min<size_t>(READ_AHEAD_DISTANCE, GetPoolSize() / 4); }
+
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
+  /**
+   * Lists the pages resident in the buffer pool, hottest first, e.g. to save them with SaveHotPages. The default
+   * lists none.
+   * @return ids of the resident pages
+   */
+  virtual std::vector<page_id_t> GetHotPages() { return {}; }
+
+  /**
+   * Brings pages back into the free frames of the buffer pool, e.g. after a restart. The list is taken hottest first,
+   * in batches whose reads are issued in page id order. Pages that are resident already or no longer allocated are
+   * skipped, and nothing is evicted: once the free frames run out, the rest of the list is dropped. Requests are
+   * served meanwhile. The pages are brought in like read-ahead, unpinned and without counting a reference. The
+   * default loads none.
+   * @param page_ids ids of the pages to bring in, hottest first as listed by GetHotPages
+   * @return number of pages brought in
+   */
+  virtual size_t WarmUp(const std::vector<page_id_t> &page_ids) { return 0; }
+
+  /**
+   * Saves the ids of the hot pages to a file, replacing it atomically.
+   * @param path the file to write
+   * @return false if the file could not be written
+   */
+  bool SaveHotPages(const std::string &path);
+
+  /**
+   * @param path a file written by SaveHotPages
+   * @return the page ids saved in the file, hottest first; none if it is missing or damaged
+   */
+  static std::vector<page_id_t> LoadHotPages(const std::string &path);
+
+  /**
+   * Keeps the buffer pool warm across restarts: starts a background thread that brings the pages saved in path back
+   * with WarmUp while the pool serves requests, and saves the hot pages to path again when the pool is destroyed.
+   * Call once, before the pool is used.
+   * @param path the file the hot pages are kept in; a missing file means there is nothing to warm up
+   */
+  void EnableWarmUp(const std::string &path);
+
+  /**
+   * Waits for the warm-up started by EnableWarmUp to finish.
+   * @return number of pages it brought in, 0 if there was none
+   */
+  size_t WaitForWarmUp();
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -108,6 +237,17 @@ class BufferPoolManager {
    */
   virtual Page *FetchPgImp(page_id_t page_id) = 0;
 
+  /**
+   * Fetch the requested page from the buffer pool, bringing it in through strategy on a miss. The default ignores the
+   * strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, may be nullptr
+   * @return the requested page
+   */
+  virtual Page *FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+    return FetchPgImp(page_id);
+  }
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -130,6 +270,15 @@ class BufferPoolManager {
    */
   virtual Page *NewPgImp(page_id_t *page_id) = 0;
 
+  /**
+   * Creates a new page in the buffer pool, placed on disk after near_page_id where possible. The default ignores the
+   * placement hint.
+   * @param[out] page_id id of created page
+   * @param near_page_id the page the new one should follow, or INVALID_PAGE_ID
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) { return NewPgImp(page_id); }
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -141,5 +290,68 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Brings a page into the buffer pool for read-ahead, without pinning it or counting a reference. Runs on the I/O
+   * worker. The default does no read-ahead.
+   * @param page_id id of the page to bring in
+   * @param next_page_id if not nullptr, reads the id of the page's successor out of its data
+   * @param[out] next the successor's id when next_page_id is given
+   * @param strategy the access strategy of the operation the read-ahead is for, may be nullptr
+   * @return false if the page could not be brought in, e.g. because every frame is pinned
+   */
+  virtual bool PrefetchPgImp(page_id_t page_id, next_page_id_fn next_page_id, page_id_t *next,
+                             BufferAccessStrategy *strategy) {
+    return false;
+  }
+
+  /**
+   * Stops the I/O worker, dropping queued read-ahead. Implementations must call this from their destructor, before
+   * the frames PrefetchPgImp fills are torn down.
+   */
+  void StopPrefetchWorker();
+
+  /**
+   * Waits for the warm-up and, if EnableWarmUp was called, saves the hot pages. Implementations must call this from
+   * their destructor, while GetHotPages still works.
+   */
+  void ShutDownWarmUp();
+
+ private:
+  /** Forwards each call to the instance responsible for the page, through the protected implementations. */
+  friend class ParallelBufferPoolManager;
+
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    size_t count_;
+    next_page_id_fn next_page_id_;
+    /** Keeps the strategy alive until the request is done, even if the operation finishes first. */
+    std::shared_ptr<BufferAccessStrategy> strategy_;
+    /** Where the walk stopped, see PrefetchPageChain; may be null. */
+    std::shared_ptr<std::atomic<page_id_t>> chain_end_;
+  };
+
+  /** Queues a request, starting the I/O worker on first use. */
+  void EnqueuePrefetch(const PrefetchRequest &request);
+
+  /** Body of the I/O worker thread. */
+  void PrefetchWorkerLoop();
+
+  /** Read-ahead is a hint: requests beyond this many queued ones are dropped rather than let the worker fall behind. */
+  static constexpr size_t MAX_QUEUED_PREFETCHES = 256;
+
+  std::thread prefetch_worker_;
+  /** Protects the I/O worker state below. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::deque<PrefetchRequest> prefetch_queue_;
+  bool prefetch_worker_running_{false};
+  bool prefetch_worker_stopped_{false};
+
+  /** File EnableWarmUp keeps the hot pages in, empty if it was not called. */
+  std::string warm_up_path_;
+  std::thread warm_up_thread_;
+  /** Pages the warm-up brought in, written by the warm-up thread and read once it has been joined. */
+  size_t num_warmed_up_{0};
 };
 }  // namespace bustub
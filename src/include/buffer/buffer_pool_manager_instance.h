@@ -12,14 +12,23 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
 #include <list>
-#include <mutex>  // NOLINT
-#include <unordered_map>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/frame_arena.h"
+#include "buffer/page_table.h"
+#include "buffer/replacer.h"
+#include "common/util/latency_histogram.h"
+#include "common/util/sharded_counters.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
 #include "storage/page/page.h"
 
 namespace bustub {
@@ -34,8 +43,11 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param replacer_k the number of references tracked per frame when replacer_type is LRU_K
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t replacer_k = LRUK_REPLACER_K);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +55,12 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param replacer_k the number of references tracked per frame when replacer_type is LRU_K
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t replacer_k = LRUK_REPLACER_K);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -58,6 +73,83 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
+  /** @return the arena holding the data of every frame */
+  FrameArena *GetFrameArena() { return &frame_arena_; }
+
+  /** @return the replacer picking victim frames, e.g. to read policy-specific statistics */
+  Replacer *GetReplacer() { return replacer_; }
+
+  /**
+   * Starts a background thread that writes back cold dirty frames ahead of eviction, so that a miss usually finds a
+   * clean victim instead of waiting for a write. Pages whose LSN is not yet persistent in the log are left alone when
+   * logging is enabled. Does nothing if the writer is already running.
+   * @param target_clean_ratio fraction of the pool the writer tries to keep clean (free, or unpinned and not dirty)
+   * @param batch_size maximum number of pages written back per round
+   */
+  void StartBackgroundWriter(double target_clean_ratio = BG_WRITER_TARGET_CLEAN_RATIO,
+                             size_t batch_size = BG_WRITER_BATCH_SIZE);
+
+  /**
+   * Stops the background writer and waits for it to exit. Does nothing if it is not running.
+   */
+  void StopBackgroundWriter();
+
+  /** @return number of frames that can be reused without a write: free frames and unpinned clean frames */
+  size_t GetNumCleanFrames();
+
+  /**
+   * A lock-free estimate of how many frames a new page could be placed in without waiting for an unpin, i.e. frames
+   * that are free or unpinned. It can be stale by the time the caller acts on it.
+   * @return number of frames that are not pinned
+   */
+  size_t GetNumUnpinnedFrames() const {
+    // The relaxed count can briefly read above the pool size, while a pin and an unpin race.
+    size_t num_pinned = num_pinned_frames_.load(std::memory_order_relaxed);
+    return num_pinned < pool_size_ ? pool_size_ - num_pinned : 0;
+  }
+
+  /**
+   * Routes the buffer pool's page I/O through a DiskScheduler: a miss that evicts a dirty page submits the write-back
+   * and the read as one ordered batch, and the background writer submits each round's write-backs as one batch. Call
+   * before the buffer pool is used concurrently.
+   * @param disk_scheduler the scheduler, not owned, must outlive the buffer pool; nullptr for synchronous I/O
+   */
+  void SetDiskScheduler(DiskScheduler *disk_scheduler) { disk_scheduler_ = disk_scheduler; }
+
+  /**
+   * Flushes every dirty page of several instances that share a disk manager, in batches of FLUSH_BATCH_SIZE pages
+   * sorted by id, so that pages of different instances with consecutive ids are coalesced into the same write. Each
+   * page is copied under its read latch and written from the copy; no latch is held across the I/O.
+   * @param instances the instances to flush, e.g. all instances of a parallel buffer pool
+   */
+  static void FlushInstances(const std::vector<BufferPoolManagerInstance *> &instances);
+
+  /** @return number of pages written back by the background writer so far */
+  size_t GetNumBackgroundWrites() const { return counters_.Get(BACKGROUND_WRITES); }
+
+  /**
+   * Gathers what the buffer pool has done so far. The counters are read without stopping the pool; only the free list
+   * length takes the latch.
+   * @return hit, miss, eviction and write-back counts, pin waits, frame usage and the latency of misses
+   */
+  BufferPoolStats GetStats();
+
+  /**
+   * Lists the resident pages, hottest first: pinned pages, then the unpinned ones in reverse eviction order.
+   * @return ids of the resident pages
+   */
+  std::vector<page_id_t> GetHotPages() override;
+
+  /**
+   * Brings pages this instance owns back into its free frames. Each batch takes its frames off the free list under
+   * the latch, reads the pages with the latch released, together through the DiskScheduler if one is set, and takes
+   * the latch again only to map them. A miss on a page of the batch waits for it. Pages owned by other instances are
+   * skipped.
+   * @param page_ids ids of the pages to bring in, hottest first
+   * @return number of pages brought in
+   */
+  size_t WarmUp(const std::vector<page_id_t> &page_ids) override;
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
@@ -66,6 +158,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the buffer pool, bringing it into strategy's ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, nullptr to use the whole pool
+   * @return the requested page
+   */
+  Page *FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -88,6 +188,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page in the buffer pool, allocated on disk after near_page_id where possible.
+   * @param[out] page_id id of created page
+   * @param near_page_id the page the new one should follow, or INVALID_PAGE_ID
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -96,23 +204,33 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   bool DeletePgImp(page_id_t page_id) override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the dirty pages in the buffer pool to disk in batched writes, and syncs the database file.
    */
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Brings a page into the buffer pool for read-ahead, without pinning it or counting a reference.
+   * @param page_id id of the page to bring in
+   * @param next_page_id if not nullptr, reads the id of the page's successor out of its data
+   * @param[out] next the successor's id when next_page_id is given
+   * @param strategy the access strategy of the operation the read-ahead is for, may be nullptr
+   * @return false if every frame is pinned
+   */
+  bool PrefetchPgImp(page_id_t page_id, next_page_id_fn next_page_id, page_id_t *next,
+                     BufferAccessStrategy *strategy) override;
+
+  /**
+   * Allocate a page on disk, among the page ids that mod back to this BPI.
+   * @param near_page_id the page the new one should follow, or INVALID_PAGE_ID
    * @return the id of the allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(page_id_t near_page_id = INVALID_PAGE_ID);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that it can be allocated again.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -121,28 +239,159 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
+  /**
+   * Pin a frame found through a lock-free page table lookup. Fails if the frame is being refilled or no longer holds
+   * page_id, in which case the caller must retry under latch_.
+   * @param frame_id the frame the page table mapped page_id to
+   * @param page_id the page the caller is looking for
+   * @param reference false to leave the replacer alone, for pins that are not accesses on behalf of a caller
+   * @return true if the frame was pinned and holds page_id
+   */
+  bool TryPinResident(frame_id_t frame_id, page_id_t page_id, bool reference = true);
+
+  /**
+   * Drop one pin on a frame, handing it to the replacer when the last pin goes away.
+   * @param frame_id the frame to unpin
+   * @return false if the frame was not pinned
+   */
+  bool UnpinFrame(frame_id_t frame_id);
+
+  /**
+   * Take a frame from the free list or the replacer, writing back its contents if dirty. Must hold latch_. On success
+   * the frame is unmapped and its pin count is Page::PIN_COUNT_LOCKED.
+   * @param[out] frame_id the frame that can be refilled
+   * @param[out] deferred_write_back see EvictFrame
+   * @return false if every frame is pinned
+   */
+  bool GetVictimFrame(frame_id_t *frame_id, page_id_t *deferred_write_back = nullptr);
+
+  /**
+   * Like GetVictimFrame, but once strategy's ring is active, recycle the next frame of the ring if it still holds the
+   * page the ring put there and nobody has it pinned. Must hold latch_.
+   * @param[out] frame_id the frame that can be refilled
+   * @param page_id the page the frame will be refilled with, remembered by the ring
+   * @param strategy the access strategy of the caller, nullptr to use the whole pool
+   * @param[out] deferred_write_back see EvictFrame
+   * @return false if every frame is pinned
+   */
+  bool GetVictimFrame(frame_id_t *frame_id, page_id_t page_id, BufferAccessStrategy *strategy,
+                      page_id_t *deferred_write_back = nullptr);
+
+  /**
+   * Unmap a frame that the caller has locked, writing back its contents if dirty. Must hold latch_.
+   * @param frame_id the frame to evict
+   * @param[out] deferred_write_back if not nullptr and I/O goes through a DiskScheduler, the write-back is left to the
+   * caller, who is about to read into the frame: set to the page to write back first, or INVALID_PAGE_ID if none
+   */
+  void EvictFrame(frame_id_t frame_id, page_id_t *deferred_write_back = nullptr);
+
+  /**
+   * Read a page into a locked frame, first writing back the frame's previous contents if EvictFrame deferred that.
+   * latch_ is released for the I/O and held again on return; misses on either page wait in AwaitReadIn meanwhile.
+   * If the page fails its checksum, the frame goes back to the free list and the CORRUPTION exception propagates.
+   * @param lock the caller's hold on latch_
+   * @param frame_id the frame to read into
+   * @param page_id the page to read
+   * @param write_back_page_id the page the frame still holds and that must be written first, or INVALID_PAGE_ID
+   */
+  void ReadIntoFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id, page_id_t page_id,
+                     page_id_t write_back_page_id);
+
+  /** Body of the background writer thread. */
+  void BackgroundWriterLoop();
+
+  /**
+   * Sweep the frames in clock order, writing back unpinned dirty ones.
+   * @param max_pages stop after writing this many pages
+   * @return number of pages written
+   */
+  size_t WriteBackColdFrames(size_t max_pages);
+
+  /**
+   * Prepare to write back a frame if it is unpinned, dirty and, when logging is enabled, covered by the persistent
+   * log. On success the frame is pinned without telling the replacer, so the write does not count as a reference,
+   * read-latched and marked clean; EndWriteBack releases it once the write is done.
+   * @param frame_id the frame to write back
+   * @return true if the frame is to be written
+   */
+  bool TryBeginWriteBack(frame_id_t frame_id);
+
+  /** Releases a frame prepared by TryBeginWriteBack. */
+  void EndWriteBack(frame_id_t frame_id);
+
+  /** Takes latch_, accounting for the wait as a pin wait if another thread holds it. */
+  std::unique_lock<std::mutex> LockLatch();
+
+  /** Waits, with latch_ held by lock and released meanwhile, until no I/O on page_id runs with latch_ released. */
+  void AwaitReadIn(std::unique_lock<std::mutex> *lock, page_id_t page_id);
+
+  /** Indexes of the event counters in counters_; see BufferPoolStats for what they count. */
+  enum Counter : size_t {
+    HITS,
+    MISSES,
+    PREFETCHES,
+    EVICTIONS,
+    DIRTY_WRITE_BACKS,
+    BACKGROUND_WRITES,
+    PIN_WAITS,
+    PIN_WAIT_NS,
+    NUM_COUNTERS
+  };
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
   const uint32_t instance_index_ = 0;
-  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
-  std::atomic<page_id_t> next_page_id_ = instance_index_;
 
-  /** Array of buffer pool pages. */
+  /** Data of every frame, PAGE_SIZE-aligned and huge-page backed where possible. */
+  FrameArena frame_arena_;
+  /** Array of buffer pool pages: the frames' metadata, each pointing at its data in frame_arena_. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
+  /** Scheduler page I/O goes through, or nullptr to call the disk manager directly. */
+  DiskScheduler *disk_scheduler_{nullptr};
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages. Lookups are lock-free, updates happen under latch_. */
+  PageTable page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** Number of frames whose pin count is positive, updated on every 0 -> 1 and 1 -> 0 pin count transition. */
+  std::atomic<size_t> num_pinned_frames_{0};
+  /**
+   * Protects free_list_, page table updates and the reassignment of frames to pages. Hits on resident pages and unpins
+   * only touch the page table and the frame's atomic pin count and never take this latch.
+   */
   std::mutex latch_;
+  /**
+   * Pages whose I/O runs with latch_ released: those a miss or a warm-up batch is reading in, and those a miss is
+   * writing back ahead of its read. Protected by latch_.
+   */
+  std::unordered_set<page_id_t> reading_in_;
+  /** Signalled when pages leave reading_in_, for misses waiting on them with latch_. */
+  std::condition_variable read_in_cv_;
+
+  /** The background writer thread, if started. */
+  std::thread background_writer_;
+  /** Protects the background writer state below. */
+  std::mutex background_writer_latch_;
+  /** Signalled to stop the background writer, or to wake it when an eviction had to write a dirty victim. */
+  std::condition_variable background_writer_cv_;
+  bool background_writer_running_{false};
+  bool background_writer_wakeup_{false};
+  double target_clean_ratio_{BG_WRITER_TARGET_CLEAN_RATIO};
+  size_t write_batch_size_{BG_WRITER_BATCH_SIZE};
+  /** Next frame the background writer sweep looks at. Only touched by the writer thread. */
+  size_t background_writer_hand_{0};
+
+  /** Event counters, bumped on every fetch, so sharded by thread to keep hits from contending on them. */
+  ShardedCounters<NUM_COUNTERS> counters_;
+  /** How long fetches that missed took, from finding the page absent until it was pinned. */
+  LatencyHistogram miss_latency_;
 };
 }  // namespace bustub
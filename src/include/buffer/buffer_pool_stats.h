@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "common/util/latency_histogram.h"
+
+namespace bustub {
+
+/**
+ * What a buffer pool has done since it was created, as returned by GetStats of a BufferPoolManagerInstance, or summed
+ * over all instances of a ParallelBufferPoolManager. The counts are gathered without locking while the pool keeps
+ * running, so they need not add up exactly with each other, e.g. hits plus misses with the number of fetches.
+ */
+struct BufferPoolStats {
+  /** Fetches that found their page in the pool. */
+  uint64_t num_hits_{0};
+  /** Fetches that had to read their page from disk, whether or not a frame could be found for it. */
+  uint64_t num_misses_{0};
+  /** Pages read ahead into the pool. */
+  uint64_t num_prefetches_{0};
+  /** Pages dropped from the pool to make room for another page. */
+  uint64_t num_evictions_{0};
+  /** Evicted pages that were dirty and written back by the thread that needed their frame. */
+  uint64_t num_dirty_write_backs_{0};
+  /** Dirty pages written back ahead of eviction by the background writer. */
+  uint64_t num_background_writes_{0};
+  /** Fetches and new pages that had to wait for another thread before they could pin a frame. */
+  uint64_t num_pin_waits_{0};
+  /** Total time spent in those waits, in nanoseconds. */
+  uint64_t pin_wait_ns_{0};
+  /** Frames on the free list when the stats were taken. */
+  size_t free_list_length_{0};
+  /** Frames pinned when the stats were taken. */
+  size_t num_pinned_frames_{0};
+  /** How long fetches that missed took, from finding the page absent until it was pinned in a frame. */
+  LatencyHistogram::Snapshot miss_latency_;
+
+  /** Adds the counts of another pool, e.g. another instance of a parallel buffer pool, to these. */
+  BufferPoolStats &operator+=(const BufferPoolStats &other);
+
+  /** @return the share of fetches that hit, 0 if there were none */
+  double HitRatio() const;
+
+  /** @return every stat on one line, e.g. for logging */
+  std::string ToString() const;
+};
+
+}  // namespace bustub
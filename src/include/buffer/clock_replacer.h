@@ -45,8 +45,19 @@ class ClockReplacer : public Replacer {
 
   size_t Size() override;
 
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
  private:
-  // TODO(student): implement me!
+  /** Whether each frame is currently tracked by the replacer, i.e. unpinned. */
+  std::vector<bool> in_replacer_;
+  /** Reference bit of each frame, set on unpin and cleared as the clock hand sweeps past. */
+  std::vector<bool> ref_bits_;
+  /** Position of the clock hand. */
+  size_t hand_{0};
+  /** Number of frames currently tracked. */
+  size_t size_{0};
+  /** Protects all of the above. */
+  std::mutex latch_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the data of every frame of a buffer pool in one contiguous, PAGE_SIZE-aligned mapping, apart from
+ * the frames' metadata, so that frame data can be handed to O_DIRECT I/O and large pools need few TLB entries.
+ *
+ * The arena first asks for explicit 2 MB huge pages. If none are reserved it falls back to regular pages, aligned to
+ * 2 MB and advised as transparent huge page candidates so the kernel can still back them with huge pages. Arenas
+ * smaller than a huge page always use regular pages.
+ */
+class FrameArena {
+ public:
+  /** Size of the huge pages the arena asks for. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+  enum class Backing { HUGETLB, TRANSPARENT_HUGE_PAGES, REGULAR_PAGES };
+
+  /**
+   * Maps a zeroed arena. Throws an OUT_OF_MEMORY Exception if the memory cannot be mapped.
+   * @param num_frames number of PAGE_SIZE frames in the arena
+   * @param use_huge_pages false to use regular pages only, e.g. to compare against huge pages
+   */
+  explicit FrameArena(size_t num_frames, bool use_huge_pages = true);
+
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  /** @return the data of frame frame_id, PAGE_SIZE bytes aligned to PAGE_SIZE */
+  char *GetFrameData(size_t frame_id) { return data_ + frame_id * PAGE_SIZE; }
+
+  /** @return number of frames in the arena */
+  size_t GetNumFrames() const { return num_frames_; }
+
+  /** @return the kind of pages backing the arena */
+  Backing GetBacking() const { return backing_; }
+
+ private:
+  size_t num_frames_;
+  Backing backing_;
+  /** Start of the frame data, inside the mapping. */
+  char *data_{nullptr};
+  /** Start and length of the whole mapping, which may be larger than the frame data. */
+  void *mapping_{nullptr};
+  size_t mapping_size_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the evictable frame with the largest backward k-distance, i.e. whose k-th most recent reference is
+ * the oldest. Frames with fewer than k references have an infinite k-distance and are evicted first, oldest first
+ * reference first, which keeps a single sequential scan from displacing frames that are referenced repeatedly.
+ *
+ * Every Pin is a reference. References that follow the previous one within the correlated reference period are
+ * folded into it, and frames still inside their correlated period are only evicted when nothing else can be. The
+ * default period keeps a scan, which fetches the page it is on once per tuple, from making that page look hot.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of references tracked per frame
+   * @param correlated_reference_period references closer together than this many clock ticks count as one
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        size_t correlated_reference_period = LRUK_CORRELATED_REFERENCE_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void AdmitPrefetched(frame_id_t frame_id, page_id_t page_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
+ private:
+  using timestamp_t = uint64_t;
+  /** (eviction key, frame) pairs, ordered oldest key first. */
+  using EvictionQueue = std::set<std::pair<timestamp_t, frame_id_t>>;
+
+  struct FrameHistory {
+    /** Up to k reference times, most recent at the back. */
+    std::deque<timestamp_t> history_;
+    /** Time of the last reference, including ones folded into a correlated period. */
+    timestamp_t last_reference_{0};
+    bool evictable_{false};
+    /** The only entry in history_ is the read-ahead placeholder, to be replaced by the first real reference. */
+    bool prefetched_{false};
+  };
+
+  /** Records a reference to frame_id at the current time. Must hold latch_. */
+  void RecordReference(frame_id_t frame_id, FrameHistory *frame);
+
+  /** @return the queue an evictable frame belongs to and its key there. Must hold latch_. */
+  std::pair<EvictionQueue *, timestamp_t> QueueOf(const FrameHistory &frame);
+
+  /** @return true if the frame was referenced within the correlated reference period. Must hold latch_. */
+  bool InCorrelatedPeriod(const FrameHistory &frame) const;
+
+  const size_t k_;
+  const size_t correlated_reference_period_;
+  /** Logical clock, advanced on every reference. */
+  timestamp_t current_timestamp_{0};
+  std::unordered_map<frame_id_t, FrameHistory> frames_;
+  /** Evictable frames with fewer than k references, keyed by their first reference. */
+  EvictionQueue infinite_distance_;
+  /** Evictable frames with k references, keyed by their k-th most recent reference. */
+  EvictionQueue k_distance_;
+  /** Protects all of the above. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps resident page ids to the frames holding them.
+ *
+ * The table is open-addressed with linear probing over a power-of-two array of 64-bit atomic slots, each slot packing
+ * a (page_id, frame_id) pair. Lookups never take a lock: they read slots with acquire loads and may therefore observe
+ * a mapping that is concurrently being replaced. Callers must validate a hit against the frame itself (see
+ * BufferPoolManagerInstance::FetchPgImp). Insert and Erase must be serialized by the caller.
+ */
+class PageTable {
+ public:
+  /**
+   * Creates a new PageTable.
+   * @param num_frames the maximum number of mappings the table will be required to hold
+   */
+  explicit PageTable(size_t num_frames);
+
+  ~PageTable() = default;
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Lock-free lookup.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame that held page_id at the time of the lookup
+   * @return true if a mapping was found, false otherwise
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const;
+
+  /**
+   * Adds a mapping. The caller must hold the writer latch and page_id must not already be present.
+   * @param page_id the page to map
+   * @param frame_id the frame holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Removes a mapping. The caller must hold the writer latch.
+   * @param page_id the page to unmap
+   * @return true if the mapping was present, false otherwise
+   */
+  bool Erase(page_id_t page_id);
+
+ private:
+  static constexpr uint64_t EMPTY_SLOT = UINT64_MAX;
+  static constexpr uint64_t TOMBSTONE_SLOT = UINT64_MAX - 1;
+
+  static inline uint64_t Pack(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static inline page_id_t SlotPageId(uint64_t slot) { return static_cast<page_id_t>(slot >> 32); }
+  static inline frame_id_t SlotFrameId(uint64_t slot) { return static_cast<frame_id_t>(slot & UINT32_MAX); }
+
+  /** @return the first slot of the probe sequence for page_id */
+  inline size_t HomeSlot(page_id_t page_id) const {
+    // Fibonacci hashing spreads the consecutive page ids a single instance hands out across the table.
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               shift_);
+  }
+
+  /** Number of slots, always a power of two. */
+  size_t capacity_;
+  /** capacity_ - 1 */
+  size_t mask_;
+  /** 64 - log2(capacity_) */
+  uint32_t shift_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+}  // namespace bustub
@@ -12,13 +12,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/**
+ * ParallelBufferPoolManager shards the buffer pool over several BufferPoolManagerInstances. A page lives in the
+ * instance its id maps to modulo the number of instances. NewPage picks the instance a new page goes to: round-robin
+ * by default, or the calling thread's home instance with thread affinity turned on. Either way, instances that have
+ * no unpinned frame left are skipped without taking their latch, and if the preferred instance is full the page goes to
+ * the instance with the most unpinned frames.
+ */
 class ParallelBufferPoolManager : public BufferPoolManager {
  public:
   /**
@@ -27,9 +38,12 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every BufferPoolManagerInstance
+   * @param replacer_k the number of references tracked per frame when replacer_type is LRU_K
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t replacer_k = LRUK_REPLACER_K);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -39,6 +53,42 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override;
 
+  /**
+   * With thread affinity, each thread places its new pages in its own home instance while that instance has room, so
+   * the pages a thread creates back to back stay on one shard and threads do not contend for the same latch.
+   * @param enable true to place new pages in the calling thread's home instance, false for round-robin placement
+   */
+  void SetThreadAffinity(bool enable) { thread_affinity_.store(enable, std::memory_order_relaxed); }
+
+  /** @return the index of the calling thread's home instance */
+  size_t GetHomeInstanceIndex() const;
+
+  /** @return number of BufferPoolManagerInstances */
+  size_t GetNumInstances() const { return instances_.size(); }
+
+  /**
+   * @param instance_index index of the instance, less than GetNumInstances()
+   * @return the BufferPoolManagerInstance at that index, e.g. to start its background writer
+   */
+  BufferPoolManagerInstance *GetInstance(size_t instance_index) { return instances_[instance_index]; }
+
+  /** @return the stats of every instance added up; GetInstance(i)->GetStats() has those of one instance */
+  BufferPoolStats GetStats();
+
+  /**
+   * Lists the resident pages of every instance, hottest first: the instances' lists are interleaved, so that the
+   * hottest pages of each instance come before the colder ones of any.
+   * @return ids of the resident pages
+   */
+  std::vector<page_id_t> GetHotPages() override;
+
+  /**
+   * Hands each instance the pages it owns to warm up with, and lets the instances fill in parallel.
+   * @param page_ids ids of the pages to bring in, hottest first
+   * @return number of pages brought in by all instances
+   */
+  size_t WarmUp(const std::vector<page_id_t> &page_ids) override;
+
  protected:
   /**
    * @param page_id id of page
@@ -53,6 +103,14 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the buffer pool, bringing it in through strategy on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, nullptr to use the whole pool
+   * @return the requested page
+   */
+  Page *FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -75,6 +133,15 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page in the buffer pool, preferring the instance that owns the page right after near_page_id so
+   * that it can be allocated there.
+   * @param[out] page_id id of created page
+   * @param near_page_id the page the new one should follow, or INVALID_PAGE_ID
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -86,5 +153,22 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   void FlushAllPgsImp() override;
+
+  /**
+   * Brings a page into the instance responsible for it, for read-ahead.
+   * @param page_id id of the page to bring in
+   * @param next_page_id if not nullptr, reads the id of the page's successor out of its data
+   * @param[out] next the successor's id when next_page_id is given
+   * @param strategy the access strategy of the operation the read-ahead is for, may be nullptr
+   * @return false if the page could not be brought in
+   */
+  bool PrefetchPgImp(page_id_t page_id, next_page_id_fn next_page_id, page_id_t *next,
+                     BufferAccessStrategy *strategy) override;
+
+ private:
+  std::vector<BufferPoolManagerInstance *> instances_;
+  /** Instance NewPgImp tries first without thread affinity, bumped on every call to spread new pages around. */
+  std::atomic<size_t> next_instance_{0};
+  std::atomic<bool> thread_affinity_{false};
 };
 }  // namespace bustub
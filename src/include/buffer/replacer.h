@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** Replacement policies a BufferPoolManagerInstance can be constructed with. */
+enum class ReplacerType { LRU, CLOCK, LRU_K, ARC };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,8 +48,37 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Pins a frame that was just filled with a page. Policies that remember evicted pages (ARC) use the page id to
+   * recognize pages coming back; the default treats this like any other Pin.
+   * @param frame_id the id of the frame that was filled
+   * @param page_id the id of the page now held by the frame
+   */
+  virtual void Admit(frame_id_t frame_id, page_id_t page_id) { Pin(frame_id); }
+
+  /**
+   * Starts tracking a frame that read-ahead just filled. The frame is evictable right away, and the read-ahead does not
+   * count as a reference: the first Pin after it is the page's first reference. The default treats it like an Unpin.
+   * @param frame_id the id of the frame that was filled
+   * @param page_id the id of the page now held by the frame
+   */
+  virtual void AdmitPrefetched(frame_id_t frame_id, page_id_t page_id) { Unpin(frame_id); }
+
+  /**
+   * Forgets a frame whose page was deleted, including any access history the policy keeps for it.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * Lists the frames that can be victimized in the order the policy would evict them if nothing else happened, e.g.
+   * to save the hot set of the buffer pool. Unlike Victim, this does not change the replacer's state.
+   * @return the evictable frames, next victim first
+   */
+  virtual std::vector<frame_id_t> GetEvictionOrder() = 0;
 };
 
 }  // namespace bustub
@@ -10,9 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#pragma once
+
+#include <algorithm>
 #include <string>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
 #include "recovery/checkpoint_manager.h"
@@ -21,18 +25,65 @@
 
 namespace bustub {
 
+/**
+ * Runtime configuration of a BustubInstance. The defaults match the compile-time constants in common/config.h.
+ */
+struct BustubInstanceConfig {
+  /** Total number of frames in the buffer pool, split evenly over the instances. */
+  size_t buffer_pool_size_{BUFFER_POOL_SIZE};
+  /** Number of BufferPoolManagerInstances; more than one builds a ParallelBufferPoolManager. */
+  size_t num_buffer_pool_instances_{1};
+  /** With more than one instance, place each thread's new pages in its own home instance instead of round-robin. */
+  bool buffer_pool_thread_affinity_{false};
+  /** Replacement policy of every buffer pool instance. */
+  ReplacerType replacer_type_{ReplacerType::LRU};
+  /** Number of references tracked per frame when replacer_type_ is LRU_K. */
+  size_t replacer_k_{LRUK_REPLACER_K};
+  /** Size of the log buffer in bytes, 0 to derive it from buffer_pool_size_ with LogManager::LogBufferSizeFor. */
+  size_t log_buffer_size_{0};
+  /** True to route buffer pool I/O through a DiskScheduler (io_uring where available) instead of blocking calls. */
+  bool use_disk_scheduler_{false};
+  /** True to open the database file with O_DIRECT, so that the buffer pool is the only cache of its pages. */
+  bool use_direct_io_{false};
+  /** True to checksum every page written and verify it when it is read back. */
+  bool use_checksums_{false};
+  /** True to store pages LZ4-compressed; a database must always be opened with the value it was created with. Cannot
+   * be combined with use_direct_io_. */
+  bool use_compression_{false};
+};
+
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  explicit BustubInstance(const std::string &db_file_name, const BustubInstanceConfig &config = {}) {
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, config.use_direct_io_, PAGES_PER_SEGMENT, config.use_checksums_,
+                                    config.use_compression_);
+    disk_scheduler_ = config.use_disk_scheduler_ ? new DiskScheduler(disk_manager_) : nullptr;
 
     // log related
-    log_manager_ = new LogManager(disk_manager_);
+    log_manager_ = new LogManager(disk_manager_, config.log_buffer_size_ != 0
+                                                     ? config.log_buffer_size_
+                                                     : LogManager::LogBufferSizeFor(config.buffer_pool_size_));
 
-    buffer_pool_manager_ = new BufferPoolManagerInstance(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    size_t num_instances = std::max<size_t>(config.num_buffer_pool_instances_, 1);
+    if (num_instances == 1) {
+      auto *bpm = new BufferPoolManagerInstance(config.buffer_pool_size_, disk_manager_, log_manager_,
+                                                config.replacer_type_, config.replacer_k_);
+      bpm->SetDiskScheduler(disk_scheduler_);
+      buffer_pool_manager_ = bpm;
+    } else {
+      // Round up so that the pool is never smaller than asked for.
+      size_t instance_pool_size = (config.buffer_pool_size_ + num_instances - 1) / num_instances;
+      auto *parallel_bpm = new ParallelBufferPoolManager(num_instances, instance_pool_size, disk_manager_,
+                                                         log_manager_, config.replacer_type_, config.replacer_k_);
+      parallel_bpm->SetThreadAffinity(config.buffer_pool_thread_affinity_);
+      for (size_t i = 0; i < num_instances; i++) {
+        parallel_bpm->GetInstance(i)->SetDiskScheduler(disk_scheduler_);
+      }
+      buffer_pool_manager_ = parallel_bpm;
+    }
 
     // txn related
     lock_manager_ = new LockManager();
@@ -51,10 +102,13 @@ class BustubInstance {
     delete buffer_pool_manager_;
     delete lock_manager_;
     delete transaction_manager_;
+    delete disk_scheduler_;
     delete disk_manager_;
   }
 
   DiskManager *disk_manager_;
+  /** Scheduler for the buffer pool's I/O, nullptr unless BustubInstanceConfig::use_disk_scheduler_ is set. */
+  DiskScheduler *disk_scheduler_;
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
@@ -16,6 +16,11 @@
 #include <chrono>  // NOLINT
 #include <cstdint>
 
+/** Size of a page in bytes. Set at build time with the BUSTUB_PAGE_SIZE CMake option. */
+#ifndef BUSTUB_PAGE_SIZE
+#define BUSTUB_PAGE_SIZE 4096
+#endif
+
 namespace bustub {
 
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
@@ -27,14 +32,35 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The buffer pool background writer wakes up at least every BG_WRITER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds bg_writer_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
-static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int PAGE_SIZE = BUSTUB_PAGE_SIZE;                            // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
+static constexpr size_t MAX_LOG_BUFFER_SIZE = 16 << 20;                       // max log buffer of a runtime-sized pool
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr size_t LRUK_REPLACER_K = 2;                                  // default K of the LRU-K replacer
+static constexpr size_t LRUK_CORRELATED_REFERENCE_PERIOD = 8;                 // ticks in which LRU-K refs count once
+static constexpr size_t ARC_CORRELATED_REFERENCE_PERIOD = 8;                  // ticks in which ARC refs count once
+static constexpr double BG_WRITER_TARGET_CLEAN_RATIO = 0.25;                  // fraction of frames kept clean
+static constexpr size_t BG_WRITER_BATCH_SIZE = 16;                            // max pages per background writer round
+static constexpr size_t FLUSH_BATCH_SIZE = 256;                               // pages FlushAllPages writes per batch
+static constexpr size_t READ_AHEAD_DISTANCE = 8;                              // pages sequential scans read ahead
+static constexpr size_t WARM_UP_BATCH_SIZE = 64;                              // pages warm-up reads per sorted batch
+static constexpr size_t BULK_READ_RING_SIZE = 32;                             // frames a large sequential scan recycles
+static constexpr double BULK_READ_THRESHOLD_RATIO = 0.25;                     // pool fraction a scan reads before ring
+static constexpr size_t DISK_SCHEDULER_QUEUE_DEPTH = 64;                      // max requests submitted at once
+static constexpr size_t DISK_SCHEDULER_NUM_WORKERS = 4;                       // I/O threads without io_uring
+static constexpr int PAGES_PER_EXTENT = 16;                                   // pages kept together for one table
+static constexpr size_t PAGES_PER_SEGMENT = (1 << 30) / PAGE_SIZE;            // pages per database segment file (1 GB)
+static constexpr size_t MAX_DB_SEGMENTS = 8192;                               // max segment files of one database
+static constexpr size_t SEGMENT_PREALLOCATE_PAGES = 256;                      // pages preallocated at a time
+static constexpr int COMPRESSION_SLOT_SIZE = PAGE_SIZE / 8;                   // unit of space of a compressed page
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -43,4 +69,7 @@ using lsn_t = int32_t;         // log sequence number type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 
+static_assert(PAGE_SIZE >= 4096 && PAGE_SIZE <= 65536 && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+              "PAGE_SIZE must be a power of two from 4 KB to 64 KB");
+
 }  // namespace bustub
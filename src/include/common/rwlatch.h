@@ -12,25 +12,27 @@
 
 #pragma once
 
-#include <climits>
-#include <condition_variable>  // NOLINT
-#include <mutex>               // NOLINT
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 
 #include "common/macros.h"
+#include "common/util/sharded_counters.h"
 
 namespace bustub {
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Reader-Writer latch on a single atomic word, which holds the number of readers and a writer flag. Latching and
+ * unlatching without contention is a single atomic operation on the word. A thread that has to wait spins for a while
+ * and then parks on the word with a futex, and is woken by the unlatch that lets it in. A writer that has entered
+ * keeps new readers out while it waits for the current ones to leave, so a steady stream of readers cannot starve it.
+ * A read latch may be released by another thread than the one that took it.
  */
 class ReaderWriterLatch {
-  using mutex_t = std::mutex;
-  using cond_t = std::condition_variable;
-  static const uint32_t MAX_READERS = UINT_MAX;
-
  public:
   ReaderWriterLatch() = default;
-  ~ReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
+  ~ReaderWriterLatch() = default;
 
   DISALLOW_COPY(ReaderWriterLatch);
 
@@ -38,13 +40,9 @@ class ReaderWriterLatch {
    * Acquire a write latch.
    */
   void WLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_) {
-      reader_.wait(latch);
-    }
-    writer_entered_ = true;
-    while (reader_count_ > 0) {
-      writer_.wait(latch);
+    uint32_t state = 0;
+    if (!state_.compare_exchange_strong(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+      WLockSlow();
     }
   }
 
@@ -52,45 +50,147 @@ class ReaderWriterLatch {
    * Release a write latch.
    */
   void WUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    writer_entered_ = false;
-    reader_.notify_all();
+    // No reader can be in while a writer is, so only the waiters flag can be set besides the writer flag.
+    if ((state_.exchange(0, std::memory_order_release) & WAITERS) != 0) {
+      WakeAll(&state_);
+    }
   }
 
   /**
    * Acquire a read latch.
    */
   void RLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_ || reader_count_ == MAX_READERS) {
-      reader_.wait(latch);
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & WRITER) != 0 ||
+        !state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+      RLockSlow();
+    }
+  }
+
+  /**
+   * Release a read latch.
+   */
+  void RUnlock() {
+    uint32_t state = state_.fetch_sub(1, std::memory_order_release);
+    // The last reader out lets in the writer waiting for the readers to leave.
+    if ((state & READER_MASK) == 1 && (state & WAITERS) != 0) {
+      state_.fetch_and(~WAITERS, std::memory_order_relaxed);
+      WakeAll(&state_);
+    }
+  }
+
+  /** Rounds a waiting thread spins before it parks. */
+  static constexpr int SPIN_LIMIT = 100;
+
+  /**
+   * Waits for a word to change from a value: spins during the first SPIN_LIMIT rounds of a wait, then parks until
+   * WakeAll is called on the word. Returns early on a spurious wakeup, so callers check their condition in a loop.
+   * @param word the word to watch
+   * @param value the value it is expected to have
+   * @param round how many times the caller has waited for its condition so far
+   */
+  static void Wait(std::atomic<uint32_t> *word, uint32_t value, int round);
+
+  /** Wakes every thread parked on a word. */
+  static void WakeAll(std::atomic<uint32_t> *word);
+
+ private:
+  /** Set while a writer holds the latch, or has entered and waits for the readers to leave. */
+  static constexpr uint32_t WRITER = 1U << 31;
+  /** Set while a thread is parked, or about to park, on the word. */
+  static constexpr uint32_t WAITERS = 1U << 30;
+  /** The number of readers, in the low bits. */
+  static constexpr uint32_t READER_MASK = WAITERS - 1;
+
+  void WLockSlow();
+
+  void RLockSlow();
+
+  /** Waits for state_ to change from state, setting the waiters flag before it parks. */
+  void WaitForChange(uint32_t state, int round);
+
+  std::atomic<uint32_t> state_{0};
+};
+
+/**
+ * ShardedReaderWriterLatch is a reader-writer latch for latches that are read-latched far more often than
+ * write-latched, e.g. the latch every transaction read-latches for its lifetime and only checkpoints write-latch.
+ * Readers count themselves on a per-thread shard, on a cache line of its own, instead of on one word shared by all
+ * threads; a writer pays for this by summing the shards. Writers are preferred, and parked threads are woken, as with
+ * ReaderWriterLatch, and a read latch may be released by another thread than the one that took it.
+ */
+class ShardedReaderWriterLatch {
+ public:
+  ShardedReaderWriterLatch() = default;
+  ~ShardedReaderWriterLatch() = default;
+
+  DISALLOW_COPY(ShardedReaderWriterLatch);
+
+  /**
+   * Acquire a write latch.
+   */
+  void WLock();
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock();
+
+  /**
+   * Acquire a read latch.
+   */
+  void RLock() {
+    std::atomic<uint32_t> *readers = &shards_[CounterShardIndex(NUM_SHARDS)].readers_;
+    // Sequentially consistent, like the writer's flag store and its reads of the shards: either the writer sees us, or
+    // we see the writer.
+    readers->fetch_add(1);
+    if (writer_.load() != 0) {
+      RLockSlow(readers);
     }
-    reader_count_++;
   }
 
   /**
    * Release a read latch.
    */
   void RUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    reader_count_--;
-    if (writer_entered_) {
-      if (reader_count_ == 0) {
-        writer_.notify_one();
-      }
-    } else {
-      if (reader_count_ == MAX_READERS - 1) {
-        reader_.notify_one();
-      }
+    shards_[CounterShardIndex(NUM_SHARDS)].readers_.fetch_sub(1);
+    if ((writer_.load() & WRITER_PARKED) != 0) {
+      NotifyWriter();
     }
   }
 
+  /** Number of shards; threads beyond this many share shards. */
+  static constexpr size_t NUM_SHARDS = 16;
+
  private:
-  mutex_t mutex_;
-  cond_t writer_;
-  cond_t reader_;
-  uint32_t reader_count_{0};
-  bool writer_entered_{false};
+  /** Bits of writer_. */
+  static constexpr uint32_t WRITER_IN = 1;
+  static constexpr uint32_t READERS_PARKED = 2;
+  static constexpr uint32_t WRITER_PARKED = 4;
+
+  /** Backs out of the shard, waits for the writer to leave, and enters again. */
+  void RLockSlow(std::atomic<uint32_t> *readers);
+
+  /** Wakes the writer parked until the readers leave. */
+  void NotifyWriter();
+
+  /** @return the number of readers; a reader counted in one shard may have left through another */
+  uint32_t NumReaders() const;
+
+  struct alignas(64) Shard {
+    std::atomic<uint32_t> readers_{0};
+  };
+
+  std::array<Shard, NUM_SHARDS> shards_{};
+  /** Serializes writers. */
+  ReaderWriterLatch writer_latch_;
+  /**
+   * WRITER_IN while a writer holds the latch or waits for the readers to leave, plus READERS_PARKED once readers park
+   * on this word until it leaves, and WRITER_PARKED once it parks on drain_epoch_. Zero otherwise.
+   */
+  alignas(64) std::atomic<uint32_t> writer_{0};
+  /** Bumped by every reader that leaves while the writer is parked on it. */
+  std::atomic<uint32_t> drain_epoch_{0};
 };
 
 }  // namespace bustub
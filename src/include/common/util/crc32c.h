@@ -0,0 +1,42 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.h
+//
+// Identification: src/include/common/util/crc32c.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Crc32c computes CRC-32C (Castagnoli) checksums, as used for page checksums. On x86-64 CPUs with SSE4.2 the crc32
+ * instruction is used, over three interleaved streams for buffers of a page or more; elsewhere a table-driven
+ * software version gives the same results.
+ */
+class Crc32c {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param length number of bytes
+   * @param crc the checksum of the bytes preceding data, to checksum a buffer in pieces; 0 to start
+   * @return the CRC-32C of the bytes
+   */
+  static uint32_t Compute(const char *data, size_t length, uint32_t crc = 0);
+
+  /** Computes the checksum without the crc32 instruction, whatever the CPU supports. */
+  static uint32_t ComputeSoftware(const char *data, size_t length, uint32_t crc = 0);
+
+  /** @return true if Compute uses the crc32 instruction */
+  static bool IsHardwareAccelerated();
+};
+
+}  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// latency_histogram.h
+//
+// Identification: src/include/common/util/latency_histogram.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "common/util/sharded_counters.h"
+
+namespace bustub {
+
+/**
+ * LatencyHistogram counts how long an operation takes, in buckets that double in width: bucket 0 holds durations
+ * under 2 ns and bucket i > 0 those from 2^i up to 2^(i+1) ns, with the last bucket open ended. Recording is a pair of
+ * relaxed atomic adds on the calling thread's shard, so it can sit on paths many threads run at once.
+ */
+class LatencyHistogram {
+ public:
+  /** Number of buckets. The last one starts at about 9 minutes. */
+  static constexpr size_t NUM_BUCKETS = 40;
+
+  /** A copy of a histogram's counts, which can be summed over histograms and queried. */
+  struct Snapshot {
+    /** Number of durations recorded in each bucket. */
+    std::array<uint64_t, NUM_BUCKETS> counts_{};
+    /** Number of durations recorded. */
+    uint64_t count_{0};
+    /** Sum of the durations recorded, in nanoseconds. */
+    uint64_t total_ns_{0};
+
+    /** Adds the counts of another snapshot to this one. */
+    Snapshot &operator+=(const Snapshot &other);
+
+    /** @return the mean duration in nanoseconds, 0 if nothing was recorded */
+    double MeanNanos() const;
+
+    /**
+     * @param fraction the share of durations that are to be at or below the result, e.g. 0.99 for the 99th percentile
+     * @return the upper edge of the bucket the percentile falls in, in nanoseconds; 0 if nothing was recorded
+     */
+    uint64_t PercentileNanos(double fraction) const;
+
+    /** @return count, mean, 50th, 99th and 99.9th percentile, e.g. for logging */
+    std::string ToString() const;
+  };
+
+  /** Records one duration. */
+  void Record(std::chrono::nanoseconds duration);
+
+  /** @return the counts recorded so far */
+  Snapshot GetSnapshot() const;
+
+  /**
+   * @param bucket index of a bucket
+   * @return the smallest duration, in nanoseconds, that falls past the bucket
+   */
+  static uint64_t BucketLimitNanos(size_t bucket);
+
+ private:
+  /** The bucket counts, then the sum of the durations in nanoseconds. */
+  ShardedCounters<NUM_BUCKETS + 1> counters_;
+};
+
+/**
+ * Records the time from its construction to its destruction in a histogram, e.g. over a function with several
+ * returns.
+ */
+class ScopedLatencyTimer {
+ public:
+  /** @param histogram the histogram to record in */
+  explicit ScopedLatencyTimer(LatencyHistogram *histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedLatencyTimer() { histogram_->Record(std::chrono::steady_clock::now() - start_); }
+
+  ScopedLatencyTimer(const ScopedLatencyTimer &) = delete;
+  ScopedLatencyTimer &operator=(const ScopedLatencyTimer &) = delete;
+
+ private:
+  LatencyHistogram *histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sharded_counters.h
+//
+// Identification: src/include/common/util/sharded_counters.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/** @return the shard of a ShardedCounters block the calling thread updates */
+inline size_t CounterShardIndex(size_t num_shards) {
+  // Threads are numbered in the order they first count something, which spreads them evenly over the shards.
+  static std::atomic<size_t> next_thread_number{0};
+  thread_local size_t thread_number = next_thread_number.fetch_add(1, std::memory_order_relaxed);
+  return thread_number % num_shards;
+}
+
+/**
+ * ShardedCounters is a block of event counters that many threads can bump at once without contending for a cache line.
+ * Every counter is kept once per shard, each shard on cache lines of its own; a thread only ever adds to the shard it
+ * was assigned, and reading a counter sums it over all shards. Updates are relaxed atomic adds, so counts are exact,
+ * but counters read one after the other do not form a snapshot of a single instant.
+ * @tparam NumCounters number of counters in the block, indexed from 0
+ */
+template <size_t NumCounters>
+class ShardedCounters {
+ public:
+  /** Number of shards; threads beyond this many share shards. */
+  static constexpr size_t NUM_SHARDS = 16;
+
+  /**
+   * Adds to a counter.
+   * @param counter index of the counter, less than NumCounters
+   * @param n amount to add
+   */
+  void Add(size_t counter, uint64_t n = 1) {
+    shards_[CounterShardIndex(NUM_SHARDS)].counters_[counter].fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /**
+   * @param counter index of the counter, less than NumCounters
+   * @return the sum of everything added to the counter so far
+   */
+  uint64_t Get(size_t counter) const {
+    uint64_t sum = 0;
+    for (const Shard &shard : shards_) {
+      sum += shard.counters_[counter].load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, NumCounters> counters_{};
+  };
+
+  std::array<Shard, NUM_SHARDS> shards_{};
+};
+
+}  // namespace bustub
@@ -18,6 +18,7 @@
 #include <unordered_set>
 
 #include "common/config.h"
+#include "common/rwlatch.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
@@ -105,8 +106,11 @@ class TransactionManager {
   LockManager *lock_manager_ __attribute__((__unused__));
   LogManager *log_manager_ __attribute__((__unused__));
 
-  /** The global transaction latch is used for checkpointing. */
-  ReaderWriterLatch global_txn_latch_;
+  /**
+   * The global transaction latch is used for checkpointing. Every transaction read-latches it from Begin until it
+   * commits or aborts, so it is sharded to keep transactions on different cores off each other's cache lines.
+   */
+  ShardedReaderWriterLatch global_txn_latch_;
 };
 
 }  // namespace bustub
@@ -17,8 +17,11 @@
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
+#include "storage/page/page_guard.h"
+#include "storage/page/extendible_hash_table_header_page.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
 
@@ -30,6 +33,17 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * The directory spans as many directory pages as it needs, which a header
+ * page points to (see ExtendibleHashTableHeaderPage), so the global depth can
+ * grow past what fits in one page.
+ *
+ * Lookups, inserts and removes run concurrently: they hold the table latch in
+ * shared mode and latch only the bucket page they work on, so threads that
+ * land on different buckets do not wait for each other. Splitting a bucket
+ * also runs in shared mode, under the bucket's write latch and short write
+ * latches on the directory pages. Only doubling the directory and merging
+ * buckets take the table latch exclusively.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
@@ -107,34 +121,137 @@ class ExtendibleHashTable {
    * representation.
    *
    * @param key the key to use for lookup
-   * @param dir_page to use for lookup of global depth
+   * @param header_page to use for lookup of global depth
    * @return the directory index
    */
-  uint32_t KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page);
+  uint32_t KeyToDirectoryIndex(KeyType key, const ExtendibleHashTableHeaderPage *header_page);
 
   /**
-   * Get the bucket page_id corresponding to a key.
+   * Fetches the header page from the buffer pool manager. The header page is
+   * not latched; the table latch protects it.
    *
-   * @param key the key for lookup
-   * @param dir_page a pointer to the hash table's directory page
-   * @return the bucket page_id corresponding to the input key
+   * @return a guard for the header page
    */
-  page_id_t KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page);
+  BasicPageGuard FetchHeaderPage();
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Fetches the directory page that holds a directory index from the buffer
+   * pool manager.
    *
-   * @return a pointer to the directory page
+   * @param header_page a pointer to the hash table's header page
+   * @param bucket_idx the directory index
+   * @return the directory page, pinned; the caller wraps it in a guard
    */
-  HashTableDirectoryPage *FetchDirectoryPage();
+  Page *FetchDirectoryPage(const ExtendibleHashTableHeaderPage *header_page, uint32_t bucket_idx);
 
   /**
-   * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
+   * Looks up the page id of a directory page, in the header or, past
+   * HEADER_ARRAY_SIZE directory pages, in the index page that holds it.
+   * Index pages only change under the exclusive table latch, which is why
+   * they are read without their latch.
    *
-   * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
+   * @param header_page a pointer to the hash table's header page
+   * @param directory_idx index of the directory page, below NumDirectoryPages
+   * @return the page id of the directory page
    */
-  HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
+  page_id_t GetDirectoryPageId(const ExtendibleHashTableHeaderPage *header_page, uint32_t directory_idx);
+
+  /**
+   * Fetches a page of the hash table, throwing an "out of memory" exception if
+   * the buffer pool has no frame for it. Nothing may throw between the fetch
+   * and wrapping the page in a guard.
+   *
+   * @param page_id the page_id to fetch
+   * @return the pinned page
+   */
+  Page *FetchHashTablePage(page_id_t page_id);
+
+  /**
+   * Looks up the bucket page_id at a directory index without taking the
+   * directory page's read latch, unless a split is writing to the directory
+   * page at the same time. The caller holds the table latch.
+   *
+   * @param bucket_idx the directory index
+   * @param dir_page the directory page that holds it, pinned
+   * @return the bucket page_id at the directory index
+   */
+  page_id_t LookUpBucketPageId(uint32_t bucket_idx, Page *dir_page);
+
+  /**
+   * Fetches and latches the bucket at a directory index. A split may move the
+   * index to the bucket's split image between the lookup and the latch, in
+   * which case the lookup is repeated. The caller holds the table latch.
+   *
+   * @tparam BucketGuard ReadPageGuard to read latch the bucket, WritePageGuard to write latch it
+   * @param bucket_idx the directory index
+   * @param dir_page the directory page that holds it, pinned
+   * @return a guard for the bucket page
+   */
+  template <typename BucketGuard>
+  BucketGuard LatchBucketPage(uint32_t bucket_idx, Page *dir_page);
+
+  /**
+   * Calls fn(directory, slot, bucket_idx) for the directory entries at
+   * indexes bucket_idx = first, first + stride, ... below the directory size,
+   * where directory is the directory page that holds the entry and slot its
+   * index in there. Fetches and latches one directory page at a time.
+   *
+   * @param header_page a pointer to the hash table's header page
+   * @param first the first directory index
+   * @param stride the distance between directory indexes, a power of two
+   * @param write whether fn writes to the entries, in which case the pages are write latched rather than read latched
+   * @param fn the function to call
+   */
+  template <typename EntryFn>
+  void ForEachDirectoryEntry(const ExtendibleHashTableHeaderPage *header_page, uint32_t first, uint32_t stride,
+                             bool write, EntryFn &&fn);
+
+  /**
+   * Splits a full bucket into itself and a new split image. Write latches the
+   * directory pages that point to the bucket, one at a time, to point half of
+   * its directory entries to the image. The caller holds the table latch in
+   * shared mode and the bucket's write latch, and the bucket's local depth is
+   * below the global depth.
+   *
+   * @param header_page a pointer to the hash table's header page
+   * @param bucket_idx a directory index that points to the bucket
+   * @param local_depth the local depth of the bucket
+   * @param bucket_guard the guard for the bucket
+   * @return false if the buffer pool has no frame for the split image
+   */
+  bool SplitBucket(const ExtendibleHashTableHeaderPage *header_page, uint32_t bucket_idx, uint32_t local_depth,
+                   WritePageGuard *bucket_guard);
+
+  /**
+   * Inserts a key and value into a bucket that is not full. The bucket page
+   * is only marked dirty if the pair was not there yet.
+   *
+   * @param bucket_guard the write guard for the bucket
+   * @param key the key to insert
+   * @param value the value to insert
+   * @return false if the pair is a duplicate
+   */
+  bool InsertIntoBucket(WritePageGuard *bucket_guard, const KeyType &key, const ValueType &value);
+
+  /**
+   * Doubles the directory, if the bucket a key maps to is at the global depth,
+   * so that the bucket can split. Past a single directory page, this copies
+   * every directory page. Takes the table latch exclusively.
+   *
+   * @param key the key whose bucket is to split
+   * @return false if the directory is at its largest size
+   */
+  bool GrowDirectory(const KeyType &key);
+
+  /**
+   * Halves the directory for as long as no bucket is at the global depth,
+   * deleting the directory pages that are no longer needed. The caller holds
+   * the table latch exclusively.
+   *
+   * @param header_page a pointer to the hash table's header page
+   * @return whether the directory shrank
+   */
+  bool ShrinkDirectory(ExtendibleHashTableHeaderPage *header_page);
 
   /**
    * Performs insertion with an optional bucket splitting.  If the 
@@ -152,10 +269,11 @@ class ExtendibleHashTable {
    * Optionally merges an empty bucket into it's pair.  This is called by Remove,
    * if Remove makes a bucket empty.
    *
-   * There are three conditions under which we skip the merge:
+   * There are four conditions under which we skip the merge:
    * 1. The bucket is no longer empty.
    * 2. The bucket has local depth 0.
    * 3. The bucket's local depth doesn't match its split image's local depth.
+   * 4. The bucket page cannot be deleted, because another thread has it pinned.
    * 
    * Note: we do not merge recursively.
    *
@@ -166,12 +284,14 @@ class ExtendibleHashTable {
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
   // member variables
-  page_id_t directory_page_id_;
+  page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
-  ReaderWriterLatch table_latch_;
+  // Readers include lookups, inserts, removes and bucket splits, writers are
+  // directory doubling and merges. It is taken in shared mode by every
+  // operation and rarely exclusively, hence the sharded latch.
+  ShardedReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
 };
 
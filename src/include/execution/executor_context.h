@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <memory>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "catalog/catalog.h"
 #include "concurrency/transaction.h"
 #include "storage/page/tmp_tuple_page.h"
@@ -60,6 +62,20 @@ class ExecutorContext {
   /** @return the transaction manager */
   TransactionManager *GetTransactionManager() { return txn_mgr_; }
 
+  /**
+   * @return a new buffer access strategy for a sequential scan to read its table through, or nullptr if scans should
+   * use the whole buffer pool
+   */
+  std::shared_ptr<BufferAccessStrategy> MakeScanStrategy() {
+    return use_bulk_read_strategy_ ? BufferAccessStrategy::ForBulkRead(bpm_) : nullptr;
+  }
+
+  /**
+   * Sets whether sequential scans confine large tables to a small ring of frames (the default), so that they do not
+   * evict the rest of the buffer pool.
+   */
+  void SetUseBulkReadStrategy(bool use_bulk_read_strategy) { use_bulk_read_strategy_ = use_bulk_read_strategy; }
+
  private:
   /** The transaction context associated with this executor context */
   Transaction *transaction_;
@@ -71,6 +87,8 @@ class ExecutorContext {
   TransactionManager *txn_mgr_;
   /** The lock manager associated with this executor context */
   LockManager *lock_mgr_;
+  /** True if sequential scans read through a bulk-read buffer ring */
+  bool use_bulk_read_strategy_{true};
 };
 
 }  // namespace bustub
@@ -28,10 +28,24 @@ namespace bustub {
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+  /**
+   * @param disk_manager the disk manager the log is written through
+   * @param log_buffer_size size of the log buffer and of the flush buffer in bytes, see LogBufferSizeFor
+   */
+  explicit LogManager(DiskManager *disk_manager, size_t log_buffer_size = LOG_BUFFER_SIZE)
+      : next_lsn_(0), persistent_lsn_(INVALID_LSN), log_buffer_size_(log_buffer_size), disk_manager_(disk_manager) {
+    log_buffer_ = new char[log_buffer_size_];
+    flush_buffer_ = new char[log_buffer_size_];
+  }
+
+  /**
+   * The log buffer holds one page more than the buffer pool, so that evicting every frame never has to wait for more
+   * than one log flush. Past MAX_LOG_BUFFER_SIZE a bigger buffer only delays flushes, so large pools are capped.
+   * @param pool_size number of frames in the buffer pool
+   * @return the log buffer size in bytes for a buffer pool of that size
+   */
+  static size_t LogBufferSizeFor(size_t pool_size) {
+    return std::min((pool_size + 1) * PAGE_SIZE, MAX_LOG_BUFFER_SIZE);
   }
 
   ~LogManager() {
@@ -50,6 +64,7 @@ class LogManager {
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
   inline char *GetLogBuffer() { return log_buffer_; }
+  inline size_t GetLogBufferSize() const { return log_buffer_size_; }
 
  private:
   // TODO(students): you may add your own member variables
@@ -59,6 +74,8 @@ class LogManager {
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
+  /** Size of log_buffer_ and of flush_buffer_ in bytes. */
+  size_t log_buffer_size_;
   char *log_buffer_;
   char *flush_buffer_;
 
@@ -27,9 +27,16 @@ namespace bustub {
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
+  /**
+   * @param disk_manager the disk manager the log is read through
+   * @param buffer_pool_manager the buffer pool the log is replayed into
+   * @param log_buffer_size size of the buffer the log file is read into, in bytes
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager,
+              size_t log_buffer_size = LOG_BUFFER_SIZE)
+      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0),
+        log_buffer_size_(log_buffer_size) {
+    log_buffer_ = new char[log_buffer_size_];
   }
 
   ~LogRecovery() {
@@ -48,9 +55,11 @@ class LogRecovery {
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
   /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  std::unordered_map<lsn_t, int64_t> lsn_mapping_;
 
-  int offset_ __attribute__((__unused__));
+  int64_t offset_ __attribute__((__unused__));
+  /** Size of log_buffer_ in bytes. */
+  size_t log_buffer_size_;
   char *log_buffer_;
 };
 
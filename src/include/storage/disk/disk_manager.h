@@ -13,28 +13,109 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <map>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "common/util/latency_histogram.h"
+#include "common/util/sharded_counters.h"
 
 namespace bustub {
 
+/**
+ * What a DiskManager has done since it was created, as returned by DiskManager::GetStats. Page reads and writes that
+ * a DiskScheduler issues on the disk manager's files count as well.
+ */
+struct DiskManagerStats {
+  /** Pages read from the segment files; reads past the end of the database, which read zeros, do not count. */
+  uint64_t num_reads_{0};
+  /** Pages written to the segment files. */
+  uint64_t num_writes_{0};
+  /** Bytes read from the segment files; with compression, the size of the slots read. */
+  uint64_t bytes_read_{0};
+  /** Bytes written to the segment files; with compression, the size of the slots written. */
+  uint64_t bytes_written_{0};
+  /** Times a segment file or the page map was synced, e.g. after a batch of writes. */
+  uint64_t num_syncs_{0};
+  /** Log buffer flushes. */
+  uint64_t num_log_flushes_{0};
+  /** Pages read that failed their checksum or could not be decompressed. */
+  uint64_t num_corrupt_pages_{0};
+  /** How long ReadPage calls took. */
+  LatencyHistogram::Snapshot read_latency_;
+  /** How long WritePage calls took. Pages written in a batch by WritePages are not timed one by one. */
+  LatencyHistogram::Snapshot write_latency_;
+
+  /** @return every stat on one line, e.g. for logging */
+  std::string ToString() const;
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional I/O on the database file descriptor, so page I/O from different threads,
+ * e.g. from different buffer pool instances, does not serialize on a shared file cursor.
+ *
+ * The database is split into segment files of pages_per_segment pages each: the first segment is the database file
+ * itself, segment i > 0 is the database file name followed by ".i". Segments are created, along with any missing
+ * segments before them, as pages are written to them. The number of pages per segment is recorded next to the database
+ * file, with a .seg extension, when the database is created, and reopening the database with another one throws. The
+ * end of the database is preallocated SEGMENT_PREALLOCATE_PAGES at a time with fallocate, so that it is laid out
+ * contiguously and writes past it do not allocate blocks one page at a time. All offsets and sizes are 64-bit.
+ *
+ * With direct I/O the database file is opened with O_DIRECT, so pages bypass the OS page cache and the buffer pool is
+ * the only cache holding them. Page I/O is always PAGE_SIZE bytes at PAGE_SIZE-aligned offsets; buffers that are not
+ * PAGE_SIZE-aligned, unlike buffer pool frames, go through an aligned bounce buffer.
+ *
+ * With checksums, a CRC-32C of every page written is kept in a file next to the database file, with a .crc extension,
+ * and pages are verified when they are read; a mismatch throws a CORRUPTION exception. Page layouts use every byte of
+ * the page, so the checksums are stored out of line. For each page both the checksum of its latest contents and of
+ * the contents before are kept, so that a page whose write did not complete before a crash is still accepted with its
+ * old contents, while a torn page matches neither. The checksum file is mapped into memory, so stamping a page is a
+ * store and the kernel writes the checksums back in bulk. Opening a database without checksums deletes its checksum
+ * file, so that stale checksums cannot flag pages written in the meantime.
+ *
+ * With compression, every page is compressed with LZ4 when it is written and stored in as few consecutive slots of
+ * COMPRESSION_SLOT_SIZE bytes as it fits in; pages that do not compress by at least a slot are stored as they are. The
+ * segment files then hold slots instead of pages, and a page map, kept next to the database file with a .map extension
+ * and written through on every change, records where each page's image is. Every write puts the page's new image in
+ * the best fitting run of free slots and syncs it before the map points to it; the slots of the old image are handed
+ * out again once the map is synced as well, so a crash never leaves the map pointing to a partly written image. The
+ * buffer pool still sees PAGE_SIZE pages. A database must always be opened with or without compression, as it was
+ * created. Slots are smaller than the block size O_DIRECT requires, so compression cannot be combined with direct I/O.
+ *
+ * Which pages are in use is tracked in a bitmap, the free space map, so that deallocated pages are handed out again
+ * instead of the file only growing. The map is saved next to the database file, with a .fsm extension, when the disk
+ * manager is shut down. If it was not saved cleanly, every page up to the end of the database file is assumed to be in
+ * use: pages freed since the last clean shutdown leak, but a page in use is never handed out twice.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param use_direct_io true to bypass the OS page cache for the database file; falls back to buffered I/O if the
+   * file system does not support O_DIRECT
+   * @param pages_per_segment pages per segment file; a database must always be opened with the same value, and
+   * opening it with another throws
+   * @param use_checksums true to checksum pages on write and verify them on read
+   * @param use_compression true to store pages compressed; cannot be combined with use_direct_io
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool use_direct_io = false,
+                       size_t pages_per_segment = PAGES_PER_SEGMENT, bool use_checksums = false,
+                       bool use_compression = false);
 
-  ~DiskManager() = default;
+  /** Closes the database file if ShutDown was not called. */
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -42,19 +123,55 @@ class DiskManager {
   void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Write a page to the database file. With compression the page is synced, since the page map must not point to it
+   * before it is durable.
    * @param page_id id of the page
    * @param page_data raw page data
    */
   void WritePage(page_id_t page_id, const char *page_data);
 
   /**
-   * Read a page from the database file.
+   * Write several pages and make them durable. The pages are sorted by id, every run of consecutive pages in the same
+   * segment is written with a single pwritev, and each segment written to is synced once at the end. With checksums
+   * on, the checksums of the batch are synced before any page is written. Compressed pages are synced, then the page
+   * map.
+   * @param pages id and raw data of each page; ids must be distinct
+   */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> pages);
+
+  /**
+   * Read a page from the database file. The part of the page past the end of the file reads as zeros.
+   * @throws Exception of type CORRUPTION if checksums are on and the page does not match its checksum, or if the
+   * page's compressed image cannot be decompressed
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Allocates a page, reusing a deallocated one where possible.
+   *
+   * Without near_page_id the lowest free page is returned, which keeps the file compact. With near_page_id the next
+   * free page after it in the same extent of PAGES_PER_EXTENT pages is preferred, then the start of an extent nothing
+   * is allocated in yet, so that the pages of one table or index stay contiguous on disk for sequential I/O. The hint is
+   * ignored if stride exceeds PAGES_PER_EXTENT.
+   * @param near_page_id a page the new one should follow, e.g. the last page of the same table, or INVALID_PAGE_ID
+   * @param stride only page ids with page_id % stride == offset are returned, e.g. those of one buffer pool instance
+   * @param offset see stride
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage(page_id_t near_page_id = INVALID_PAGE_ID, uint32_t stride = 1, uint32_t offset = 0);
+
+  /**
+   * Returns a page to the free space map for AllocatePage to hand out again. The page's data is left as it is, except
+   * with compression, where its slots are freed and it reads as zeros.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return true if page_id is allocated */
+  bool IsPageAllocated(page_id_t page_id);
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -69,7 +186,7 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  bool ReadLog(char *log_data, int size, int offset);
+  bool ReadLog(char *log_data, int size, int64_t offset);
 
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
@@ -80,6 +197,24 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return page I/O counts and latencies, syncs, log flushes and corrupt pages so far */
+  DiskManagerStats GetStats() const;
+
+  /** @return true if the database file was opened with O_DIRECT */
+  bool IsDirectIO() const { return direct_io_; }
+
+  /** @return true if pages are checksummed */
+  bool UsesChecksums() const { return use_checksums_; }
+
+  /** @return true if pages are stored compressed */
+  bool UsesCompression() const { return use_compression_; }
+
+  /** @return number of pages per segment file */
+  size_t GetPagesPerSegment() const { return pages_per_segment_; }
+
+  /** @return name of the file that holds segment of the database */
+  std::string GetSegmentFileName(size_t segment) const;
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -90,19 +225,137 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
-  int GetFileSize(const std::string &file_name);
+  /** Issues page reads and writes on the segment files itself, and accounts for them here. */
+  friend class DiskScheduler;
+
+  int64_t GetFileSize(const std::string &file_name);
+  /**
+   * Finds the segment file that holds a page, opening or creating it on first use. Before a write past the
+   * preallocated end of the database, preallocates the next stretch of the segment.
+   * @param page_id the page
+   * @param for_write true if the page is about to be written
+   * @param[out] offset the page's offset in the segment file
+   * @return the segment's file descriptor, -1 if it could not be opened
+   */
+  int SegmentFd(page_id_t page_id, bool for_write, int64_t *offset);
+  /** Opens or creates a segment file; the caller holds segment_latch_. */
+  int OpenSegment(size_t segment);
+  /** Closes every open segment file. */
+  void CloseSegments();
+  /** Throws if the database was created with another number of pages per segment; records it for a new database. */
+  void CheckSegmentInfo();
+  /** Opens the checksum file and maps the checksums of every page. */
+  void LoadChecksums();
+  /** Returns the checksum entry of a page, nullptr if it has none and create is false. */
+  std::atomic<uint64_t> *ChecksumEntry(page_id_t page_id, bool create);
+  /**
+   * Records the checksum of data about to be written to a page. Returns true if it changed, in which case the page may
+   * only be written after SyncChecksums.
+   */
+  bool StampChecksum(page_id_t page_id, const char *page_data);
+  /** Records the checksums of a batch of pages about to be written and syncs them to disk ahead of the pages. */
+  void StampChecksums(const std::vector<std::pair<page_id_t, const char *>> &pages);
+  /** Syncs the checksum file. */
+  void SyncChecksums();
+  /** Throws a CORRUPTION exception if data read from a page does not match the page's checksum. */
+  void VerifyChecksum(page_id_t page_id, const char *page_data);
+  /** Opens the page map and loads where every compressed page is, and which slots are in use. */
+  void LoadPageMap();
+  /** Compresses pages, writes each to newly allocated slots, syncs them and only then points the page map to them. */
+  void WriteCompressedPages(const std::vector<std::pair<page_id_t, const char *>> &pages);
+  /** Reads and decompresses a page. Returns false, with page_data zeroed, if the page was never written. */
+  bool ReadCompressedPage(page_id_t page_id, char *page_data);
+  /** Reads or writes size bytes at a slot. Returns false on an I/O error. Reads past the end of the file read zeros. */
+  bool SlotIo(bool write, int64_t slot, char *data, size_t size);
+  /** Returns the page map entry of a page; the caller holds page_map_latch_. */
+  uint64_t PageMapEntry(page_id_t page_id) const;
+  /** Sets the page map entry of a page and writes it through; the caller holds page_map_latch_. */
+  void SetPageMapEntry(page_id_t page_id, uint64_t entry);
+  /** Returns the first of num_slots consecutive free slots within a segment and marks them used; the caller holds
+   * page_map_latch_. */
+  int64_t AllocateSlots(int64_t num_slots);
+  /** Marks num_slots slots from slot on, all in the same segment, free; the caller holds page_map_latch_. */
+  void FreeSlots(int64_t slot, int64_t num_slots);
+  /** Loads the free space map, or rebuilds it from the database file size if it was not saved cleanly. */
+  void LoadFreeSpaceMap();
+  /** Writes the free space map out and marks it clean. */
+  void SaveFreeSpaceMap();
+  /** Returns true if page_id is allocated; the caller holds fsm_latch_. */
+  bool IsAllocated(page_id_t page_id) const;
+  /** Marks page_id allocated or free; the caller holds fsm_latch_. */
+  void SetAllocated(page_id_t page_id, bool allocated);
+  /** Returns true if no page of the extent starting at page_id is allocated; the caller holds fsm_latch_. */
+  bool IsExtentFree(page_id_t page_id) const;
+  /** Returns the lowest free page at or after page_id; the caller holds fsm_latch_. */
+  page_id_t NextFreePage(page_id_t page_id) const;
+
+  /** Records that the db file is now at least size bytes long. */
+  void ExtendFileSize(int64_t size);
+
+  /** Indexes of the event counters in counters_; see DiskManagerStats for what they count. */
+  enum Counter : size_t { READS, WRITES, BYTES_READ, BYTES_WRITTEN, SYNCS, CORRUPT_PAGES, NUM_COUNTERS };
+
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // pages per segment file
+  size_t pages_per_segment_;
+  // file the number of pages per segment is recorded in
+  std::string segment_info_name_;
+  // file descriptor of each segment file, read and written with pread/pwrite; -1 until the segment is opened
+  std::unique_ptr<std::atomic<int>[]> segment_fds_;
+  // protects opening segments and preallocating them
+  std::mutex segment_latch_;
+  // true if the segment files are opened with O_DIRECT
+  bool direct_io_{false};
   std::string file_name_;
+  // size of the database across all segments, kept up to date by WritePage so that reads need not stat the files
+  std::atomic<int64_t> db_file_size_{0};
+  // the database is preallocated up to this size, across all segments
+  std::atomic<int64_t> preallocated_size_{0};
+  // true if pages are checksummed
+  bool use_checksums_{false};
+  // file the checksums are stored in
+  std::string checksum_name_;
+  int checksum_fd_{-1};
+  // the checksum of each page, in chunks of the checksum file mapped on first use: the latest in the low 32 bits and
+  // the one before it in the high 32 bits; 0 if the page has none
+  std::unique_ptr<std::atomic<std::atomic<uint64_t> *>[]> checksum_chunks_;
+  // protects mapping checksum chunks
+  std::mutex checksum_latch_;
+  // true if pages are stored compressed
+  bool use_compression_{false};
+  // file the page map is written through to
+  std::string page_map_name_;
+  int page_map_fd_{-1};
+  // protects the page map and the slot usage below
+  std::mutex page_map_latch_;
+  // where each page is stored: its first slot in the high bits and the length of its image in the low bits; 0 if the
+  // page was never written
+  std::vector<uint64_t> page_map_;
+  // runs of free slots below end_slot_, none straddling two segments: the length of each by its first slot
+  std::map<int64_t, int64_t> free_runs_;
+  // the same runs as (length, first slot) pairs, for best fit
+  std::set<std::pair<int64_t, int64_t>> free_runs_by_size_;
+  // no slot from this one on is in use
+  int64_t end_slot_{0};
+  // file the free space map is saved to
+  std::string fsm_name_;
+  // protects the free space map
+  std::mutex fsm_latch_;
+  // the free space map: bit i of word i / 64 is set if page i is allocated; pages past the end are free
+  std::vector<uint64_t> allocated_;
+  // no page below this one is free
+  page_id_t first_free_page_{0};
+  // no extent below the one starting at this page is free; allocations move it up lazily
+  page_id_t first_free_extent_{0};
   int num_flushes_;
-  int num_writes_;
+  // event counters, sharded by thread since every page I/O of every thread updates them
+  ShardedCounters<NUM_COUNTERS> counters_;
+  LatencyHistogram read_latency_;
+  LatencyHistogram write_latency_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
 };
 
 }  // namespace bustub
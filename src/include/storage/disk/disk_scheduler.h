@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.h
+//
+// Identification: src/include/storage/disk/disk_scheduler.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * A page read or write for the DiskScheduler.
+ */
+struct DiskRequest {
+  /** True for a write, false for a read. */
+  bool is_write_;
+  /** PAGE_SIZE bytes to write from or read into. Must stay valid until callback_ is satisfied. */
+  char *data_;
+  /** The page to read or write. */
+  page_id_t page_id_;
+  /** Set to true once the request has completed, or to the exception of a read page that failed its checksum. */
+  std::promise<bool> callback_;
+  /** If true, the next request of the same batch only starts once this one has completed. */
+  bool before_next_{false};
+};
+
+/**
+ * DiskScheduler executes page reads and writes on a DiskManager's database file in the background. Callers submit
+ * requests and continue; each request's promise is satisfied when it completes.
+ *
+ * Requests are executed through io_uring when the kernel provides it: the requests that are queued when the I/O
+ * thread gets to them go to the kernel in one submission. Otherwise a small pool of threads executes them with the
+ * DiskManager's synchronous calls, which is also how requests on a compressed database are executed. Reads past the end
+ * of the file read as zeros either way.
+ */
+class DiskScheduler {
+ public:
+  /**
+   * Creates a new DiskScheduler and starts its I/O threads.
+   * @param disk_manager the disk manager whose database file requests go to
+   * @param queue_depth maximum number of requests in flight at once, and largest allowed batch
+   * @param use_io_uring false to use the thread pool even where io_uring is available
+   */
+  explicit DiskScheduler(DiskManager *disk_manager, size_t queue_depth = DISK_SCHEDULER_QUEUE_DEPTH,
+                         bool use_io_uring = true);
+
+  /** Completes every submitted request, then stops the I/O threads. */
+  ~DiskScheduler();
+
+  DiskScheduler(const DiskScheduler &) = delete;
+  DiskScheduler &operator=(const DiskScheduler &) = delete;
+
+  /**
+   * Submits one request and returns without waiting for it.
+   * @param request the request; get its future from callback_ before handing it over
+   */
+  void Schedule(DiskRequest request);
+
+  /**
+   * Submits requests together, so that they reach the disk in one submission where possible, and returns without
+   * waiting for them. Requests run concurrently unless ordered with before_next_.
+   * @param requests the requests, at most the queue depth
+   */
+  void Schedule(std::vector<DiskRequest> requests);
+
+  /** @return a promise for a DiskRequest's callback_ */
+  std::promise<bool> CreatePromise() { return {}; }
+
+  /** @return the largest batch Schedule accepts */
+  size_t GetQueueDepth() const { return queue_depth_; }
+
+  /** @return true if requests are executed through io_uring, false if by the thread pool */
+  bool UsesIoUring() const { return ring_ != nullptr; }
+
+  /** @return number of times requests were handed to the kernel, one per batch with io_uring */
+  size_t GetNumSubmissions() const { return num_submissions_.load(std::memory_order_relaxed); }
+
+  /** @return number of requests completed so far */
+  size_t GetNumCompleted() const { return num_completed_.load(std::memory_order_relaxed); }
+
+ private:
+  class IoUring;
+
+  /** Requests that run one after the other; a batch is split into chains at every request without before_next_. */
+  using Chain = std::vector<DiskRequest>;
+
+  /** Body of the io_uring I/O thread: submits everything queued in one go and reaps the completions. */
+  void IoUringWorkerLoop();
+
+  /** Body of a thread pool I/O thread: runs one chain at a time with synchronous DiskManager calls. */
+  void ThreadPoolWorkerLoop();
+
+  /** Executes a request with the DiskManager's synchronous calls and satisfies its promise. */
+  void ExecuteSynchronously(DiskRequest *request);
+
+  /** Satisfies a request's promise after the kernel completed it with result res. */
+  void Complete(DiskRequest *request, int res);
+
+  DiskManager *disk_manager_;
+  size_t queue_depth_;
+  std::unique_ptr<IoUring> ring_;
+
+  /** Protects the queue below. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<Chain> queue_;
+  bool stopped_{false};
+  std::vector<std::thread> workers_;
+
+  std::atomic<size_t> num_submissions_{0};
+  std::atomic<size_t> num_completed_{0};
+};
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
@@ -98,6 +99,12 @@ class BPlusTree {
 
   void UpdateRootPageId(int insert_record = 0);
 
+  bool FindLeafPageOptimistic(const KeyType &key, bool leftMost, Page **leaf);
+
+  Page *FindLeafPagePessimistic(const KeyType &key, bool leftMost);
+
+  Page *FetchTreePage(page_id_t page_id, Page *parent = nullptr, bool parent_latched = false);
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
 
@@ -105,7 +112,9 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // Read without a latch by lookups, which check it again once they hold the
+  // root. Writers change it only while holding the old root's write latch.
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
@@ -13,6 +13,9 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <atomic>
+#include <memory>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -21,23 +24,58 @@ namespace bustub {
 
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
+  /** Creates the end iterator. */
   IndexIterator();
+  /**
+   * Creates an iterator positioned at the index-th item of a leaf, read-latching the leaf for as long as the iterator
+   * stays on it. Positions past the end of the leaf move on to the next non-empty leaf.
+   * @throw Exception OUT_OF_MEMORY if no frame is left for a leaf; so does operator++
+   */
+  IndexIterator(BufferPoolManager *buffer_pool_manager, page_id_t leaf_page_id, int index);
   ~IndexIterator();  // NOLINT
 
+  IndexIterator(IndexIterator &&that) noexcept = default;
+  IndexIterator &operator=(IndexIterator &&that) noexcept = default;
+
   bool IsEnd();
 
   const MappingType &operator*();
 
   IndexIterator &operator++();
 
-  bool operator==(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator==(const IndexIterator &itr) const { return page_id_ == itr.page_id_ && index_ == itr.index_; }
 
-  bool operator!=(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator!=(const IndexIterator &itr) const { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  /** Moves to the next non-empty leaf while index_ is past the end of the current one, reading ahead the chain. */
+  void SkipExhaustedLeaves();
+
+  /** Read-latches a leaf, throwing if no frame is left for it. */
+  ReadPageGuard FetchLeaf(page_id_t page_id);
+
+  /**
+   * Reads ahead the leaves that entered the window since the last request, unless that request is still running; the
+   * next step tries again.
+   */
+  void ExtendReadAhead();
+
+  const LeafPage *Leaf() { return guard_.As<LeafPage>(); }
+
+  /** read_ahead_end_ holds this while a read-ahead request is running. */
+  static constexpr page_id_t READ_AHEAD_PENDING = INVALID_PAGE_ID - 1;
+
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  ReadPageGuard guard_;
+  page_id_t page_id_{INVALID_PAGE_ID};
+  int index_{0};
+  // the first leaf past the read-ahead window, set by the prefetch worker once it has read the window in
+  std::shared_ptr<std::atomic<page_id_t>> read_ahead_end_;
+  // leaves that entered the window and were not read ahead yet
+  size_t read_ahead_owed_{0};
 };
 
 }  // namespace bustub
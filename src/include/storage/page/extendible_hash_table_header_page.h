@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_header_page.h
+//
+// Identification: src/include/storage/page/extendible_hash_table_header_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ * Header Page for extendible hash table.
+ *
+ * The directory of an extendible hash table spans directory pages of DIRECTORY_ARRAY_SIZE entries each: directory
+ * index i lives at index i % DIRECTORY_ARRAY_SIZE of directory page i / DIRECTORY_ARRAY_SIZE. Up to a global depth of
+ * HashTableDirectoryPage::MAX_GLOBAL_DEPTH the directory is a single page, which doubles in place; past it, doubling
+ * the directory doubles the number of directory pages. The header holds the global depth and the page ids of up to
+ * HEADER_ARRAY_SIZE directory pages. Past that many, the header holds the page ids of index pages instead, which have
+ * the layout of a header page and hold the page ids of HEADER_ARRAY_SIZE directory pages each: directory page j is at
+ * index j % HEADER_ARRAY_SIZE of index page j / HEADER_ARRAY_SIZE. The hash table resolves this extra level; to the
+ * header, they are all page ids.
+ *
+ * Header format (size in byte, for 4 KB pages; the array scales with PAGE_SIZE, see HEADER_ARRAY_SIZE):
+ * ------------------------------------------------------------------------
+ * | PageId(4) | LSN (4) | GlobalDepth(4) | DirectoryPageIds(2048) | Free(2036)
+ * ------------------------------------------------------------------------
+ */
+class ExtendibleHashTableHeaderPage {
+ public:
+  /**
+   * The largest global depth, at which the header points to HEADER_ARRAY_SIZE full index pages. Directory indexes
+   * are 32-bit, hence the cap.
+   */
+  static constexpr uint32_t MAX_GLOBAL_DEPTH =
+      std::min<uint32_t>(__builtin_ctzll(DIRECTORY_ARRAY_SIZE) + 2 * __builtin_ctzll(HEADER_ARRAY_SIZE), 31);
+
+  /**
+   * @return the page ID of this page
+   */
+  page_id_t GetPageId() const;
+
+  /**
+   * Sets the page ID of this page
+   *
+   * @param page_id the page id to which to set the page_id_ field
+   */
+  void SetPageId(page_id_t page_id);
+
+  /**
+   * @return the lsn of this page
+   */
+  lsn_t GetLSN() const;
+
+  /**
+   * Sets the LSN of this page
+   *
+   * @param lsn the log sequence number to which to set the lsn field
+   */
+  void SetLSN(lsn_t lsn);
+
+  /**
+   * @return the global depth of the hash table directory
+   */
+  uint32_t GetGlobalDepth() const;
+
+  /**
+   * @return mask of global_depth 1's and the rest 0's (with 1's from LSB upwards)
+   */
+  uint32_t GetGlobalDepthMask() const;
+
+  /**
+   * Increment the global depth of the directory. Adding the directory pages this takes is up to the caller.
+   */
+  void IncrGlobalDepth();
+
+  /**
+   * Decrement the global depth of the directory. Dropping the directory pages this frees is up to the caller.
+   */
+  void DecrGlobalDepth();
+
+  /**
+   * @return the current directory size, in entries
+   */
+  uint32_t Size() const;
+
+  /**
+   * @return the number of directory pages the directory takes at its current size
+   */
+  uint32_t NumDirectoryPages() const;
+
+  /**
+   * @param directory_idx index into the header's array, below NumDirectoryPages and HEADER_ARRAY_SIZE
+   * @return the page id of that directory page, or of that index page past HEADER_ARRAY_SIZE directory pages
+   */
+  page_id_t GetDirectoryPageId(uint32_t directory_idx) const;
+
+  /**
+   * Sets the page id of a directory page, or of an index page
+   *
+   * @param directory_idx index into the header's array
+   * @param directory_page_id the page id
+   */
+  void SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id);
+
+  /**
+   * @param bucket_idx an index into the whole directory
+   * @return the index of the directory page that holds the entry
+   */
+  static uint32_t DirectoryIndex(uint32_t bucket_idx) { return bucket_idx / DIRECTORY_ARRAY_SIZE; }
+
+  /**
+   * @param bucket_idx an index into the whole directory
+   * @return the index of the entry within its directory page
+   */
+  static uint32_t DirectorySlot(uint32_t bucket_idx) { return bucket_idx % DIRECTORY_ARRAY_SIZE; }
+
+ private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t global_depth_{0};
+  page_id_t directory_page_ids_[HEADER_ARRAY_SIZE];
+};
+
+static_assert(sizeof(ExtendibleHashTableHeaderPage) <= PAGE_SIZE, "the header must fit in a page");
+
+}  // namespace bustub
@@ -45,7 +45,7 @@ class HashTableBucketPage {
    *
    * @return true if at least one key matched
    */
-  bool GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result);
+  bool GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) const;
 
   /**
    * Attempts to insert a key and value in the bucket.  Uses the occupied_
@@ -65,6 +65,25 @@ class HashTableBucketPage {
    */
   bool Remove(KeyType key, ValueType value, KeyComparator cmp);
 
+  /**
+   * Finds the slot that a key and value would be inserted into, without changing the bucket.
+   *
+   * @return the first available slot, or BUCKET_ARRAY_SIZE if the pair is a duplicate or the bucket is full
+   */
+  uint32_t FindInsertSlot(KeyType key, ValueType value, KeyComparator cmp) const;
+
+  /**
+   * Stores a key and value in a slot found by FindInsertSlot.
+   */
+  void InsertAt(uint32_t bucket_idx, KeyType key, ValueType value);
+
+  /**
+   * Finds the slot holding a key and value, without changing the bucket.
+   *
+   * @return the slot, or BUCKET_ARRAY_SIZE if not found
+   */
+  uint32_t FindSlot(KeyType key, ValueType value, KeyComparator cmp) const;
+
   /**
    * Gets the key at an index in the bucket.
    *
@@ -121,17 +140,17 @@ class HashTableBucketPage {
   /**
    * @return the number of readable elements, i.e. current size
    */
-  uint32_t NumReadable();
+  uint32_t NumReadable() const;
 
   /**
    * @return whether the bucket is full
    */
-  bool IsFull();
+  bool IsFull() const;
 
   /**
    * @return whether the bucket is empty
    */
-  bool IsEmpty();
+  bool IsEmpty() const;
 
   /**
    * Prints the bucket's occupancy information
@@ -139,6 +158,9 @@ class HashTableBucketPage {
   void PrintBucket();
 
  private:
+  static_assert(2 * ((BUCKET_ARRAY_SIZE - 1) / 8 + 1) + BUCKET_ARRAY_SIZE * sizeof(MappingType) <= PAGE_SIZE,
+                "the bucket must fit in a page");
+
   // For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
   char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
@@ -26,13 +26,20 @@ namespace bustub {
  *
  * Directory Page for extendible hash table.
  *
- * Directory format (size in byte):
+ * Up to a global depth of MAX_GLOBAL_DEPTH the whole directory is one page. Deeper directories span several pages,
+ * each a full page of entries with the global depth left at MAX_GLOBAL_DEPTH, which an
+ * ExtendibleHashTableHeaderPage points to.
+ *
+ * Directory format (size in byte, for 4 KB pages; the arrays scale with PAGE_SIZE, see DIRECTORY_ARRAY_SIZE):
  * --------------------------------------------------------------------------------------------
  * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | Free(1524)
  * --------------------------------------------------------------------------------------------
  */
 class HashTableDirectoryPage {
  public:
+  /** The largest global depth of a single page directory, at which the directory fills the page. */
+  static constexpr uint32_t MAX_GLOBAL_DEPTH = __builtin_ctzll(DIRECTORY_ARRAY_SIZE);
+
   /**
    * @return the page ID of this page
    */
@@ -114,7 +121,8 @@ class HashTableDirectoryPage {
   uint32_t GetGlobalDepth();
 
   /**
-   * Increment the global depth of the directory
+   * Increment the global depth of the directory, doubling it. The new half points to the same buckets as the old one.
+   * The global depth must be below MAX_GLOBAL_DEPTH.
    */
   void IncrGlobalDepth();
 
@@ -194,4 +202,6 @@ class HashTableDirectoryPage {
   page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
 };
 
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE, "the directory must fit in a page");
+
 }  // namespace bustub
@@ -32,7 +32,21 @@
  * Extendible Hashing Definitions
  */
 #define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
-#define DIRECTORY_ARRAY_SIZE 512
+
+/**
+ * DIRECTORY_ARRAY_SIZE is the number of buckets an extendible hashing directory page can point to. Each takes one byte
+ * of local depth and a four byte page id after the 12 byte header, so PAGE_SIZE / 8 is the largest power of two that
+ * fits, as the directory doubles in size.
+ */
+#define DIRECTORY_ARRAY_SIZE (PAGE_SIZE / 8)
+
+/**
+ * HEADER_ARRAY_SIZE is the number of directory pages an extendible hashing header page can point to. Each takes a four
+ * byte page id after the 12 byte header, so PAGE_SIZE / 8 is the largest power of two that fits, as the directory
+ * doubles in size. Past that many directory pages, the header points to as many index pages, which point to
+ * HEADER_ARRAY_SIZE directory pages each.
+ */
+#define HEADER_ARRAY_SIZE (PAGE_SIZE / 8)
 
 /**
  * BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hashing bucket page.
@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <new>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -30,29 +33,54 @@ class Page {
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor for a page outside any buffer pool. Allocates zeroed, PAGE_SIZE-aligned data owned by the page. */
+  Page() : data_(new (std::align_val_t{PAGE_SIZE}) char[PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() = default;
+  /**
+   * Constructor for a buffer pool frame. Zeros out the page data.
+   * @param data PAGE_SIZE bytes of frame data, owned by the buffer pool and outliving the page
+   */
+  explicit Page(char *data) : data_(data) { ResetMemory(); }
+
+  /** Destructor. Frees the data if the page owns it. */
+  ~Page() {
+    if (owns_data_) {
+      operator delete[](data_, std::align_val_t{PAGE_SIZE});
+    }
+  }
+
+  Page(const Page &) = delete;
+  Page &operator=(const Page &) = delete;
 
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
 
   /** @return the page id of this page */
-  inline page_id_t GetPageId() { return page_id_; }
+  inline page_id_t GetPageId() { return page_id_.load(std::memory_order_acquire); }
 
   /** @return the pin count of this page */
-  inline int GetPinCount() { return pin_count_; }
+  inline int GetPinCount() {
+    int pin_count = pin_count_.load(std::memory_order_acquire);
+    return pin_count < 0 ? 0 : pin_count;
+  }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
-  inline bool IsDirty() { return is_dirty_; }
+  inline bool IsDirty() { return is_dirty_.load(std::memory_order_acquire); }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    // An odd version tells optimistic readers that a writer is in. The fence keeps the writer's stores to the data
+    // from becoming visible before the version does.
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +88,30 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Starts an optimistic read: instead of taking the read latch, which writes to the latch's cache line, the reader
+   * notes the page's version, reads the data, and checks with ValidateOptimisticRead that no writer latched the page
+   * in between. Until it is validated, what was read may be torn, so it must not be acted upon, and offsets read from
+   * the page must be bounds checked before they are followed. The caller must hold a pin.
+   * @param[out] version the version to validate against
+   * @return false if a writer holds the latch, in which case the read is bound to fail validation
+   */
+  inline bool TryOptimisticRead(uint64_t *version) {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * Ends an optimistic read started by TryOptimisticRead. Can be called several times to validate reads made so far.
+   * @param version the version TryOptimisticRead returned
+   * @return true if no writer latched the page since, i.e. everything read since then is consistent
+   */
+  inline bool ValidateOptimisticRead(uint64_t version) {
+    // Keeps the reads of the data from being reordered after the version check.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -74,20 +126,30 @@ class Page {
   static constexpr size_t OFFSET_PAGE_START = 0;
   static constexpr size_t OFFSET_LSN = 4;
 
+  /**
+   * Pin count of a frame that is not available for pinning: it is on the free list or being (re)filled under the
+   * buffer pool latch. Lock-free pinning only ever increments a non-negative pin count.
+   */
+  static constexpr int PIN_COUNT_LOCKED = -1;
+
  private:
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The actual data that is stored within a page. Frames point into the buffer pool's FrameArena. */
+  char *data_;
+  /** True if data_ was allocated by the page itself. */
+  bool owns_data_{false};
+  /** The ID of this page. Read without the buffer pool latch to validate lock-free page table hits. */
+  std::atomic<page_id_t> page_id_ = INVALID_PAGE_ID;
+  /** The pin count of this page, or PIN_COUNT_LOCKED. */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Bumped when the write latch is taken and again when it is released, so it is odd while a writer is in. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns one pin on a buffer pool page and releases it when it goes out of scope.
+ *
+ * Guards are move-only. Accessing the page through GetDataMut/AsMut marks it dirty, so the pin is released with the
+ * right dirty flag without the caller having to track it. A default-constructed or moved-from guard is empty and
+ * releases nothing.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+  /** Takes over that's pin, leaving that empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Releases the current pin, if any, and takes over that's pin. */
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  /** Releases the pin, if any. */
+  ~BasicPageGuard();
+
+  /** Unpins the page now rather than at the end of the scope. Safe to call more than once. */
+  void Drop();
+
+  /**
+   * Read-latches the page and hands the pin over to a ReadPageGuard. This guard is empty afterwards.
+   * @return the read guard
+   */
+  ReadPageGuard UpgradeRead();
+
+  /**
+   * Write-latches the page and hands the pin over to a WritePageGuard. This guard is empty afterwards.
+   * @return the write guard
+   */
+  WritePageGuard UpgradeWrite();
+
+  /** @return true if the guard holds a page, false if it is empty or the buffer pool had no frame for it */
+  bool IsValid() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return page_->GetPageId(); }
+
+  /** @return the guarded page's data, read-only */
+  const char *GetData() { return page_->GetData(); }
+
+  /** @return the guarded page's data as a T, read-only */
+  template <class T>
+  const T *As() {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @return the guarded page's data, marking the page dirty */
+  char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** @return the guarded page's data as a T, marking the page dirty */
+  template <class T>
+  T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard holds one pin and the read latch on a page. Both are released, latch first, when it is dropped.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** Wraps a page that the caller has already pinned and read-latched. */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Releases the current latch and pin, if any, and takes over that's. */
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  /** Releases the latch and the pin, if any. */
+  ~ReadPageGuard();
+
+  /** Releases the latch and the pin now. Safe to call more than once. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the guarded page's data */
+  const char *GetData() { return guard_.GetData(); }
+
+  /** @return the guarded page's data as a T */
+  template <class T>
+  const T *As() {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds one pin and the write latch on a page. Both are released, latch first, when it is dropped.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** Wraps a page that the caller has already pinned and write-latched. */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Releases the current latch and pin, if any, and takes over that's. */
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  /** Releases the latch and the pin, if any. */
+  ~WritePageGuard();
+
+  /** Releases the latch and the pin now. Safe to call more than once. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the guarded page's data, read-only */
+  const char *GetData() { return guard_.GetData(); }
+
+  /** @return the guarded page's data as a T, read-only */
+  template <class T>
+  const T *As() {
+    return guard_.As<T>();
+  }
+
+  /** @return the guarded page's data, marking the page dirty */
+  char *GetDataMut() { return guard_.GetDataMut(); }
+
+  /** @return the guarded page's data as a T, marking the page dirty */
+  template <class T>
+  T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
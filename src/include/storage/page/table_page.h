@@ -60,7 +60,12 @@ class TablePage : public Page {
   page_id_t GetPrevPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
 
   /** @return the page ID of the next table page */
-  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+  page_id_t GetNextPageId() { return NextPageIdOf(GetData()); }
+
+  /** @return the page ID of the next table page, read out of a table page's raw data (for read-ahead) */
+  static page_id_t NextPageIdOf(const char *data) {
+    return *reinterpret_cast<const page_id_t *>(data + OFFSET_NEXT_PAGE_ID);
+  }
 
   /** Set the page id of the previous page in the table. */
   void SetPrevPageId(page_id_t prev_page_id) {
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -99,8 +101,12 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * @param txn the transaction scanning the table
+   * @param strategy the buffer access strategy the scan reads pages through, nullptr to use the whole pool
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   /** @return the end iterator of this table */
   TableIterator End();
@@ -12,8 +12,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <memory>
+#include <utility>
 
+#include "buffer/buffer_access_strategy.h"
+#include "common/config.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,10 +34,24 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  /**
+   * Creates an iterator positioned at rid.
+   * @param table_heap the table to scan
+   * @param rid the first tuple, or an invalid RID for the end iterator
+   * @param txn the transaction scanning the table
+   * @param strategy the buffer access strategy pages are read through, nullptr to use the whole pool
+   * @throw Exception OUT_OF_MEMORY from operator++ if no frame is left for a page
+   */
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        read_ahead_end_(other.read_ahead_end_),
+        read_ahead_owed_(other.read_ahead_owed_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +71,30 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    read_ahead_end_ = other.read_ahead_end_;
+    read_ahead_owed_ = other.read_ahead_owed_;
     return *this;
   }
 
  private:
+  /**
+   * Reads ahead the pages that entered the window since the last request, unless that request is still running; the
+   * next step tries again.
+   */
+  void ExtendReadAhead();
+
+  /** read_ahead_end_ holds this while a read-ahead request is running. */
+  static constexpr page_id_t READ_AHEAD_PENDING = INVALID_PAGE_ID - 1;
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  // the first page past the read-ahead window, set by the prefetch worker once it has read the window in
+  std::shared_ptr<std::atomic<page_id_t>> read_ahead_end_;
+  // pages that entered the window and were not read ahead yet
+  size_t read_ahead_owed_{0};
 };
 
 }  // namespace bustub
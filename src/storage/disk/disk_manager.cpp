@@ -10,34 +10,110 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cerrno>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
-#include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c.h"
+#include "lz4/lz4.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+/** Start of the free space map file. The bitmap words follow it. */
+struct FreeSpaceMapHeader {
+  uint64_t magic_;
+  /** 1 if the bitmap was written out completely at shutdown. */
+  uint64_t clean_;
+  uint64_t num_words_;
+};
+
+static constexpr uint64_t FSM_MAGIC = 0x4d53464255545342;  // "BSTUBFSM"
+
+/** Contents of the segment info file, which records how the database is split into segments. */
+struct SegmentInfo {
+  uint64_t magic_;
+  uint64_t pages_per_segment_;
+};
+
+static constexpr uint64_t SEGMENT_MAGIC = 0x4745534255545342;  // "BSTUBSEG"
+static constexpr int BITS_PER_WORD = 64;
+static_assert(BITS_PER_WORD % PAGES_PER_EXTENT == 0, "an extent must not straddle two bitmap words");
+
+static constexpr size_t CHECKSUMS_PER_CHUNK = 1 << 16;
+static constexpr size_t NUM_CHECKSUM_CHUNKS = (static_cast<size_t>(INT32_MAX) + 1) / CHECKSUMS_PER_CHUNK;
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free,
+              "checksum entries are stored in the mapped checksum file as they are");
+
+/** With compression, the segment files are addressed in blocks of PAGE_SIZE bytes, each made up of slots. */
+static constexpr int64_t SLOTS_PER_BLOCK = PAGE_SIZE / COMPRESSION_SLOT_SIZE;
+/** A page map entry holds the page's first slot above these bits and the length of its image in them. */
+static constexpr int PAGE_MAP_LENGTH_BITS = 24;
+static_assert(PAGE_SIZE < (1 << PAGE_MAP_LENGTH_BITS), "an image length must fit in its bits of a page map entry");
+
+static int64_t EntrySlot(uint64_t entry) { return static_cast<int64_t>(entry >> PAGE_MAP_LENGTH_BITS); }
+static size_t EntryLength(uint64_t entry) { return entry & ((uint64_t{1} << PAGE_MAP_LENGTH_BITS) - 1); }
+static int64_t EntrySlots(uint64_t entry) {
+  return static_cast<int64_t>((EntryLength(entry) + COMPRESSION_SLOT_SIZE - 1) / COMPRESSION_SLOT_SIZE);
+}
+
+/** @return the checksum stored for a page's data; never 0, which marks a page without checksum */
+static uint32_t PageChecksum(const char *page_data) {
+  uint32_t checksum = Crc32c::Compute(page_data, PAGE_SIZE);
+  return checksum == 0 ? 1 : checksum;
+}
+
+/** @return true if data can be handed to O_DIRECT I/O as is */
+static bool IsPageAligned(const char *data) { return reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0; }
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool use_direct_io, size_t pages_per_segment, bool use_checksums,
+                         bool use_compression)
+    : pages_per_segment_(pages_per_segment),
+      segment_fds_(new std::atomic<int>[MAX_DB_SEGMENTS]),
+      file_name_(db_file),
+      num_flushes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr) {
+  for (size_t i = 0; i < MAX_DB_SEGMENTS; i++) {
+    segment_fds_[i] = -1;
+  }
+  // Slots are smaller than the logical block size O_DIRECT needs its offsets and sizes aligned to.
+  if (use_direct_io && use_compression) {
+    throw Exception("compression does not support direct I/O");
+  }
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  fsm_name_ = file_name_.substr(0, n) + ".fsm";
+  checksum_name_ = file_name_.substr(0, n) + ".crc";
+  page_map_name_ = file_name_.substr(0, n) + ".map";
+  segment_info_name_ = file_name_.substr(0, n) + ".seg";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -53,30 +129,92 @@ DiskManager::DiskManager(const std::string &db_file)
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  // create the file if it does not exist
+  int db_fd = -1;
+  if (use_direct_io) {
+    db_fd = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd >= 0;
+    if (db_fd < 0 && errno == EINVAL) {
+      LOG_WARN("O_DIRECT not supported for %s, using buffered I/O", db_file.c_str());
+    }
+  }
+  if (db_fd < 0) {
+    db_fd = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd < 0) {
+    throw Exception("can't open db file");
+  }
+  segment_fds_[0] = db_fd;
+
+  // The database ends in the last segment file there is.
+  size_t last_segment = 0;
+  {
+    std::scoped_lock lock(segment_latch_);
+    while (last_segment + 1 < MAX_DB_SEGMENTS && access(GetSegmentFileName(last_segment + 1).c_str(), F_OK) == 0 &&
+           OpenSegment(last_segment + 1) >= 0) {
+      last_segment++;
     }
   }
+  struct stat stat_buf;
+  if (fstat(segment_fds_[last_segment], &stat_buf) == 0) {
+    db_file_size_ = static_cast<int64_t>(last_segment * pages_per_segment_) * PAGE_SIZE + stat_buf.st_size;
+  }
+  preallocated_size_ = db_file_size_.load();
+  CheckSegmentInfo();
+  // Only compressed databases have a page map; one next to an empty database file is left over from a removed one.
+  if (db_file_size_ > 0 && (access(page_map_name_.c_str(), F_OK) == 0) != use_compression) {
+    CloseSegments();
+    throw Exception(use_compression ? "db file is not compressed" : "db file is compressed");
+  }
+  if (use_compression) {
+    LoadPageMap();
+  } else {
+    remove(page_map_name_.c_str());
+  }
+  LoadFreeSpaceMap();
+  if (use_checksums) {
+    LoadChecksums();
+  } else {
+    remove(checksum_name_.c_str());
+  }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  if (segment_fds_[0] >= 0) {
+    SaveFreeSpaceMap();
+    CloseSegments();
+  }
+  if (checksum_fd_ >= 0) {
+    close(checksum_fd_);
+  }
+  if (page_map_fd_ >= 0) {
+    close(page_map_fd_);
+  }
+  if (checksum_chunks_ != nullptr) {
+    for (size_t i = 0; i < NUM_CHECKSUM_CHUNKS; i++) {
+      if (std::atomic<uint64_t> *chunk = checksum_chunks_[i].load(); chunk != nullptr) {
+        munmap(chunk, CHECKSUMS_PER_CHUNK * sizeof(uint64_t));
+      }
+    }
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  if (segment_fds_[0] >= 0) {
+    SaveFreeSpaceMap();
+    CloseSegments();
+  }
+  if (checksum_fd_ >= 0) {
+    close(checksum_fd_);
+    checksum_fd_ = -1;
+  }
+  if (page_map_fd_ >= 0) {
+    close(page_map_fd_);
+    page_map_fd_ = -1;
   }
   log_io_.close();
 }
@@ -85,48 +223,347 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  ScopedLatencyTimer timer(&write_latency_);
+  if (StampChecksum(page_id, page_data)) {
+    SyncChecksums();
+  }
+  if (use_compression_) {
+    WriteCompressedPages({{page_id, page_data}});
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  if (direct_io_ && !IsPageAligned(page_data)) {
+    alignas(PAGE_SIZE) static thread_local char bounce_buffer[PAGE_SIZE];
+    memcpy(bounce_buffer, page_data, PAGE_SIZE);
+    page_data = bounce_buffer;
+  }
+  int64_t offset;
+  int fd = SegmentFd(page_id, true, &offset);
+  counters_.Add(WRITES);
+  counters_.Add(BYTES_WRITTEN, PAGE_SIZE);
+  size_t written = 0;
+  while (written < static_cast<size_t>(PAGE_SIZE)) {
+    ssize_t rc = pwrite(fd, page_data + written, PAGE_SIZE - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+  ExtendFileSize(static_cast<int64_t>(page_id) * PAGE_SIZE + PAGE_SIZE);
+}
+
+/**
+ * Write a batch of pages, coalescing consecutive pages into one vectored write
+ */
+void DiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  std::sort(pages.begin(), pages.end());
+  StampChecksums(pages);
+  if (use_compression_) {
+    WriteCompressedPages(pages);
+    return;
+  }
+  std::vector<iovec> iovecs;
+  std::vector<int> synced_fds;
+  size_t i = 0;
+  while (i < pages.size()) {
+    // Gather the run of pages that starts at i. Unaligned buffers on an O_DIRECT file go through WritePage.
+    size_t run_end = i + 1;
+    if (!direct_io_ || IsPageAligned(pages[i].second)) {
+      while (run_end < pages.size() && run_end - i < static_cast<size_t>(IOV_MAX) &&
+             pages[run_end].first == pages[run_end - 1].first + 1 && pages[run_end].first % pages_per_segment_ != 0 &&
+             (!direct_io_ || IsPageAligned(pages[run_end].second))) {
+        run_end++;
+      }
+    }
+    const page_id_t last_page_id = pages[run_end - 1].first;
+    int64_t offset;
+    int fd = SegmentFd(last_page_id, true, &offset);
+    offset -= static_cast<int64_t>(run_end - 1 - i) * PAGE_SIZE;
+    if (std::find(synced_fds.begin(), synced_fds.end(), fd) == synced_fds.end()) {
+      synced_fds.push_back(fd);
+    }
+
+    iovecs.clear();
+    for (size_t j = i; j < run_end; j++) {
+      iovecs.push_back({const_cast<char *>(pages[j].second), static_cast<size_t>(PAGE_SIZE)});
+    }
+    auto size = static_cast<ssize_t>(iovecs.size()) * PAGE_SIZE;
+    ssize_t rc;
+    do {
+      rc = pwritev(fd, iovecs.data(), static_cast<int>(iovecs.size()), offset);
+    } while (rc < 0 && errno == EINTR);
+    if (rc == size) {
+      counters_.Add(WRITES, run_end - i);
+      counters_.Add(BYTES_WRITTEN, size);
+      ExtendFileSize(static_cast<int64_t>(last_page_id) * PAGE_SIZE + PAGE_SIZE);
+    } else {
+      // Rare enough not to bother resuming the vectored write: redo the pages that were not fully written one by one.
+      size_t written_end = i + std::max<ssize_t>(rc, 0) / PAGE_SIZE;
+      if (written_end > i) {
+        counters_.Add(WRITES, written_end - i);
+        counters_.Add(BYTES_WRITTEN, (written_end - i) * PAGE_SIZE);
+        ExtendFileSize(static_cast<int64_t>(pages[written_end - 1].first) * PAGE_SIZE + PAGE_SIZE);
+      }
+      for (size_t j = written_end; j < run_end; j++) {
+        WritePage(pages[j].first, pages[j].second);
+      }
+    }
+    i = run_end;
+  }
+  for (int fd : synced_fds) {
+    if (fd < 0) {
+      continue;
+    }
+    counters_.Add(SYNCS);
+    if (fdatasync(fd) != 0) {
+      LOG_DEBUG("I/O error while syncing");
+    }
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
+  ScopedLatencyTimer timer(&read_latency_);
+  if (use_compression_) {
+    if (ReadCompressedPage(page_id, page_data)) {
+      VerifyChecksum(page_id, page_data);
+    }
+    return;
+  }
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (static_cast<int64_t>(page_id) * PAGE_SIZE >= db_file_size_.load(std::memory_order_relaxed)) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  // Unaligned buffers on an O_DIRECT file read through a bounce buffer.
+  char *buffer = page_data;
+  if (direct_io_ && !IsPageAligned(page_data)) {
+    alignas(PAGE_SIZE) static thread_local char bounce_buffer[PAGE_SIZE];
+    buffer = bounce_buffer;
+  }
+  int64_t offset;
+  int fd = SegmentFd(page_id, false, &offset);
+  counters_.Add(READS);
+  size_t read_count = 0;
+  while (read_count < static_cast<size_t>(PAGE_SIZE)) {
+    ssize_t rc = pread(fd, buffer + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
       LOG_DEBUG("I/O error while reading");
       return;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    // the file ends before PAGE_SIZE
+    if (rc == 0) {
       LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+      memset(buffer + read_count, 0, PAGE_SIZE - read_count);
+      break;
+    }
+    read_count += rc;
+    counters_.Add(BYTES_READ, rc);
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, PAGE_SIZE);
+  }
+  VerifyChecksum(page_id, page_data);
+}
+
+page_id_t DiskManager::AllocatePage(page_id_t near_page_id, uint32_t stride, uint32_t offset) {
+  assert(offset < stride);
+  // the first page id at or after page_id that AllocatePage may return
+  auto first_candidate = [&](page_id_t page_id) {
+    return page_id + static_cast<page_id_t>((offset + stride - page_id % stride) % stride);
+  };
+  // An extent only surely holds a page of the stride if the stride fits in it. Wider strides have no runs to keep
+  // together, so the hint is dropped.
+  if (stride > static_cast<uint32_t>(PAGES_PER_EXTENT)) {
+    near_page_id = INVALID_PAGE_ID;
+  }
+  std::scoped_lock lock(fsm_latch_);
+  page_id_t page_id = INVALID_PAGE_ID;
+  if (near_page_id != INVALID_PAGE_ID) {
+    page_id_t extent_end = (near_page_id / PAGES_PER_EXTENT + 1) * PAGES_PER_EXTENT;
+    for (page_id_t candidate = first_candidate(near_page_id + 1); candidate < extent_end; candidate += stride) {
+      if (!IsAllocated(candidate)) {
+        page_id = candidate;
+        break;
+      }
+    }
+    // Otherwise start a new run of pages in an empty extent. Every extent past the end of the map is empty.
+    if (page_id == INVALID_PAGE_ID) {
+      while (!IsExtentFree(first_free_extent_)) {
+        first_free_extent_ += PAGES_PER_EXTENT;
+      }
+      page_id = first_candidate(first_free_extent_);
+    }
+  } else {
+    page_id = first_candidate(first_free_page_);
+    while (IsAllocated(page_id)) {
+      page_id = stride == 1 ? NextFreePage(page_id) : page_id + static_cast<page_id_t>(stride);
+    }
+  }
+  SetAllocated(page_id, true);
+  if (page_id == first_free_page_) {
+    first_free_page_ = NextFreePage(page_id);
+  }
+  return page_id;
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  {
+    std::scoped_lock lock(fsm_latch_);
+    SetAllocated(page_id, false);
+    first_free_page_ = std::min(first_free_page_, page_id);
+    page_id_t extent = page_id / PAGES_PER_EXTENT * PAGES_PER_EXTENT;
+    if (IsExtentFree(extent)) {
+      first_free_extent_ = std::min(first_free_extent_, extent);
+    }
+  }
+  if (use_compression_) {
+    std::scoped_lock lock(page_map_latch_);
+    uint64_t entry = PageMapEntry(page_id);
+    if (entry != 0) {
+      SetPageMapEntry(page_id, 0);
+      FreeSlots(EntrySlot(entry), EntrySlots(entry));
+    }
+  }
+}
+
+bool DiskManager::IsPageAllocated(page_id_t page_id) {
+  std::scoped_lock lock(fsm_latch_);
+  return IsAllocated(page_id);
+}
+
+bool DiskManager::IsAllocated(page_id_t page_id) const {
+  size_t word = page_id / BITS_PER_WORD;
+  return word < allocated_.size() && ((allocated_[word] >> (page_id % BITS_PER_WORD)) & 1) != 0;
+}
+
+void DiskManager::SetAllocated(page_id_t page_id, bool allocated) {
+  size_t word = page_id / BITS_PER_WORD;
+  if (word >= allocated_.size()) {
+    if (!allocated) {
+      return;
+    }
+    allocated_.resize(std::max(word + 1, allocated_.size() * 2), 0);
+  }
+  uint64_t bit = uint64_t{1} << (page_id % BITS_PER_WORD);
+  allocated_[word] = allocated ? allocated_[word] | bit : allocated_[word] & ~bit;
+}
+
+bool DiskManager::IsExtentFree(page_id_t page_id) const {
+  size_t word = page_id / BITS_PER_WORD;
+  uint64_t extent_mask = (uint64_t{1} << PAGES_PER_EXTENT) - 1;
+  return word >= allocated_.size() || ((allocated_[word] >> (page_id % BITS_PER_WORD)) & extent_mask) == 0;
+}
+
+page_id_t DiskManager::NextFreePage(page_id_t page_id) const {
+  while (IsAllocated(page_id)) {
+    // Skip whole words of allocated pages at a time.
+    if (page_id % BITS_PER_WORD == 0 && allocated_[page_id / BITS_PER_WORD] == ~uint64_t{0}) {
+      page_id += BITS_PER_WORD;
+    } else {
+      page_id++;
+    }
+  }
+  return page_id;
+}
+
+void DiskManager::LoadFreeSpaceMap() {
+  const int64_t file_pages = use_compression_ ? static_cast<int64_t>(page_map_.size())
+                                              : (db_file_size_.load() + PAGE_SIZE - 1) / PAGE_SIZE;
+  bool clean = false;
+  int fd = open(fsm_name_.c_str(), O_RDWR);
+  // A map next to an empty database file was left behind by a database that has since been removed.
+  if (fd >= 0 && file_pages > 0) {
+    FreeSpaceMapHeader header;
+    struct stat stat_buf;
+    if (pread(fd, &header, sizeof(header), 0) == sizeof(header) && header.magic_ == FSM_MAGIC &&
+        fstat(fd, &stat_buf) == 0 &&
+        static_cast<uint64_t>(stat_buf.st_size) == sizeof(header) + header.num_words_ * sizeof(uint64_t)) {
+      std::vector<uint64_t> words(header.num_words_);
+      auto size = static_cast<ssize_t>(words.size() * sizeof(uint64_t));
+      if (pread(fd, words.data(), size, sizeof(header)) == size) {
+        allocated_ = std::move(words);
+        clean = header.clean_ == 1;
+      }
+    }
+  }
+  if (fd >= 0) {
+    // The map on disk goes stale with the first allocation, until it is saved again at shutdown.
+    uint64_t dirty = 0;
+    if (clean && (pwrite(fd, &dirty, sizeof(dirty), offsetof(FreeSpaceMapHeader, clean_)) != sizeof(dirty) ||
+                  fdatasync(fd) != 0)) {
+      LOG_DEBUG("I/O error while writing free space map");
     }
+    close(fd);
+  }
+  if (!clean) {
+    // The page map says exactly which compressed pages were written.
+    for (page_id_t page_id = 0; page_id < file_pages; page_id++) {
+      if (!use_compression_ || page_map_[page_id] != 0) {
+        SetAllocated(page_id, true);
+      }
+    }
+  }
+  first_free_page_ = NextFreePage(0);
+}
+
+void DiskManager::CheckSegmentInfo() {
+  SegmentInfo info{0, 0};
+  int fd = open(segment_info_name_.c_str(), O_RDONLY);
+  bool found = fd >= 0 && pread(fd, &info, sizeof(info), 0) == sizeof(info) && info.magic_ == SEGMENT_MAGIC;
+  if (fd >= 0) {
+    close(fd);
+  }
+  // A segment info file next to an empty database file was left behind by a database that has since been removed. A
+  // database without one predates it, and is taken to match.
+  if (db_file_size_ > 0 && found) {
+    if (info.pages_per_segment_ != pages_per_segment_) {
+      CloseSegments();
+      throw Exception("db file has " + std::to_string(info.pages_per_segment_) + " pages per segment, not " +
+                      std::to_string(pages_per_segment_));
+    }
+    return;
+  }
+  info = {SEGMENT_MAGIC, pages_per_segment_};
+  fd = open(segment_info_name_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0 || pwrite(fd, &info, sizeof(info), 0) != sizeof(info) || fdatasync(fd) != 0) {
+    LOG_DEBUG("I/O error while writing segment info file");
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+void DiskManager::SaveFreeSpaceMap() {
+  std::scoped_lock lock(fsm_latch_);
+  int fd = open(fsm_name_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open free space map file");
+    return;
+  }
+  // The header only says clean once the whole bitmap is on disk.
+  FreeSpaceMapHeader header{FSM_MAGIC, 0, allocated_.size()};
+  auto size = static_cast<ssize_t>(allocated_.size() * sizeof(uint64_t));
+  bool ok = pwrite(fd, &header, sizeof(header), 0) == sizeof(header) &&
+            pwrite(fd, allocated_.data(), size, sizeof(header)) == size && fdatasync(fd) == 0;
+  header.clean_ = 1;
+  ok = ok && pwrite(fd, &header.clean_, sizeof(header.clean_), offsetof(FreeSpaceMapHeader, clean_)) ==
+                 sizeof(header.clean_) &&
+       fdatasync(fd) == 0;
+  if (!ok) {
+    LOG_DEBUG("I/O error while writing free space map");
   }
+  close(fd);
 }
 
 /**
@@ -168,7 +605,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
+bool DiskManager::ReadLog(char *log_data, int size, int64_t offset) {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
@@ -199,20 +636,454 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
 /**
  * Returns number of Writes made so far
  */
-int DiskManager::GetNumWrites() const { return num_writes_; }
+int DiskManager::GetNumWrites() const { return static_cast<int>(counters_.Get(WRITES)); }
+
+DiskManagerStats DiskManager::GetStats() const {
+  DiskManagerStats stats;
+  stats.num_reads_ = counters_.Get(READS);
+  stats.num_writes_ = counters_.Get(WRITES);
+  stats.bytes_read_ = counters_.Get(BYTES_READ);
+  stats.bytes_written_ = counters_.Get(BYTES_WRITTEN);
+  stats.num_syncs_ = counters_.Get(SYNCS);
+  stats.num_log_flushes_ = num_flushes_;
+  stats.num_corrupt_pages_ = counters_.Get(CORRUPT_PAGES);
+  stats.read_latency_ = read_latency_.GetSnapshot();
+  stats.write_latency_ = write_latency_.GetSnapshot();
+  return stats;
+}
+
+std::string DiskManagerStats::ToString() const {
+  char buf[512];
+  snprintf(buf, sizeof(buf),
+           "reads %" PRIu64 " (%" PRIu64 " bytes), writes %" PRIu64 " (%" PRIu64 " bytes), syncs %" PRIu64
+           ", log flushes %" PRIu64 ", corrupt pages %" PRIu64 ", read latency: %s, write latency: %s",
+           num_reads_, bytes_read_, num_writes_, bytes_written_, num_syncs_, num_log_flushes_, num_corrupt_pages_,
+           read_latency_.ToString().c_str(), write_latency_.ToString().c_str());
+  return buf;
+}
 
 /**
  * Returns true if the log is currently being flushed
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Private helper function to keep track of the db file size as pages are written
+ */
+void DiskManager::ExtendFileSize(int64_t size) {
+  // other threads may grow the file concurrently, only ever move the size forward
+  int64_t file_size = db_file_size_.load(std::memory_order_relaxed);
+  while (file_size < size && !db_file_size_.compare_exchange_weak(file_size, size, std::memory_order_relaxed)) {
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
+}
+
+std::string DiskManager::GetSegmentFileName(size_t segment) const {
+  return segment == 0 ? file_name_ : file_name_ + "." + std::to_string(segment);
+}
+
+int DiskManager::SegmentFd(page_id_t page_id, bool for_write, int64_t *offset) {
+  size_t segment = page_id / pages_per_segment_;
+  *offset = static_cast<int64_t>(page_id % pages_per_segment_) * PAGE_SIZE;
+  if (segment >= MAX_DB_SEGMENTS) {
+    LOG_DEBUG("page %d is past the last segment", page_id);
+    return -1;
+  }
+  int fd = segment_fds_[segment].load(std::memory_order_acquire);
+  int64_t end = static_cast<int64_t>(page_id) * PAGE_SIZE + PAGE_SIZE;
+  if (fd >= 0 && (!for_write || end <= preallocated_size_.load(std::memory_order_relaxed))) {
+    return fd;
+  }
+
+  std::scoped_lock lock(segment_latch_);
+  // Segments are created without gaps, so that reopening the database finds all of them.
+  for (size_t i = 1; i < segment && segment_fds_[segment] < 0; i++) {
+    if (segment_fds_[i].load(std::memory_order_relaxed) < 0) {
+      OpenSegment(i);
+    }
+  }
+  fd = segment_fds_[segment].load(std::memory_order_relaxed);
+  if (fd < 0) {
+    fd = OpenSegment(segment);
+  }
+  if (fd >= 0 && for_write && end > preallocated_size_.load(std::memory_order_relaxed)) {
+    // Reserve the stretch of the segment the page falls in, up to the end of the segment.
+    const int64_t chunk = static_cast<int64_t>(SEGMENT_PREALLOCATE_PAGES) * PAGE_SIZE;
+    const int64_t segment_size = static_cast<int64_t>(pages_per_segment_) * PAGE_SIZE;
+    int64_t start = std::max(preallocated_size_.load(std::memory_order_relaxed), (end - PAGE_SIZE) / chunk * chunk);
+    int64_t stop = std::min((end + chunk - 1) / chunk * chunk, static_cast<int64_t>(segment + 1) * segment_size);
+    start = std::max(start, static_cast<int64_t>(segment) * segment_size);
+#ifdef FALLOC_FL_KEEP_SIZE
+    // Keep the file size, which marks the end of the written pages.
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, start - static_cast<int64_t>(segment) * segment_size, stop - start) != 0) {
+      LOG_DEBUG("fallocate failed: %s", strerror(errno));
+    }
+#endif
+    preallocated_size_.store(std::max(stop, end), std::memory_order_relaxed);
+  }
+  return fd;
+}
+
+int DiskManager::OpenSegment(size_t segment) {
+  std::string segment_name = GetSegmentFileName(segment);
+  int fd = open(segment_name.c_str(), O_RDWR | O_CREAT | (direct_io_ ? O_DIRECT : 0), 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open segment file %s", segment_name.c_str());
+    return -1;
+  }
+  segment_fds_[segment].store(fd, std::memory_order_release);
+  return fd;
+}
+
+void DiskManager::LoadChecksums() {
+  use_checksums_ = true;
+  checksum_chunks_.reset(new std::atomic<std::atomic<uint64_t> *>[NUM_CHECKSUM_CHUNKS]);
+  for (size_t i = 0; i < NUM_CHECKSUM_CHUNKS; i++) {
+    checksum_chunks_[i] = nullptr;
+  }
+  // Checksums next to an empty database file belong to a database that has since been removed.
+  checksum_fd_ = open(checksum_name_.c_str(), O_RDWR | O_CREAT | (db_file_size_ == 0 ? O_TRUNC : 0), 0644);
+  if (checksum_fd_ < 0) {
+    throw Exception("can't open checksum file");
+  }
+  struct stat checksum_stat;
+  if (fstat(checksum_fd_, &checksum_stat) != 0) {
+    throw Exception("can't stat checksum file");
+  }
+  // Map every chunk the file reaches into; ChecksumEntry extends a partial last chunk.
+  size_t chunk_size = CHECKSUMS_PER_CHUNK * sizeof(uint64_t);
+  size_t num_chunks = std::min(NUM_CHECKSUM_CHUNKS, (checksum_stat.st_size + chunk_size - 1) / chunk_size);
+  for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+    ChecksumEntry(static_cast<page_id_t>(chunk * CHECKSUMS_PER_CHUNK), true);
+  }
+}
+
+std::atomic<uint64_t> *DiskManager::ChecksumEntry(page_id_t page_id, bool create) {
+  size_t chunk_index = page_id / CHECKSUMS_PER_CHUNK;
+  std::atomic<uint64_t> *chunk = checksum_chunks_[chunk_index].load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    if (!create) {
+      return nullptr;
+    }
+    std::scoped_lock lock(checksum_latch_);
+    chunk = checksum_chunks_[chunk_index].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      // Chunks are mapped from the checksum file, so storing an entry is all it takes to write it; the kernel writes
+      // the dirty pages back in bulk, and SyncChecksums syncs them. The file only grows, as chunks are mapped in any
+      // order.
+      size_t chunk_size = CHECKSUMS_PER_CHUNK * sizeof(uint64_t);
+      auto chunk_end = static_cast<int64_t>((chunk_index + 1) * chunk_size);
+      struct stat checksum_stat;
+      if (fstat(checksum_fd_, &checksum_stat) != 0 ||
+          (checksum_stat.st_size < chunk_end && ftruncate(checksum_fd_, chunk_end) != 0)) {
+        throw Exception("can't extend checksum file");
+      }
+      void *mapping = mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED, checksum_fd_,
+                           static_cast<int64_t>(chunk_index * chunk_size));
+      if (mapping == MAP_FAILED) {
+        throw Exception("can't map checksum file");
+      }
+      chunk = static_cast<std::atomic<uint64_t> *>(mapping);
+      checksum_chunks_[chunk_index].store(chunk, std::memory_order_release);
+    }
+  }
+  return &chunk[page_id % CHECKSUMS_PER_CHUNK];
+}
+
+bool DiskManager::StampChecksum(page_id_t page_id, const char *page_data) {
+  if (!use_checksums_) {
+    return false;
+  }
+  uint32_t checksum = PageChecksum(page_data);
+  std::atomic<uint64_t> *entry = ChecksumEntry(page_id, true);
+  uint64_t old_entry = entry->load(std::memory_order_relaxed);
+  if (static_cast<uint32_t>(old_entry) == checksum) {
+    return false;
+  }
+  // The checksum goes out before the page does. Keep the one of the contents on disk until then as well.
+  entry->store((old_entry << 32) | checksum, std::memory_order_relaxed);
+  return true;
+}
+
+void DiskManager::StampChecksums(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  bool stamped = false;
+  for (const auto &[page_id, page_data] : pages) {
+    stamped = StampChecksum(page_id, page_data) || stamped;
+  }
+  if (stamped) {
+    SyncChecksums();
+  }
+}
+
+void DiskManager::SyncChecksums() {
+  // A page that reaches the disk ahead of its checksum would read as corrupt after an OS crash, and the kernel may
+  // write the pages back at any time once they are written.
+  counters_.Add(SYNCS);
+  if (fdatasync(checksum_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing checksums");
+  }
+}
+
+void DiskManager::VerifyChecksum(page_id_t page_id, const char *page_data) {
+  if (!use_checksums_) {
+    return;
+  }
+  std::atomic<uint64_t> *entry = ChecksumEntry(page_id, false);
+  uint64_t checksums = entry == nullptr ? 0 : entry->load(std::memory_order_relaxed);
+  // Pages last written without checksums have none.
+  if (checksums == 0) {
+    return;
+  }
+  uint32_t checksum = PageChecksum(page_data);
+  if (checksum != static_cast<uint32_t>(checksums) && checksum != static_cast<uint32_t>(checksums >> 32)) {
+    counters_.Add(CORRUPT_PAGES);
+    throw Exception(ExceptionType::CORRUPTION, "checksum mismatch on page " + std::to_string(page_id));
+  }
+}
+
+void DiskManager::LoadPageMap() {
+  use_compression_ = true;
+  page_map_fd_ = open(page_map_name_.c_str(), O_RDWR | O_CREAT | (db_file_size_ == 0 ? O_TRUNC : 0), 0644);
+  if (page_map_fd_ < 0) {
+    throw Exception("can't open page map file");
+  }
+  struct stat stat_buf;
+  if (fstat(page_map_fd_, &stat_buf) == 0) {
+    page_map_.resize(stat_buf.st_size / sizeof(uint64_t));
+  }
+  auto size = static_cast<ssize_t>(page_map_.size() * sizeof(uint64_t));
+  if (pread(page_map_fd_, page_map_.data(), size, 0) != size) {
+    throw Exception("can't read page map file");
+  }
+
+  // Every slot between the images of the pages is free.
+  std::vector<std::pair<int64_t, int64_t>> images;
+  for (uint64_t entry : page_map_) {
+    if (entry != 0) {
+      images.emplace_back(EntrySlot(entry), EntrySlots(entry));
+      end_slot_ = std::max(end_slot_, EntrySlot(entry) + EntrySlots(entry));
+    }
+  }
+  std::sort(images.begin(), images.end());
+  const int64_t segment_slots = static_cast<int64_t>(pages_per_segment_) * SLOTS_PER_BLOCK;
+  int64_t slot = 0;
+  for (const auto &[image_slot, num_slots] : images) {
+    while (slot < image_slot) {
+      int64_t run_end = std::min(image_slot, (slot / segment_slots + 1) * segment_slots);
+      FreeSlots(slot, run_end - slot);
+      slot = run_end;
+    }
+    slot = image_slot + num_slots;
+  }
+}
+
+void DiskManager::WriteCompressedPages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  // Every image goes to newly allocated slots, and the page map points to it only once it is synced. The slots of the
+  // image it replaces are handed out again only once the map is synced too, so that after a crash the map points to
+  // either the old image or the new one, both intact.
+  alignas(PAGE_SIZE) static thread_local char image[PAGE_SIZE];
+  const int64_t segment_slots = static_cast<int64_t>(pages_per_segment_) * SLOTS_PER_BLOCK;
+  std::vector<uint64_t> entries(pages.size(), 0);
+  std::vector<int64_t> segments;
+  for (size_t i = 0; i < pages.size(); i++) {
+    // Keep the compressed image only if it saves at least a slot.
+    int length = LZ4_compress_default(pages[i].second, image, PAGE_SIZE, PAGE_SIZE - COMPRESSION_SLOT_SIZE);
+    if (length <= 0) {
+      memcpy(image, pages[i].second, PAGE_SIZE);
+      length = PAGE_SIZE;
+    }
+    const int64_t num_slots = (length + COMPRESSION_SLOT_SIZE - 1) / COMPRESSION_SLOT_SIZE;
+    memset(image + length, 0, num_slots * COMPRESSION_SLOT_SIZE - length);
+
+    int64_t slot;
+    {
+      std::scoped_lock lock(page_map_latch_);
+      slot = AllocateSlots(num_slots);
+    }
+    counters_.Add(WRITES);
+    counters_.Add(BYTES_WRITTEN, num_slots * COMPRESSION_SLOT_SIZE);
+    if (!SlotIo(true, slot, image, num_slots * COMPRESSION_SLOT_SIZE)) {
+      LOG_DEBUG("I/O error while writing");
+      std::scoped_lock lock(page_map_latch_);
+      FreeSlots(slot, num_slots);
+      continue;
+    }
+    ExtendFileSize((slot + num_slots) * COMPRESSION_SLOT_SIZE);
+    entries[i] = (static_cast<uint64_t>(slot) << PAGE_MAP_LENGTH_BITS) | static_cast<uint64_t>(length);
+    if (std::find(segments.begin(), segments.end(), slot / segment_slots) == segments.end()) {
+      segments.push_back(slot / segment_slots);
+    }
+  }
+  for (int64_t segment : segments) {
+    counters_.Add(SYNCS);
+    if (fdatasync(segment_fds_[segment].load(std::memory_order_relaxed)) != 0) {
+      LOG_DEBUG("I/O error while syncing");
+    }
+  }
+
+  std::vector<uint64_t> old_entries;
+  {
+    std::scoped_lock lock(page_map_latch_);
+    for (size_t i = 0; i < pages.size(); i++) {
+      if (entries[i] != 0) {
+        old_entries.push_back(PageMapEntry(pages[i].first));
+        SetPageMapEntry(pages[i].first, entries[i]);
+      }
+    }
+  }
+  if (old_entries.empty()) {
+    return;
+  }
+  counters_.Add(SYNCS);
+  if (fdatasync(page_map_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing page map");
+  }
+  std::scoped_lock lock(page_map_latch_);
+  for (uint64_t old_entry : old_entries) {
+    if (old_entry != 0) {
+      FreeSlots(EntrySlot(old_entry), EntrySlots(old_entry));
+    }
+  }
+}
+
+bool DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) {
+  uint64_t entry;
+  {
+    std::scoped_lock lock(page_map_latch_);
+    entry = PageMapEntry(page_id);
+  }
+  if (entry == 0) {
+    LOG_DEBUG("I/O error reading a page that was never written");
+    memset(page_data, 0, PAGE_SIZE);
+    return false;
+  }
+  alignas(PAGE_SIZE) static thread_local char image[PAGE_SIZE];
+  counters_.Add(READS);
+  counters_.Add(BYTES_READ, EntrySlots(entry) * COMPRESSION_SLOT_SIZE);
+  if (!SlotIo(false, EntrySlot(entry), image, EntrySlots(entry) * COMPRESSION_SLOT_SIZE)) {
+    LOG_DEBUG("I/O error while reading");
+  }
+  auto length = static_cast<int>(EntryLength(entry));
+  if (length == PAGE_SIZE) {
+    memcpy(page_data, image, PAGE_SIZE);
+  } else if (LZ4_decompress_safe(image, page_data, length, PAGE_SIZE) != PAGE_SIZE) {
+    counters_.Add(CORRUPT_PAGES);
+    throw Exception(ExceptionType::CORRUPTION, "can't decompress page " + std::to_string(page_id));
+  }
+  return true;
+}
+
+bool DiskManager::SlotIo(bool write, int64_t slot, char *data, size_t size) {
+  // The slots may run into the next block, but not into the next segment.
+  const int64_t first_block = slot / SLOTS_PER_BLOCK;
+  const int64_t last_block = (slot + static_cast<int64_t>(size / COMPRESSION_SLOT_SIZE) - 1) / SLOTS_PER_BLOCK;
+  int64_t offset;
+  int fd = SegmentFd(static_cast<page_id_t>(last_block), write, &offset);
+  offset -= (last_block - first_block) * PAGE_SIZE - (slot % SLOTS_PER_BLOCK) * COMPRESSION_SLOT_SIZE;
+  size_t done = 0;
+  while (done < size) {
+    ssize_t rc = write ? pwrite(fd, data + done, size - done, offset + done)
+                       : pread(fd, data + done, size - done, offset + done);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0 || (rc == 0 && write)) {
+      return false;
+    }
+    // the file ends before the last slot
+    if (rc == 0) {
+      memset(data + done, 0, size - done);
+      break;
+    }
+    done += rc;
+  }
+  return true;
+}
+
+uint64_t DiskManager::PageMapEntry(page_id_t page_id) const {
+  return static_cast<size_t>(page_id) < page_map_.size() ? page_map_[page_id] : 0;
+}
+
+void DiskManager::SetPageMapEntry(page_id_t page_id, uint64_t entry) {
+  if (static_cast<size_t>(page_id) >= page_map_.size()) {
+    page_map_.resize(std::max(static_cast<size_t>(page_id) + 1, page_map_.size() * 2), 0);
+  }
+  page_map_[page_id] = entry;
+  if (pwrite(page_map_fd_, &entry, sizeof(entry), static_cast<int64_t>(page_id) * sizeof(entry)) != sizeof(entry)) {
+    LOG_DEBUG("I/O error while writing page map");
+  }
+}
+
+int64_t DiskManager::AllocateSlots(int64_t num_slots) {
+  // Best fit, and the first of the runs that fit equally well, which keeps the file compact.
+  auto it = free_runs_by_size_.lower_bound({num_slots, 0});
+  if (it != free_runs_by_size_.end()) {
+    auto [length, slot] = *it;
+    free_runs_by_size_.erase(it);
+    free_runs_.erase(slot);
+    if (length > num_slots) {
+      free_runs_.emplace(slot + num_slots, length - num_slots);
+      free_runs_by_size_.emplace(length - num_slots, slot + num_slots);
+    }
+    return slot;
+  }
+  // Otherwise take slots off the end, skipping to the next segment if the current one has too few left.
+  const int64_t segment_slots = static_cast<int64_t>(pages_per_segment_) * SLOTS_PER_BLOCK;
+  int64_t slot = end_slot_;
+  if (slot / segment_slots != (slot + num_slots - 1) / segment_slots) {
+    slot = (slot / segment_slots + 1) * segment_slots;
+    int64_t skipped = end_slot_;
+    end_slot_ = slot + num_slots;
+    FreeSlots(skipped, slot - skipped);
+    return slot;
+  }
+  end_slot_ = slot + num_slots;
+  return slot;
+}
+
+void DiskManager::FreeSlots(int64_t slot, int64_t num_slots) {
+  // Merge with the free runs right before and after, unless they are in another segment.
+  const int64_t segment_slots = static_cast<int64_t>(pages_per_segment_) * SLOTS_PER_BLOCK;
+  auto next = free_runs_.find(slot + num_slots);
+  if (next != free_runs_.end() && next->first % segment_slots != 0) {
+    num_slots += next->second;
+    free_runs_by_size_.erase({next->second, next->first});
+    free_runs_.erase(next);
+  }
+  auto prev = free_runs_.lower_bound(slot);
+  if (prev != free_runs_.begin() && slot % segment_slots != 0) {
+    --prev;
+    if (prev->first + prev->second == slot) {
+      slot = prev->first;
+      num_slots += prev->second;
+      free_runs_by_size_.erase({prev->second, prev->first});
+      free_runs_.erase(prev);
+    }
+  }
+  // Slots at the end go back to the unused space there.
+  if (slot + num_slots == end_slot_) {
+    end_slot_ = slot;
+    return;
+  }
+  free_runs_.emplace(slot, num_slots);
+  free_runs_by_size_.emplace(num_slots, slot);
+}
+
+void DiskManager::CloseSegments() {
+  for (size_t i = 0; i < MAX_DB_SEGMENTS; i++) {
+    int fd = segment_fds_[i].exchange(-1);
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
 }
 
 }  // namespace bustub
@@ -0,0 +1,383 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.cpp
+//
+// Identification: src/storage/disk/disk_scheduler.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_scheduler.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <exception>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * A minimal io_uring: one submission queue and one completion queue, mapped from the kernel, used by one thread.
+ */
+class DiskScheduler::IoUring {
+ public:
+  /** @return a ring with room for entries requests, or nullptr if the kernel does not provide io_uring */
+  static std::unique_ptr<IoUring> Create(unsigned entries) {
+    io_uring_params params{};
+    auto fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+      return nullptr;
+    }
+    std::unique_ptr<IoUring> ring(new IoUring(fd));
+    return ring->Map(params) ? std::move(ring) : nullptr;
+  }
+
+  ~IoUring() {
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    close(fd_);
+  }
+
+  /** @return the submission queue entry for the next request; at most the ring size between two Publish calls */
+  io_uring_sqe *NextSqe() {
+    unsigned index = (local_tail_++) & *sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    return sqe;
+  }
+
+  /** Makes the entries filled since the last call visible to the kernel. */
+  void Publish() { __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE); }
+
+  /**
+   * Takes back the published entries the kernel has not consumed yet, so that no later io_uring_enter submits them.
+   * Only valid while no io_uring_enter runs, which holds as this ring's thread is the only one to call it.
+   */
+  void DiscardUnsubmitted() {
+    local_tail_ = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    Publish();
+  }
+
+  /** @return the io_uring_enter result: number of entries submitted, or -1 with errno set */
+  int Enter(unsigned to_submit, unsigned min_complete) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+  }
+
+  /** Takes the oldest completion off the completion queue. @return false if there is none */
+  bool PopCompletion(uint64_t *user_data, int *res) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+    *user_data = cqe.user_data;
+    *res = cqe.res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+ private:
+  explicit IoUring(int fd) : fd_(fd) {}
+
+  bool Map(const io_uring_params &params) {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    void *sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                         IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED) {
+      return false;
+    }
+    sq_ring_ = static_cast<char *>(sq_ring);
+    if (single_mmap) {
+      cq_ring_ = sq_ring_;
+    } else {
+      void *cq_ring = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                           IORING_OFF_CQ_RING);
+      if (cq_ring == MAP_FAILED) {
+        return false;
+      }
+      cq_ring_ = static_cast<char *>(cq_ring);
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    sq_head_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq_ring_ + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq_ring_ + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq_ring_ + params.cq_off.cqes);
+    local_tail_ = *sq_tail_;
+    return true;
+  }
+
+  int fd_;
+  char *sq_ring_{nullptr};
+  char *cq_ring_{nullptr};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sq_ring_size_{0};
+  size_t cq_ring_size_{0};
+  size_t sqes_size_{0};
+
+  unsigned *sq_head_{nullptr};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+  /** Tail of the submission queue including entries not published yet. Only this ring's thread advances it. */
+  unsigned local_tail_{0};
+};
+
+DiskScheduler::DiskScheduler(DiskManager *disk_manager, size_t queue_depth, bool use_io_uring)
+    : disk_manager_(disk_manager), queue_depth_(std::max<size_t>(queue_depth, 1)) {
+  // Only the disk manager knows where and how large a compressed page is on disk.
+  if (use_io_uring && !disk_manager_->UsesCompression()) {
+    ring_ = IoUring::Create(static_cast<unsigned>(queue_depth_));
+  }
+  if (ring_ != nullptr) {
+    workers_.emplace_back(&DiskScheduler::IoUringWorkerLoop, this);
+  } else {
+    for (size_t i = 0; i < DISK_SCHEDULER_NUM_WORKERS; i++) {
+      workers_.emplace_back(&DiskScheduler::ThreadPoolWorkerLoop, this);
+    }
+  }
+}
+
+DiskScheduler::~DiskScheduler() {
+  {
+    std::scoped_lock lock(latch_);
+    stopped_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void DiskScheduler::Schedule(DiskRequest request) {
+  std::vector<DiskRequest> requests;
+  requests.push_back(std::move(request));
+  Schedule(std::move(requests));
+}
+
+void DiskScheduler::Schedule(std::vector<DiskRequest> requests) {
+  BUSTUB_ASSERT(requests.size() <= queue_depth_, "A batch must fit in the submission queue");
+  if (requests.empty()) {
+    return;
+  }
+  // The last request of the batch has nothing to come before.
+  requests.back().before_next_ = false;
+  {
+    std::scoped_lock lock(latch_);
+    Chain chain;
+    for (auto &request : requests) {
+      bool ends_chain = !request.before_next_;
+      chain.push_back(std::move(request));
+      if (ends_chain) {
+        queue_.push_back(std::move(chain));
+        chain.clear();
+      }
+    }
+  }
+  cv_.notify_all();
+}
+
+void DiskScheduler::IoUringWorkerLoop() {
+  std::vector<DiskRequest> batch;
+  std::vector<iovec> iovecs(queue_depth_);
+  std::vector<bool> completed(queue_depth_);
+  while (true) {
+    batch.clear();
+    {
+      std::unique_lock lock(latch_);
+      cv_.wait(lock, [&] { return stopped_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      // Everything queued up while the previous batch was on disk goes out together.
+      while (!queue_.empty() && batch.size() + queue_.front().size() <= queue_depth_) {
+        for (auto &request : queue_.front()) {
+          batch.push_back(std::move(request));
+        }
+        queue_.pop_front();
+      }
+    }
+
+    bool stamped = false;
+    for (size_t i = 0; i < batch.size(); i++) {
+      DiskRequest &request = batch[i];
+      iovecs[i] = {request.data_, static_cast<size_t>(PAGE_SIZE)};
+      int64_t offset;
+      if (request.is_write_) {
+        stamped = disk_manager_->StampChecksum(request.page_id_, request.data_) || stamped;
+      }
+      io_uring_sqe *sqe = ring_->NextSqe();
+      sqe->opcode = request.is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+      // A segment that cannot be opened fails the request with EBADF, and Complete retries it synchronously.
+      sqe->fd = disk_manager_->SegmentFd(request.page_id_, request.is_write_, &offset);
+      sqe->addr = reinterpret_cast<uint64_t>(&iovecs[i]);
+      sqe->len = 1;
+      sqe->off = static_cast<uint64_t>(offset);
+      sqe->user_data = i;
+      sqe->flags = request.before_next_ ? IOSQE_IO_LINK : 0;
+      completed[i] = false;
+    }
+    // The checksums of the writes reach the disk before the writes are handed to the kernel, in one sync per batch.
+    if (stamped) {
+      disk_manager_->SyncChecksums();
+    }
+    ring_->Publish();
+    num_submissions_.fetch_add(1, std::memory_order_relaxed);
+
+    auto to_submit = static_cast<unsigned>(batch.size());
+    size_t num_completed = 0;
+    auto reap = [&] {
+      uint64_t index;
+      int res;
+      bool reaped = false;
+      while (ring_->PopCompletion(&index, &res)) {
+        Complete(&batch[index], res);
+        completed[index] = true;
+        num_completed++;
+        reaped = true;
+      }
+      return reaped;
+    };
+    while (num_completed < batch.size()) {
+      int ret = ring_->Enter(to_submit, 1);
+      int error = ret < 0 ? errno : 0;
+      if (ret > 0) {
+        to_submit -= std::min(static_cast<unsigned>(ret), to_submit);
+      }
+      reap();
+      if (ret < 0 && error != EINTR && error != EAGAIN && error != EBUSY) {
+        LOG_WARN("io_uring_enter failed: %s", strerror(error));
+        break;
+      }
+    }
+    if (num_completed < batch.size()) {
+      // The ring broke. Requests the kernel took may still be reading into or writing from their pages: wait for all
+      // of them to complete, so that none races with the request being redone below, and keep the ones it did not
+      // take from going out with the next batch. Completions still arrive without io_uring_enter, if more slowly.
+      size_t num_submitted = batch.size() - to_submit;
+      while (num_completed < num_submitted) {
+        if (!reap() && ring_->Enter(0, 1) < 0) {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+      }
+      ring_->DiscardUnsubmitted();
+    }
+    // Finish what the kernel did not.
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (!completed[i]) {
+        ExecuteSynchronously(&batch[i]);
+      }
+    }
+  }
+}
+
+void DiskScheduler::ThreadPoolWorkerLoop() {
+  while (true) {
+    Chain chain;
+    {
+      std::unique_lock lock(latch_);
+      cv_.wait(lock, [&] { return stopped_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      chain = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    for (auto &request : chain) {
+      num_submissions_.fetch_add(1, std::memory_order_relaxed);
+      ExecuteSynchronously(&request);
+    }
+  }
+}
+
+void DiskScheduler::ExecuteSynchronously(DiskRequest *request) {
+  try {
+    if (request->is_write_) {
+      disk_manager_->WritePage(request->page_id_, request->data_);
+    } else {
+      disk_manager_->ReadPage(request->page_id_, request->data_);
+    }
+  } catch (Exception &) {
+    // A page that failed verification: the waiter gets the exception instead.
+    num_completed_.fetch_add(1, std::memory_order_relaxed);
+    request->callback_.set_exception(std::current_exception());
+    return;
+  }
+  num_completed_.fetch_add(1, std::memory_order_relaxed);
+  request->callback_.set_value(true);
+}
+
+void DiskScheduler::Complete(DiskRequest *request, int res) {
+  // Failed, e.g. an unaligned buffer on an O_DIRECT file, cancelled because an earlier request of its chain failed, or
+  // a short write: redo it the slow way, which also keeps the order of the chain since completions are reaped in order.
+  if (res < 0 || (request->is_write_ && res < PAGE_SIZE)) {
+    ExecuteSynchronously(request);
+    return;
+  }
+  if (request->is_write_) {
+    disk_manager_->counters_.Add(DiskManager::WRITES);
+    disk_manager_->counters_.Add(DiskManager::BYTES_WRITTEN, PAGE_SIZE);
+    disk_manager_->ExtendFileSize(static_cast<int64_t>(request->page_id_) * PAGE_SIZE + PAGE_SIZE);
+  } else {
+    disk_manager_->counters_.Add(DiskManager::READS);
+    disk_manager_->counters_.Add(DiskManager::BYTES_READ, res);
+    if (res < PAGE_SIZE) {
+      // The file ends inside, or before, the page.
+      memset(request->data_ + res, 0, PAGE_SIZE - res);
+    }
+    try {
+      disk_manager_->VerifyChecksum(request->page_id_, request->data_);
+    } catch (Exception &) {
+      num_completed_.fetch_add(1, std::memory_order_relaxed);
+      request->callback_.set_exception(std::current_exception());
+      return;
+    }
+  }
+  num_completed_.fetch_add(1, std::memory_order_relaxed);
+  request->callback_.set_value(true);
+}
+
+}  // namespace bustub
@@ -43,7 +43,18 @@ bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  return false;
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return false;
+  }
+  ValueType value;
+  bool found = reinterpret_cast<LeafPage *>(page->GetData())->Lookup(key, &value, comparator_);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  if (found) {
+    result->push_back(value);
+  }
+  return found;
 }
 
 /*****************************************************************************
@@ -210,10 +221,142 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::End() { return INDEXITERATOR_TYPE(); }
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * @return : the leaf page, pinned and read-latched, or nullptr if the tree is
+ * empty
  */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  // Internal pages are read optimistically, so that lookups do not write to
+  // the latches of the upper levels that every lookup goes through. A descent
+  // that runs into a writer starts over with latch crabbing.
+  Page *leaf;
+  if (FindLeafPageOptimistic(key, leftMost, &leaf)) {
+    return leaf;
+  }
+  return FindLeafPagePessimistic(key, leftMost);
+}
+
+/*
+ * Descend from the root, validating each internal page's version instead of
+ * read-latching it
+ * @return : false if a page changed under the descent, with nothing left
+ * pinned or latched
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, bool leftMost, Page **leaf) {
+  *leaf = nullptr;
+  page_id_t root_page_id = root_page_id_.load();
+  if (root_page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  Page *page = FetchTreePage(root_page_id);
+  uint64_t version;
+  // Writers replace the root only while holding its write latch, so a root
+  // that is still current once its version is taken stays current for as long
+  // as the version validates.
+  if (!page->TryOptimisticRead(&version) || root_page_id_.load() != root_page_id) {
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return false;
+  }
+  while (true) {
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    bool is_leaf = node->IsLeafPage();
+    page_id_t child_page_id = INVALID_PAGE_ID;
+    if (!is_leaf) {
+      // Until it is validated, the page may be anything: a split half done, or
+      // the frame refilled with another page. Lookup clamps the size it reads
+      // to what fits in the page, so even an unvalidated search stays within
+      // it, and ValueAt(0) always does.
+      auto *internal = reinterpret_cast<InternalPage *>(node);
+      child_page_id = leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_);
+    }
+    if (!page->ValidateOptimisticRead(version)) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      return false;
+    }
+
+    if (is_leaf) {
+      // A split or merge between the validation and the latch may have moved
+      // the key to another leaf.
+      page->RLatch();
+      if (!page->ValidateOptimisticRead(version)) {
+        page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        return false;
+      }
+      *leaf = page;
+      return true;
+    }
+
+    // The parent is validated again once the child's version is taken, so the
+    // child is still the one the parent points to.
+    Page *child = FetchTreePage(child_page_id, page, false);
+    uint64_t child_version;
+    bool valid = child->TryOptimisticRead(&child_version) && page->ValidateOptimisticRead(version);
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (!valid) {
+      buffer_pool_manager_->UnpinPage(child->GetPageId(), false);
+      return false;
+    }
+    page = child;
+    version = child_version;
+  }
+}
+
+/*
+ * Descend from the root with latch crabbing: latch the child, then release the
+ * parent
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPagePessimistic(const KeyType &key, bool leftMost) {
+  Page *page;
+  while (true) {
+    page_id_t root_page_id = root_page_id_.load();
+    if (root_page_id == INVALID_PAGE_ID) {
+      return nullptr;
+    }
+    page = FetchTreePage(root_page_id);
+    page->RLatch();
+    // The root may have been replaced between reading its id and latching it.
+    if (root_page_id_.load() == root_page_id) {
+      break;
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(root_page_id, false);
+  }
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    page_id_t child_page_id = leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_);
+    Page *child = FetchTreePage(child_page_id, page, true);
+    child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+/*
+ * Fetch a page of the tree, throwing an "out of memory" exception if the
+ * buffer pool has no frame for it. The parent the descent came from, if any,
+ * is released before the exception escapes, so that a failed descent leaves
+ * nothing pinned or latched
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchTreePage(page_id_t page_id, Page *parent, bool parent_latched) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    if (parent != nullptr) {
+      if (parent_latched) {
+        parent->RUnlatch();
+      }
+      buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
+    }
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left for a B+ tree page");
+  }
+  return page;
 }
 
 /*
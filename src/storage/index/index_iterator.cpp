@@ -2,29 +2,105 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <memory>
+#include <utility>
 
+#include "common/exception.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, page_id_t leaf_page_id, int index)
+    : buffer_pool_manager_(buffer_pool_manager), index_(index) {
+  if (leaf_page_id == INVALID_PAGE_ID) {
+    index_ = 0;
+    return;
+  }
+  guard_ = FetchLeaf(leaf_page_id);
+  page_id_ = leaf_page_id;
+  size_t read_ahead_distance = buffer_pool_manager_->GetReadAheadDistance();
+  if (read_ahead_distance > 0) {
+    read_ahead_end_ = std::make_shared<std::atomic<page_id_t>>(READ_AHEAD_PENDING);
+    buffer_pool_manager_->PrefetchPageChain(Leaf()->GetNextPageId(), read_ahead_distance, &LeafPage::NextPageIdOf,
+                                            nullptr, read_ahead_end_);
+  }
+  SkipExhaustedLeaves();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
-bool INDEXITERATOR_TYPE::IsEnd() { throw std::runtime_error("unimplemented"); }
+bool INDEXITERATOR_TYPE::IsEnd() { return page_id_ == INVALID_PAGE_ID; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() {
+  assert(!IsEnd());
+  return Leaf()->GetItem(index_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  assert(!IsEnd());
+  index_++;
+  if (read_ahead_owed_ > 0) {
+    ExtendReadAhead();
+  }
+  SkipExhaustedLeaves();
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (index_ >= Leaf()->GetSize()) {
+    page_id_t next_page_id = Leaf()->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      guard_.Drop();
+      page_id_ = INVALID_PAGE_ID;
+      index_ = 0;
+      return;
+    }
+    // Latch the next leaf before letting go of this one, so the chain cannot change between the two.
+    ReadPageGuard next_guard = FetchLeaf(next_page_id);
+    guard_ = std::move(next_guard);
+    page_id_ = next_page_id;
+    index_ = 0;
+    // Stepping onto the next leaf moves the window on by one, so only the leaf entering it at the far end is new.
+    if (read_ahead_end_ != nullptr) {
+      read_ahead_owed_++;
+      ExtendReadAhead();
+    }
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &INDEXITERATOR_TYPE::operator*() { throw std::runtime_error("unimplemented"); }
+ReadPageGuard INDEXITERATOR_TYPE::FetchLeaf(page_id_t page_id) {
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left for a B+ tree page");
+  }
+  return guard;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::ExtendReadAhead() {
+  // The ids of the leaves entering the window are known once the previous request has walked the chain that far.
+  page_id_t end = read_ahead_end_->load(std::memory_order_acquire);
+  if (end == READ_AHEAD_PENDING) {
+    return;
+  }
+  if (end == INVALID_PAGE_ID) {
+    read_ahead_owed_ = 0;
+    return;
+  }
+  read_ahead_end_->store(READ_AHEAD_PENDING, std::memory_order_relaxed);
+  buffer_pool_manager_->PrefetchPageChain(end, read_ahead_owed_, &LeafPage::NextPageIdOf, nullptr, read_ahead_end_);
+  read_ahead_owed_ = 0;
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_header_page.cpp
+//
+// Identification: src/storage/page/extendible_hash_table_header_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/extendible_hash_table_header_page.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace bustub {
+
+page_id_t ExtendibleHashTableHeaderPage::GetPageId() const { return page_id_; }
+
+void ExtendibleHashTableHeaderPage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
+
+lsn_t ExtendibleHashTableHeaderPage::GetLSN() const { return lsn_; }
+
+void ExtendibleHashTableHeaderPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+uint32_t ExtendibleHashTableHeaderPage::GetGlobalDepth() const { return global_depth_; }
+
+uint32_t ExtendibleHashTableHeaderPage::GetGlobalDepthMask() const { return (1U << global_depth_) - 1; }
+
+void ExtendibleHashTableHeaderPage::IncrGlobalDepth() {
+  assert(global_depth_ < MAX_GLOBAL_DEPTH);
+  global_depth_++;
+}
+
+void ExtendibleHashTableHeaderPage::DecrGlobalDepth() {
+  assert(global_depth_ > 0);
+  global_depth_--;
+}
+
+uint32_t ExtendibleHashTableHeaderPage::Size() const { return 1U << global_depth_; }
+
+uint32_t ExtendibleHashTableHeaderPage::NumDirectoryPages() const {
+  return std::max<uint32_t>(Size() / DIRECTORY_ARRAY_SIZE, 1);
+}
+
+page_id_t ExtendibleHashTableHeaderPage::GetDirectoryPageId(uint32_t directory_idx) const {
+  return directory_page_ids_[directory_idx];
+}
+
+void ExtendibleHashTableHeaderPage::SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id) {
+  directory_page_ids_[directory_idx] = directory_page_id;
+}
+
+}  // namespace bustub
@@ -11,15 +11,26 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <memory>
 
+#include "common/exception.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(std::move(strategy)) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    // The first page is resident now; start reading the ones after it.
+    BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+    size_t read_ahead_distance = buffer_pool_manager->GetReadAheadDistance();
+    if (read_ahead_distance > 0) {
+      read_ahead_end_ = std::make_shared<std::atomic<page_id_t>>(READ_AHEAD_PENDING);
+      buffer_pool_manager->PrefetchPageChain(rid.GetPageId(), read_ahead_distance + 1, &TablePage::NextPageIdOf,
+                                             strategy_, read_ahead_end_);
+    }
   }
 }
 
@@ -35,19 +46,33 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  if (read_ahead_owed_ > 0) {
+    ExtendReadAhead();
+  }
   auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  if (cur_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left for a table page");
+  }
   cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page = static_cast<TablePage *>(
+          buffer_pool_manager->FetchPageWithStrategy(cur_page->GetNextPageId(), strategy_.get()));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+      if (next_page == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "no frame left for a table page");
+      }
       cur_page = next_page;
       cur_page->RLatch();
+      // Stepping onto the next page moves the window on by one, so only the page entering it at the far end is new.
+      if (read_ahead_end_ != nullptr) {
+        read_ahead_owed_++;
+        ExtendReadAhead();
+      }
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -70,4 +95,20 @@ TableIterator TableIterator::operator++(int) {
   return clone;
 }
 
+void TableIterator::ExtendReadAhead() {
+  // The ids of the pages entering the window are known once the previous request has walked the chain that far.
+  page_id_t end = read_ahead_end_->load(std::memory_order_acquire);
+  if (end == READ_AHEAD_PENDING) {
+    return;
+  }
+  if (end == INVALID_PAGE_ID) {
+    read_ahead_owed_ = 0;
+    return;
+  }
+  read_ahead_end_->store(READ_AHEAD_PENDING, std::memory_order_relaxed);
+  table_heap_->buffer_pool_manager_->PrefetchPageChain(end, read_ahead_owed_, &TablePage::NextPageIdOf, strategy_,
+                                                       read_ahead_end_);
+  read_ahead_owed_ = 0;
+}
+
 }  // namespace bustub
@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer_test.cpp
+//
+// Identification: test/buffer/arc_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer arc_replacer(4, 0);
+
+  // Scenario: admit pages 10-13 into frames 0-3 and unpin them. Page 10 is referenced a second time.
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    arc_replacer.Admit(frame_id, 10 + frame_id);
+    arc_replacer.Unpin(frame_id);
+  }
+  arc_replacer.Pin(0);
+  arc_replacer.Unpin(0);
+  EXPECT_EQ(4, arc_replacer.Size());
+  ARCReplacerStats stats = arc_replacer.GetStats();
+  EXPECT_EQ(0, stats.target_t1_size_);
+  EXPECT_EQ(3, stats.t1_size_);
+  EXPECT_EQ(1, stats.t2_size_);
+
+  // Scenario: T1 is over its target, so pages seen once are evicted first and remembered on B1.
+  int value;
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(2, arc_replacer.GetStats().b1_size_);
+
+  // Scenario: page 11 comes back. The B1 ghost hit grows the T1 target and the page goes straight to T2.
+  arc_replacer.Admit(1, 11);
+  stats = arc_replacer.GetStats();
+  EXPECT_EQ(1, stats.target_t1_size_);
+  EXPECT_EQ(1, stats.b1_size_);
+  EXPECT_EQ(2, stats.t2_size_);
+
+  // Scenario: pinned frames are never victims. T1 (frame 3) is at its target, so T2 goes next.
+  arc_replacer.Unpin(1);
+  arc_replacer.Pin(0);
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(1, arc_replacer.GetStats().b2_size_);
+
+  // Scenario: page 11 comes back again, this time from B2, which shrinks the T1 target.
+  arc_replacer.Admit(1, 11);
+  EXPECT_EQ(0, arc_replacer.GetStats().target_t1_size_);
+
+  // Scenario: removed frames are forgotten without leaving a ghost behind.
+  arc_replacer.Remove(3);
+  EXPECT_EQ(0, arc_replacer.Size());
+  EXPECT_FALSE(arc_replacer.Victim(&value));
+}
+
+TEST(ARCReplacerTest, UnclaimedVictimTest) {
+  ARCReplacer arc_replacer(4, 0);
+  for (frame_id_t frame_id = 0; frame_id < 2; frame_id++) {
+    arc_replacer.Admit(frame_id, 10 + frame_id);
+    arc_replacer.Unpin(frame_id);
+  }
+
+  // Scenario: the buffer pool cannot claim a victim that was pinned again meanwhile. Once unpinned, its page is
+  // resident and evictable on T1 again, and no ghost.
+  int value;
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_EQ(1, arc_replacer.GetStats().b1_size_);
+  arc_replacer.Pin(0);
+  arc_replacer.Unpin(0);
+  ARCReplacerStats stats = arc_replacer.GetStats();
+  EXPECT_EQ(0, stats.b1_size_);
+  EXPECT_EQ(2, stats.t1_size_);
+  EXPECT_EQ(2, arc_replacer.Size());
+
+  // Scenario: evicted for real later, the page is remembered once.
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  arc_replacer.Admit(0, 20);
+  EXPECT_EQ(2, arc_replacer.GetStats().b1_size_);
+  arc_replacer.Admit(1, 10);
+  stats = arc_replacer.GetStats();
+  EXPECT_EQ(1, stats.b1_size_);
+  EXPECT_EQ(1, stats.t2_size_);
+}
+
+TEST(ARCReplacerTest, PrefetchTest) {
+  ARCReplacer arc_replacer(4, 0);
+
+  // Scenario: a page brought in by read-ahead is evictable right away and sits on T1.
+  arc_replacer.AdmitPrefetched(0, 10);
+  EXPECT_EQ(1, arc_replacer.Size());
+  EXPECT_EQ(1, arc_replacer.GetStats().t1_size_);
+
+  // Scenario: its first use is its first reference, so it stays on T1; the second use makes it frequent.
+  arc_replacer.Pin(0);
+  arc_replacer.Unpin(0);
+  EXPECT_EQ(1, arc_replacer.GetStats().t1_size_);
+  arc_replacer.Pin(0);
+  arc_replacer.Unpin(0);
+  EXPECT_EQ(0, arc_replacer.GetStats().t1_size_);
+  EXPECT_EQ(1, arc_replacer.GetStats().t2_size_);
+}
+
+TEST(ARCReplacerTest, PrefetchedGhostTest) {
+  ARCReplacer arc_replacer(4, 0);
+  arc_replacer.Admit(0, 10);
+  arc_replacer.Unpin(0);
+  int value;
+  ASSERT_TRUE(arc_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: read-ahead brings page 10 back from B1. That is not a reference, so T1 keeps its target and the page.
+  arc_replacer.AdmitPrefetched(0, 10);
+  ARCReplacerStats stats = arc_replacer.GetStats();
+  EXPECT_EQ(0, stats.target_t1_size_);
+  EXPECT_EQ(0, stats.b1_size_);
+  EXPECT_EQ(1, stats.t1_size_);
+
+  // Scenario: the page is used. Now the ghost hit counts.
+  arc_replacer.Pin(0);
+  arc_replacer.Unpin(0);
+  stats = arc_replacer.GetStats();
+  EXPECT_EQ(1, stats.target_t1_size_);
+  EXPECT_EQ(1, stats.t2_size_);
+}
+
+TEST(ARCReplacerTest, ScanRePinTest) {
+  ARCReplacer arc_replacer(8);
+
+  // Scenario: page 13 is referenced twice, further apart than the default correlated reference period, and page 12
+  // many times within it. Then a scan reaches page 10 and pins it once per tuple, with a point lookup on page 11
+  // between tuples.
+  for (frame_id_t frame_id = 1; frame_id < 4; frame_id++) {
+    arc_replacer.Admit(frame_id, 10 + frame_id);
+    arc_replacer.Unpin(frame_id);
+  }
+  for (size_t i = 0; i < 8; i++) {
+    arc_replacer.Pin(2);
+    arc_replacer.Unpin(2);
+  }
+  arc_replacer.Pin(3);
+  arc_replacer.Unpin(3);
+  arc_replacer.Admit(0, 10);
+  arc_replacer.Unpin(0);
+  for (frame_id_t frame_id : {0, 1, 0, 1, 0}) {
+    arc_replacer.Pin(frame_id);
+    arc_replacer.Unpin(frame_id);
+  }
+
+  // Pages 13 and 11 are frequent. The pins of the scanned page and of page 12 were one reference each.
+  ARCReplacerStats stats = arc_replacer.GetStats();
+  EXPECT_EQ(2, stats.t1_size_);
+  EXPECT_EQ(2, stats.t2_size_);
+  EXPECT_EQ((std::vector<frame_id_t>{2, 0, 3, 1}), arc_replacer.GetEvictionOrder());
+}
+
+}  // namespace bustub
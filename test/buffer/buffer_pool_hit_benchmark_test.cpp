@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_hit_benchmark_test.cpp
+//
+// Identification: test/buffer/buffer_pool_hit_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+// Measures FetchPage/UnpinPage throughput when every page is resident, from 1 to 64 threads.
+TEST(BufferPoolHitBenchmark, HitThroughput) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 256;
+  const size_t ops_per_run = 1 << 18;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Fill the pool and tag every page with its id so readers can validate what they fetched.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  std::printf("%8s %16s\n", "threads", "hits/sec");
+  for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    std::atomic<size_t> errors{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&, tid] {
+        std::mt19937 rng(tid);
+        std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+        char expected[16];
+        for (size_t i = 0; i < ops_per_run / num_threads; i++) {
+          page_id_t page_id = page_ids[dist(rng)];
+          Page *page = bpm->FetchPage(page_id);
+          snprintf(expected, sizeof(expected), "%d", page_id);
+          if (page == nullptr || strcmp(page->GetData(), expected) != 0) {
+            errors++;
+          }
+          if (page != nullptr) {
+            bpm->UnpinPage(page_id, false);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%8zu %16.0f\n", num_threads, static_cast<double>(ops_per_run) / elapsed.count());
+    EXPECT_EQ(0, errors.load());
+  }
+
+  // Every pin taken by the benchmark must have been released.
+  for (auto page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    bpm->UnpinPage(page_id, false);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Lock-free hits racing with evictions must never hand out a frame holding the wrong page.
+TEST(BufferPoolHitBenchmark, HitsRacingEvictions) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 64;
+  const size_t num_threads = 8;
+  const size_t ops_per_thread = 5000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  std::atomic<size_t> errors{0};
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      char expected[16];
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        page_id_t page_id = dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        snprintf(expected, sizeof(expected), "%d", page_id);
+        if (page->GetPageId() != page_id || strcmp(page->GetData(), expected) != 0) {
+          errors++;
+        }
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, errors.load());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -11,17 +11,23 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <chrono>  // NOLINT
+#include <atomic>
 #include <cstdio>
+#include <cstring>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "recovery/log_manager.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
-TEST(BufferPoolManagerInstanceTest, DISABLED_BinaryDataTest) {
+TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
   const std::string db_name = "test.db";
   const size_t buffer_pool_size = 10;
 
@@ -86,7 +92,7 @@ TEST(BufferPoolManagerInstanceTest, DISABLED_BinaryDataTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(BufferPoolManagerInstanceTest, DISABLED_SampleTest) {
+TEST(BufferPoolManagerInstanceTest, SampleTest) {
   const std::string db_name = "test.db";
   const size_t buffer_pool_size = 10;
 
@@ -141,4 +147,346 @@ TEST(BufferPoolManagerInstanceTest, DISABLED_SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Every replacement policy must evict unpinned pages only, and bring evicted pages back intact.
+TEST(BufferPoolManagerInstanceTest, ReplacerPoliciesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  for (auto replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::LRU_K, ReplacerType::ARC}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, replacer_type);
+
+    // Scenario: fill the pool, then unpin everything but page 0.
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+      if (page_id_temp != 0) {
+        EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+      }
+    }
+
+    // Scenario: cycle through twice as many new pages; page 0 stays pinned and resident throughout.
+    for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+    }
+    EXPECT_EQ(1, bpm->GetPages()[0].GetPinCount());
+    EXPECT_EQ(0, strcmp(bpm->GetPages()[0].GetData(), "page 0"));
+
+    // Scenario: evicted dirty pages were written back and can be fetched again.
+    for (page_id_t page_id = 1; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+    disk_manager->ShutDown();
+    remove("test.db");
+
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+/** Polls cond for up to a second. @return the last value of cond */
+template <class Cond>
+bool WaitFor(Cond cond) {
+  for (int i = 0; i < 100 && !cond(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return cond();
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundWriterTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, log_manager);
+
+  // Scenario: fill the pool with dirty pages. Pages 0-4 carry an LSN that is not yet persistent in the log.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData() + 64, PAGE_SIZE - 64, "page %d", page_id_temp);
+    page->SetLSN(page_id_temp < 5 ? 7 : INVALID_LSN);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(0, bpm->GetNumCleanFrames());
+
+  // Scenario: with logging enabled, the writer may only write back pages covered by the persistent log.
+  enable_logging = true;
+  bpm->StartBackgroundWriter(1.0, 2);
+  EXPECT_TRUE(WaitFor([&] { return bpm->GetNumCleanFrames() == 5; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(5, bpm->GetNumCleanFrames());
+  for (page_id_t page_id = 0; page_id < 5; ++page_id) {
+    EXPECT_TRUE(bpm->GetPages()[page_id].IsDirty());
+  }
+
+  log_manager->SetPersistentLSN(7);
+  EXPECT_TRUE(WaitFor([&] { return bpm->GetNumCleanFrames() == buffer_pool_size; }));
+  bpm->StopBackgroundWriter();
+  enable_logging = false;
+  EXPECT_EQ(buffer_pool_size, bpm->GetNumBackgroundWrites());
+  EXPECT_EQ(static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+
+  // Scenario: evicting the now clean pages writes nothing.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+
+  // Scenario: the written-back contents survive eviction.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData() + 64, ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete log_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(i, page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a deleted page's id is handed out again, whether or not the page was still resident.
+  EXPECT_TRUE(bpm->DeletePage(1));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(1, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: a page created near another one follows it in the same extent, skipping the free page before it.
+  EXPECT_TRUE(bpm->DeletePage(0));
+  ASSERT_NE(nullptr, bpm->NewPageNear(&page_id_temp, 2));
+  EXPECT_EQ(3, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  EXPECT_FALSE(disk_manager->IsPageAllocated(0));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(0U, stats.num_hits_);
+  EXPECT_EQ(0U, stats.num_misses_);
+  EXPECT_EQ(0U, stats.free_list_length_);
+  EXPECT_EQ(0U, stats.num_pinned_frames_);
+
+  // Scenario: a resident page is a hit.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(1U, bpm->GetStats().num_pinned_frames_);
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  // Scenario: a new page and a miss each evict a dirty page, least recently used first.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  stats = bpm->GetStats();
+  EXPECT_EQ(1U, stats.num_hits_);
+  EXPECT_EQ(1U, stats.num_misses_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+  EXPECT_EQ(2U, stats.num_evictions_);
+  EXPECT_EQ(2U, stats.num_dirty_write_backs_);
+  EXPECT_EQ(0U, stats.num_pin_waits_);
+  EXPECT_EQ(1U, stats.miss_latency_.count_);
+  EXPECT_EQ(2U, disk_manager->GetStats().num_writes_);
+  EXPECT_EQ(1U, disk_manager->GetStats().num_reads_);
+
+  // Scenario: deleted pages give their frames back to the free list.
+  EXPECT_TRUE(bpm->DeletePage(1));
+  EXPECT_EQ(1U, bpm->GetStats().free_list_length_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, page_id_temp < 2));
+  }
+
+  // Scenario: only dirty pages are written, and they are clean afterwards.
+  bpm->FlushAllPages();
+  EXPECT_EQ(2U, disk_manager->GetStats().num_writes_);
+  bpm->FlushAllPages();
+  EXPECT_EQ(2U, disk_manager->GetStats().num_writes_);
+
+  // Scenario: a page being modified is copied only once its writer is done, and the buffer pool stays usable while
+  // the flush waits for it.
+  Page *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  page->WLatch();
+  EXPECT_TRUE(bpm->UnpinPage(1, true));
+  std::atomic<bool> flushed{false};
+  std::thread flusher([&] {
+    bpm->FlushAllPages();
+    flushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(flushed);
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+  snprintf(page->GetData(), PAGE_SIZE, "changed");
+  page->WUnlatch();
+  flusher.join();
+  EXPECT_EQ(3U, disk_manager->GetStats().num_writes_);
+  char buf[PAGE_SIZE];
+  disk_manager->ReadPage(1, buf);
+  EXPECT_STREQ("changed", buf);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmUpTest) {
+  const std::string db_name = "test.db";
+  const std::string warm_up_file = "test.warm";
+  const size_t buffer_pool_size = 5;
+  remove(warm_up_file.c_str());
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: there is no saved list to warm up from yet.
+  bpm->EnableWarmUp(warm_up_file);
+  EXPECT_EQ(0, bpm->WaitForWarmUp());
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < 8; i++) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: pinned pages are the hottest, followed by the others from most recently used.
+  ASSERT_NE(nullptr, bpm->FetchPage(4));
+  EXPECT_TRUE(bpm->UnpinPage(4, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(6));
+  EXPECT_EQ((std::vector<page_id_t>{6, 4, 7, 5, 3}), bpm->GetHotPages());
+  EXPECT_TRUE(bpm->UnpinPage(6, false));
+  bpm->FlushAllPages();
+  // Saves the hot pages to the file.
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  EXPECT_EQ((std::vector<page_id_t>{6, 4, 7, 5, 3}), BufferPoolManager::LoadHotPages(warm_up_file));
+
+  // Scenario: after a restart with a smaller pool, the hottest pages that fit are back before they are fetched.
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManagerInstance(3, disk_manager);
+  bpm->EnableWarmUp(warm_up_file);
+  EXPECT_EQ(3, bpm->WaitForWarmUp());
+  EXPECT_EQ(0U, bpm->GetStats().free_list_length_);
+  EXPECT_EQ(3U, bpm->GetStats().num_prefetches_);
+  for (page_id_t page_id : {6, 4, 7}) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(3U, bpm->GetStats().num_hits_);
+  EXPECT_EQ(0U, bpm->GetStats().num_misses_);
+
+  // Scenario: a damaged list is ignored.
+  FILE *file = fopen(warm_up_file.c_str(), "r+");
+  ASSERT_NE(nullptr, file);
+  fputs("garbage", file);
+  fclose(file);
+  EXPECT_TRUE(BufferPoolManager::LoadHotPages(warm_up_file).empty());
+  delete bpm;
+
+  // Scenario: fetches racing a warm-up of the same pages, which reads with the latch released, neither read a page
+  // twice nor see it before it is read in.
+  bpm = new BufferPoolManagerInstance(8, disk_manager);
+  std::thread fetcher([&] {
+    for (page_id_t page_id : {3, 7, 0, 5, 1}) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  });
+  bpm->WarmUp({0, 1, 2, 3, 4, 5, 6, 7});
+  fetcher.join();
+  for (page_id_t page_id = 0; page_id < 8; page_id++) {
+    int copies = 0;
+    for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+      copies += bpm->GetPages()[i].GetPageId() == page_id ? 1 : 0;
+    }
+    EXPECT_EQ(1, copies) << "page " << page_id;
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(warm_up_file.c_str());
+
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -19,7 +19,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +59,22 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, EvictionOrderTest) {
+  ClockReplacer clock_replacer(7);
+  clock_replacer.Unpin(1);
+  clock_replacer.Unpin(2);
+  clock_replacer.Unpin(3);
+  int value;
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: the sweep cleared the reference bits of 2 and 3, while 1 comes back referenced.
+  clock_replacer.Unpin(1);
+  EXPECT_EQ((std::vector<frame_id_t>{2, 3, 1}), clock_replacer.GetEvictionOrder());
+  for (frame_id_t expected : {2, 3, 1}) {
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+}
+
 }  // namespace bustub
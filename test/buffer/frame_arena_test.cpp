@@ -0,0 +1,180 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, AlignmentTest) {
+  for (bool use_huge_pages : {true, false}) {
+    // Scenario: frames are PAGE_SIZE-aligned, contiguous and zeroed, whatever backs the arena.
+    FrameArena arena(1000, use_huge_pages);
+    EXPECT_EQ(1000, arena.GetNumFrames());
+    if (!use_huge_pages) {
+      EXPECT_EQ(FrameArena::Backing::REGULAR_PAGES, arena.GetBacking());
+    }
+    for (size_t i = 0; i < arena.GetNumFrames(); i++) {
+      char *data = arena.GetFrameData(i);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(data) % PAGE_SIZE);
+      EXPECT_EQ(arena.GetFrameData(0) + i * PAGE_SIZE, data);
+      EXPECT_EQ(0, data[0]);
+      EXPECT_EQ(0, data[PAGE_SIZE - 1]);
+      memset(data, static_cast<int>(i), PAGE_SIZE);
+    }
+  }
+
+  // Scenario: an arena smaller than a huge page does not take one, even when huge pages are reserved.
+  FrameArena small_arena(1, true);
+  EXPECT_EQ(FrameArena::Backing::REGULAR_PAGES, small_arena.GetBacking());
+
+  // Scenario: buffer pool pages hand out arena data, and standalone pages get aligned data of their own.
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(bpm->GetFrameArena()->GetFrameData(i), bpm->GetPages()[i].GetData());
+  }
+  Page page;
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page.GetData()) % PAGE_SIZE);
+  EXPECT_EQ(0, page.GetData()[PAGE_SIZE - 1]);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+/** Counts data TLB read misses of the calling thread, if the kernel lets us. */
+class DTLBMissCounter {
+ public:
+  DTLBMissCounter() {
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~DTLBMissCounter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  void Start() {
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  /** @return misses since Start(), or -1 if the counter is not available */
+  int64_t Stop() {
+    if (fd_ < 0) {
+      return -1;
+    }
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    int64_t count;
+    return read(fd_, &count, sizeof(count)) == sizeof(count) ? count : -1;
+  }
+
+ private:
+  int fd_;
+};
+
+/** The layout the buffer pool used before FrameArena: data and metadata interleaved in one array. */
+struct InterleavedFrame {
+  char data_[PAGE_SIZE];
+  std::atomic<page_id_t> page_id_;
+  std::atomic<int> pin_count_;
+  std::atomic<bool> is_dirty_;
+};
+
+// Random 8-byte reads spread over a 128 MB pool, the access pattern of point lookups on a large buffer pool, comparing
+// the interleaved layout with the arena on regular and on huge pages.
+// NOLINTNEXTLINE
+TEST(FrameArenaBenchmark, RandomAccess) {
+  const size_t num_frames = 32768;
+  const size_t num_accesses = 1 << 22;
+
+  std::vector<uint32_t> frames(num_accesses);
+  std::vector<uint32_t> offsets(num_accesses);
+  std::mt19937 rng(15445);
+  for (size_t i = 0; i < num_accesses; i++) {
+    frames[i] = rng() % num_frames;
+    offsets[i] = rng() % (PAGE_SIZE / sizeof(uint64_t)) * sizeof(uint64_t);
+  }
+
+  auto run = [&](const std::string &name, const std::function<char *(size_t)> &frame_data) {
+    // Touch every frame first so that page faults are not measured.
+    for (size_t i = 0; i < num_frames; i++) {
+      memset(frame_data(i), 1, PAGE_SIZE);
+    }
+    std::vector<char *> data(num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+      data[i] = frame_data(i);
+    }
+    DTLBMissCounter counter;
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    counter.Start();
+    for (size_t i = 0; i < num_accesses; i++) {
+      uint64_t value;
+      memcpy(&value, data[frames[i]] + offsets[i], sizeof(value));
+      sum += value;
+    }
+    int64_t misses = counter.Stop();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::string miss_text = misses < 0 ? "n/a" : std::to_string(misses);
+    std::printf("%-22s %12.1f %14s\n", name.c_str(), num_accesses / elapsed.count() / 1e6, miss_text.c_str());
+    EXPECT_EQ(num_accesses * 0x0101010101010101ULL, sum);
+  };
+
+  std::printf("%-22s %12s %14s\n", "layout", "M reads/s", "dTLB misses");
+  {
+    auto interleaved = std::make_unique<InterleavedFrame[]>(num_frames);
+    run("interleaved", [&](size_t i) { return interleaved[i].data_; });
+  }
+  {
+    FrameArena arena(num_frames, false);
+    run("arena, regular pages", [&](size_t i) { return arena.GetFrameData(i); });
+  }
+  {
+    FrameArena arena(num_frames);
+    std::string name = arena.GetBacking() == FrameArena::Backing::HUGETLB ? "arena, hugetlb" : "arena, THP";
+    run(name, [&](size_t i) { return arena.GetFrameData(i); });
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,151 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+
+  // Scenario: reference frames 1-6 once, then frame 1 a second time.
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_k_replacer.Pin(frame_id);
+    lru_k_replacer.Unpin(frame_id);
+  }
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with a single reference have infinite backward k-distance and go first, oldest first.
+  // Frame 1 has two references and survives even though it was referenced first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+
+  // Scenario: pinned frames are not evictable; victimized frames lose their history.
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(2);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: frame 5 now has two references, its second one more recent than frame 1's.
+  lru_k_replacer.Unpin(5);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 3);
+
+  // Scenario: frame 0 is referenced again right after frame 1, within its correlated reference period.
+  for (frame_id_t frame_id : {0, 1, 0, 2, 3}) {
+    lru_k_replacer.Pin(frame_id);
+    lru_k_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(4, lru_k_replacer.Size());
+
+  // Frame 0 has the oldest first reference but is still inside its correlated period, so frame 1 goes first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Every remaining frame is inside its correlated period; they are evicted in LRU-K order rather than not at all.
+  // The two references to frame 0 were folded into one, so it still has an infinite k-distance and goes first.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  lru_k_replacer.Remove(2);
+  lru_k_replacer.Remove(3);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, ScanRePinTest) {
+  LRUKReplacer lru_k_replacer(8, 2);
+
+  // Scenario: frame 3 is referenced twice, further apart than the default correlated reference period. Then a scan
+  // pins frame 0 once per tuple on its page, with a point lookup on frame 5 between tuples, and moves on to frame 1.
+  for (frame_id_t frame_id : {3, 4, 5, 6, 7, 4, 5, 6, 7, 3, 0, 5, 0, 5, 0, 1, 1, 1}) {
+    lru_k_replacer.Pin(frame_id);
+    lru_k_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(7, lru_k_replacer.Size());
+
+  // The repeated pins of the scanned frames are one reference each, so frame 3 is the only one with a finite backward
+  // k-distance and is listed last.
+  std::vector<frame_id_t> order = lru_k_replacer.GetEvictionOrder();
+  ASSERT_EQ(7, order.size());
+  EXPECT_EQ(3, order.back());
+}
+
+TEST(LRUKReplacerTest, PrefetchTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 0);
+
+  // Scenario: frame 0 is referenced twice. Frames 1 and 2 are filled by read-ahead, and only frame 2 is used.
+  for (int i = 0; i < 2; i++) {
+    lru_k_replacer.Pin(0);
+    lru_k_replacer.Unpin(0);
+  }
+  lru_k_replacer.AdmitPrefetched(1, 11);
+  lru_k_replacer.AdmitPrefetched(2, 12);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(2);
+
+  // The read-ahead is not a reference: frame 2 has been referenced once, so it goes before frame 0.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+}
+
+TEST(LRUKReplacerTest, EvictionOrderTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+  for (frame_id_t frame_id : {1, 2, 3}) {
+    lru_k_replacer.Pin(frame_id);
+    lru_k_replacer.Unpin(frame_id);
+  }
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+
+  // Scenario: frames with infinite backward k-distance are listed first, then the rest by k-distance.
+  EXPECT_EQ((std::vector<frame_id_t>{2, 3, 1}), lru_k_replacer.GetEvictionOrder());
+  int value;
+  for (frame_id_t expected : {2, 3, 1}) {
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+}
+
+}  // namespace bustub
@@ -19,7 +19,7 @@
 
 namespace bustub {
 
-TEST(LRUReplacerTest, DISABLED_SampleTest) {
+TEST(LRUReplacerTest, SampleTest) {
   LRUReplacer lru_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +59,23 @@ TEST(LRUReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(LRUReplacerTest, EvictionOrderTest) {
+  LRUReplacer lru_replacer(7);
+  lru_replacer.Unpin(3);
+  lru_replacer.Unpin(1);
+  lru_replacer.Unpin(2);
+  lru_replacer.Pin(1);
+  lru_replacer.Unpin(1);
+
+  // Scenario: the order is the one victims come out in, and listing it leaves the replacer as it was.
+  EXPECT_EQ((std::vector<frame_id_t>{3, 2, 1}), lru_replacer.GetEvictionOrder());
+  EXPECT_EQ(3, lru_replacer.Size());
+  int value;
+  for (frame_id_t expected : {3, 2, 1}) {
+    ASSERT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_TRUE(lru_replacer.GetEvictionOrder().empty());
+}
+
 }  // namespace bustub
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/buffer/page_guard_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: a guard takes over the pin and releases it when dropped, without marking the page dirty.
+  auto guarded_page = BasicPageGuard(bpm, page0);
+  EXPECT_EQ(page0->GetData(), guarded_page.GetData());
+  EXPECT_EQ(page0->GetPageId(), guarded_page.PageId());
+  EXPECT_EQ(1, page0->GetPinCount());
+  guarded_page.Drop();
+  EXPECT_EQ(0, page0->GetPinCount());
+  EXPECT_FALSE(page0->IsDirty());
+
+  // Scenario: dropping twice, or dropping a moved-from guard, releases nothing.
+  guarded_page.Drop();
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  {
+    auto read_guard = bpm->FetchPageRead(page_id_temp);
+    EXPECT_EQ(1, page0->GetPinCount());
+    auto moved_guard = std::move(read_guard);
+    EXPECT_FALSE(read_guard.IsValid());  // NOLINT
+    EXPECT_EQ(1, page0->GetPinCount());
+    auto another_guard = bpm->FetchPageRead(page_id_temp);
+    EXPECT_EQ(2, page0->GetPinCount());
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  // Scenario: writing through a guard marks the page dirty when the pin is released.
+  {
+    auto write_guard = bpm->FetchPageWrite(page_id_temp);
+    snprintf(write_guard.GetDataMut(), PAGE_SIZE, "Hello");
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+  EXPECT_TRUE(page0->IsDirty());
+
+  // Scenario: moving into a live guard releases the pin it held first.
+  page_id_t page_id_other;
+  {
+    auto guard = bpm->NewPageGuarded(&page_id_other);
+    Page *other = bpm->FetchPage(page_id_other);
+    bpm->UnpinPage(page_id_other, false);
+    EXPECT_EQ(1, other->GetPinCount());
+    guard = bpm->FetchPageBasic(page_id_temp);
+    EXPECT_EQ(0, other->GetPinCount());
+    EXPECT_EQ(1, page0->GetPinCount());
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, UpgradeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  auto basic_guard = bpm->NewPageGuarded(&page_id);
+  ASSERT_TRUE(basic_guard.IsValid());
+
+  // Scenario: upgrading hands the pin to the new guard, which also holds the write latch.
+  auto write_guard = basic_guard.UpgradeWrite();
+  EXPECT_FALSE(basic_guard.IsValid());  // NOLINT
+  snprintf(write_guard.GetDataMut(), PAGE_SIZE, "Hello");
+
+  // A reader must wait for the writer to drop the latch.
+  std::string seen;
+  std::thread reader([&] {
+    auto read_guard = bpm->FetchPageRead(page_id);
+    seen = read_guard.GetData();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  snprintf(write_guard.GetDataMut(), PAGE_SIZE, "World");
+  write_guard.Drop();
+  reader.join();
+  EXPECT_EQ("World", seen);
+
+  // Scenario: every pin has been returned, so the whole pool can be reused and the page comes back from disk.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t new_page_id;
+    EXPECT_TRUE(bpm->NewPageGuarded(&new_page_id).IsValid());
+  }
+  auto read_guard = bpm->FetchPageRead(page_id);
+  ASSERT_TRUE(read_guard.IsValid());
+  EXPECT_STREQ("World", read_guard.GetData());
+  read_guard.Drop();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
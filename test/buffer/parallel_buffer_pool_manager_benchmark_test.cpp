@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_benchmark_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+struct ShardingResult {
+  double ops_per_second_;
+  size_t failed_new_pages_;
+};
+
+/**
+ * Each thread creates pages, keeps the most recent ones pinned as a working set and fetches back pages it created a
+ * little earlier. The working sets add up to most of the pool, so some instances run full while others have room.
+ */
+ShardingResult RunNewFetchWorkload(bool thread_affinity) {
+  const size_t num_threads = 8;
+  const size_t num_instances = 8;
+  const size_t pool_size = 32;
+  const size_t working_set = 24;
+  const size_t ops_per_thread = 20000;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  bpm->SetThreadAffinity(thread_affinity);
+
+  std::atomic<size_t> failed_new_pages{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&] {
+      std::deque<page_id_t> pinned;
+      std::vector<page_id_t> created;
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        if (i % 2 == 0) {
+          page_id_t page_id;
+          if (bpm->NewPage(&page_id) == nullptr) {
+            failed_new_pages++;
+          } else {
+            pinned.push_back(page_id);
+            created.push_back(page_id);
+          }
+        } else if (created.size() > working_set) {
+          page_id_t page_id = created[created.size() - 1 - i % working_set];
+          if (bpm->FetchPage(page_id) != nullptr) {
+            bpm->UnpinPage(page_id, false);
+          }
+        }
+        if (pinned.size() > working_set) {
+          bpm->UnpinPage(pinned.front(), false);
+          pinned.pop_front();
+        }
+      }
+      for (auto page_id : pinned) {
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+  return {num_threads * ops_per_thread / elapsed.count(), failed_new_pages.load()};
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerBenchmark, ShardSelection) {
+  std::printf("%-16s %14s %18s\n", "placement", "ops/s", "failed NewPage");
+  for (bool thread_affinity : {false, true}) {
+    ShardingResult result = RunNewFetchWorkload(thread_affinity);
+    std::printf("%-16s %14.0f %18zu\n", thread_affinity ? "thread affinity" : "round-robin", result.ops_per_second_,
+                result.failed_new_pages_);
+    // The working sets fit in the pool as a whole, so NewPage must find an instance with room.
+    EXPECT_EQ(0, result.failed_new_pages_);
+  }
+}
+
+}  // namespace bustub
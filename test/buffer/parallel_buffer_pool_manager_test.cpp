@@ -14,6 +14,8 @@
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -21,7 +23,7 @@ namespace bustub {
 
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
-TEST(ParallelBufferPoolManagerTest, DISABLED_BinaryDataTest) {
+TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
   const std::string db_name = "test.db";
   const size_t buffer_pool_size = 10;
   const size_t num_instances = 5;
@@ -88,7 +90,7 @@ TEST(ParallelBufferPoolManagerTest, DISABLED_BinaryDataTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(ParallelBufferPoolManagerTest, DISABLED_SampleTest) {
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
   const std::string db_name = "test.db";
   const size_t buffer_pool_size = 10;
   const size_t num_instances = 5;
@@ -151,4 +153,148 @@ TEST(ParallelBufferPoolManagerTest, DISABLED_SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ShardSelectionTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  bpm->SetThreadAffinity(true);
+
+  // Scenario: with thread affinity, a thread keeps placing new pages in its home instance while it has room.
+  const size_t home = bpm->GetHomeInstanceIndex();
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(home, page_id % num_instances);
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(0, bpm->GetInstance(home)->GetNumUnpinnedFrames());
+
+  // Scenario: once the home instance is full, new pages go to the instance with the most unpinned frames.
+  const size_t other = (home + 1) % num_instances;
+  page_id_t pinned_page_id;
+  ASSERT_NE(nullptr, bpm->GetInstance(other)->NewPage(&pinned_page_id));
+  const size_t emptiest = (home + 2) % num_instances;
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(emptiest, page_id % num_instances);
+  EXPECT_EQ(buffer_pool_size - 1, bpm->GetInstance(emptiest)->GetNumUnpinnedFrames());
+
+  // Scenario: another thread has a different home instance.
+  size_t other_home = home;
+  std::thread([&] { other_home = bpm->GetHomeInstanceIndex(); }).join();
+  EXPECT_NE(home, other_home);
+
+  // Scenario: unpinning gives the home instance its frames back.
+  for (auto id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetInstance(home)->GetNumUnpinnedFrames());
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(home, page_id % num_instances);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: fill every instance, then fetch every page once and one page a second time.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    page_ids.push_back(page_id);
+  }
+  for (auto page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+
+  // Scenario: the stats of the parallel buffer pool are those of its instances added up.
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(num_instances * buffer_pool_size + 1, stats.num_hits_);
+  EXPECT_EQ(0U, stats.num_misses_);
+  EXPECT_EQ(1U, stats.num_pinned_frames_);
+  BufferPoolStats sum;
+  for (size_t i = 0; i < num_instances; i++) {
+    BufferPoolStats instance_stats = bpm->GetInstance(i)->GetStats();
+    EXPECT_EQ(buffer_pool_size + (page_ids[0] % num_instances == i ? 1 : 0), instance_stats.num_hits_);
+    sum += instance_stats;
+  }
+  EXPECT_EQ(sum.num_hits_, stats.num_hits_);
+  EXPECT_EQ(sum.num_pinned_frames_, stats.num_pinned_frames_);
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, WarmUpTest) {
+  const std::string db_name = "test.db";
+  const std::string warm_up_file = "test.warm";
+  const size_t buffer_pool_size = 3;
+  const size_t num_instances = 2;
+  remove(warm_up_file.c_str());
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  bpm->EnableWarmUp(warm_up_file);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: the instances' lists are interleaved, so the first pages listed belong to different instances.
+  std::vector<page_id_t> hot_pages = bpm->GetHotPages();
+  ASSERT_EQ(page_ids.size(), hot_pages.size());
+  EXPECT_NE(hot_pages[0] % num_instances, hot_pages[1] % num_instances);
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: every instance fills its own frames after a restart.
+  disk_manager = new DiskManager(db_name);
+  bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  bpm->EnableWarmUp(warm_up_file);
+  EXPECT_EQ(page_ids.size(), bpm->WaitForWarmUp());
+  for (auto page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(page_ids.size(), bpm->GetStats().num_hits_);
+  EXPECT_EQ(0U, bpm->GetStats().num_misses_);
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(warm_up_file.c_str());
+
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -0,0 +1,303 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_benchmark_test.cpp
+//
+// Identification: test/buffer/replacer_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/**
+ * Drives a replacer the way BufferPoolManagerInstance does (admit on a miss, pin on a hit, unpin when done, victimize
+ * on a miss once the free list is empty) and counts hits, without doing any I/O.
+ */
+class SimulatedPool {
+ public:
+  SimulatedPool(Replacer *replacer, size_t pool_size) : replacer_(replacer), frame_to_page_(pool_size) {
+    for (size_t i = 0; i < pool_size; i++) {
+      free_list_.push_back(static_cast<frame_id_t>(i));
+    }
+  }
+
+  /** @return true if page_id was resident */
+  bool Access(page_id_t page_id) {
+    auto it = page_to_frame_.find(page_id);
+    if (it != page_to_frame_.end()) {
+      replacer_->Pin(it->second);
+      replacer_->Unpin(it->second);
+      return true;
+    }
+    frame_id_t frame_id;
+    if (!free_list_.empty()) {
+      frame_id = free_list_.front();
+      free_list_.pop_front();
+    } else {
+      EXPECT_TRUE(replacer_->Victim(&frame_id));
+      page_to_frame_.erase(frame_to_page_[frame_id]);
+    }
+    frame_to_page_[frame_id] = page_id;
+    page_to_frame_[page_id] = frame_id;
+    replacer_->Admit(frame_id, page_id);
+    replacer_->Unpin(frame_id);
+    return false;
+  }
+
+ private:
+  Replacer *replacer_;
+  std::list<frame_id_t> free_list_;
+  std::vector<page_id_t> frame_to_page_;
+  std::unordered_map<page_id_t, frame_id_t> page_to_frame_;
+};
+
+struct HitRatios {
+  double point_lookup_;
+  double overall_;
+};
+
+/**
+ * Point lookups over a hot set of index pages that fits in the pool, interleaved with full sequential scans of a
+ * table several times larger than the pool.
+ */
+HitRatios RunMixedWorkload(Replacer *replacer, size_t pool_size) {
+  const size_t hot_pages = pool_size * 5 / 8;
+  const size_t table_pages = pool_size * 16;
+  const size_t num_scans = 4;
+  const page_id_t table_start = static_cast<page_id_t>(hot_pages);
+
+  SimulatedPool pool(replacer, pool_size);
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, static_cast<page_id_t>(hot_pages) - 1);
+
+  // Warm the hot set up before measuring.
+  for (size_t i = 0; i < hot_pages * 4; i++) {
+    pool.Access(hot_dist(rng));
+  }
+
+  size_t lookups = 0;
+  size_t lookup_hits = 0;
+  size_t accesses = 0;
+  size_t hits = 0;
+  for (size_t scan = 0; scan < num_scans; scan++) {
+    for (size_t i = 0; i < table_pages; i++) {
+      hits += pool.Access(table_start + static_cast<page_id_t>(i)) ? 1 : 0;
+      accesses++;
+      // One point lookup for every other scanned page.
+      if (i % 2 == 0) {
+        bool hit = pool.Access(hot_dist(rng));
+        lookup_hits += hit ? 1 : 0;
+        hits += hit ? 1 : 0;
+        lookups++;
+        accesses++;
+      }
+    }
+  }
+  return {static_cast<double>(lookup_hits) / lookups, static_cast<double>(hits) / accesses};
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacerBenchmark, ScanResistance) {
+  const size_t pool_size = 64;
+
+  LRUReplacer lru(pool_size);
+  ClockReplacer clock(pool_size);
+  LRUKReplacer lru_k(pool_size, 2);
+  ARCReplacer arc(pool_size);
+
+  std::printf("%-8s %20s %12s\n", "policy", "point lookup hits", "all hits");
+  std::vector<std::pair<std::string, Replacer *>> policies = {
+      {"LRU", &lru}, {"Clock", &clock}, {"LRU-2", &lru_k}, {"ARC", &arc}};
+  std::unordered_map<std::string, HitRatios> results;
+  for (auto &[name, replacer] : policies) {
+    HitRatios ratios = RunMixedWorkload(replacer, pool_size);
+    std::printf("%-8s %19.1f%% %11.1f%%\n", name.c_str(), ratios.point_lookup_ * 100, ratios.overall_ * 100);
+    results[name] = ratios;
+  }
+
+  // The scan must not flush the hot set out of an LRU-K pool the way it does under LRU and Clock.
+  EXPECT_GT(results["LRU-2"].point_lookup_, 0.9);
+  EXPECT_GT(results["LRU-2"].point_lookup_, results["LRU"].point_lookup_);
+  EXPECT_GT(results["LRU-2"].point_lookup_, results["Clock"].point_lookup_);
+  EXPECT_GT(results["ARC"].point_lookup_, results["LRU"].point_lookup_);
+  EXPECT_GT(results["ARC"].point_lookup_, results["Clock"].point_lookup_);
+}
+
+// NOLINTNEXTLINE
+// Alternates OLTP phases (a hot set re-referenced at random) and phases looping over a table that only fits in the
+// pool alongside part of the hot set, printing the ARC adaptation target as it moves between them.
+TEST(ReplacerBenchmark, ARCAdaptation) {
+  const size_t pool_size = 64;
+  const size_t hot_pages = pool_size / 2;
+  const page_id_t scan_start = 1 << 20;
+  const size_t scan_pages = pool_size * 3 / 4;
+
+  ARCReplacer arc(pool_size);
+  LRUReplacer lru(pool_size);
+  SimulatedPool arc_pool(&arc, pool_size);
+  SimulatedPool lru_pool(&lru, pool_size);
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, static_cast<page_id_t>(hot_pages) - 1);
+
+  std::printf("%-6s %-6s %10s %10s %14s\n", "round", "phase", "ARC hits", "LRU hits", "T1 target");
+  size_t scan_pos = 0;
+  size_t max_target = 0;
+  for (size_t round = 0; round < 6; round++) {
+    bool scan_phase = round % 2 == 1;
+    size_t arc_hits = 0;
+    size_t lru_hits = 0;
+    const size_t accesses = pool_size * 8;
+    for (size_t i = 0; i < accesses; i++) {
+      // Scan phases still see some point lookups.
+      page_id_t page_id = hot_dist(rng);
+      if (scan_phase && i % 4 != 0) {
+        page_id = scan_start + static_cast<page_id_t>(scan_pos++ % scan_pages);
+      }
+      arc_hits += arc_pool.Access(page_id) ? 1 : 0;
+      lru_hits += lru_pool.Access(page_id) ? 1 : 0;
+    }
+    std::printf("%-6zu %-6s %9.1f%% %9.1f%% %14zu\n", round, scan_phase ? "scan" : "oltp",
+                100.0 * arc_hits / accesses, 100.0 * lru_hits / accesses, arc.GetStats().target_t1_size_);
+    max_target = std::max(max_target, arc.GetStats().target_t1_size_);
+  }
+  // The first loop over the table keeps returning pages just evicted from T1, which must grow the T1 target.
+  EXPECT_GT(max_target, 0);
+
+  ARCReplacerStats stats = arc.GetStats();
+  EXPECT_LE(stats.target_t1_size_, pool_size);
+  EXPECT_LE(stats.b1_size_ + stats.b2_size_, pool_size);
+}
+
+// NOLINTNEXTLINE
+// The workload of ScanResistance through a real buffer pool: a TableIterator fetches the page it is on once per tuple,
+// so a scan pins each of its pages many times in a row, which must still count as a single reference.
+TEST(ReplacerBenchmark, TableScanResistance) {
+  const size_t pool_size = 64;
+  const size_t hot_pages = pool_size * 5 / 8;
+  const size_t table_pages = pool_size * 8;
+  const size_t num_scans = 2;
+  Schema schema({Column("payload", TypeId::VARCHAR, 200)});
+  std::vector<Value> values{ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+  Tuple tuple(values, &schema);
+  Transaction txn(0);
+
+  // Build the table and the hot set through a pool of their own, so that each policy starts without their history.
+  remove("test.db");
+  auto *disk_manager = new DiskManager("test.db");
+  page_id_t first_page_id;
+  std::vector<page_id_t> hot_page_ids(hot_pages);
+  {
+    BufferPoolManagerInstance bpm(pool_size, disk_manager);
+    // Append the table a page at a time; TableHeap::InsertTuple looks for space from the first page on every insert.
+    auto *page = static_cast<TablePage *>(bpm.NewPage(&first_page_id));
+    page->Init(first_page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, &txn);
+    for (size_t i = 0; i < table_pages; i++) {
+      RID rid;
+      while (page->InsertTuple(tuple, &rid, &txn, nullptr, nullptr)) {
+      }
+      if (i + 1 == table_pages) {
+        break;
+      }
+      page_id_t next_page_id;
+      auto *next_page = static_cast<TablePage *>(bpm.NewPage(&next_page_id));
+      next_page->Init(next_page_id, PAGE_SIZE, page->GetTablePageId(), nullptr, &txn);
+      page->SetNextPageId(next_page_id);
+      bpm.UnpinPage(page->GetTablePageId(), true);
+      page = next_page;
+    }
+    bpm.UnpinPage(page->GetTablePageId(), true);
+    for (auto &page_id : hot_page_ids) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+      bpm.UnpinPage(page_id, true);
+    }
+    bpm.FlushAllPages();
+  }
+
+  std::printf("%-8s %20s %12s\n", "policy", "point lookup hits", "all hits");
+  std::vector<std::pair<std::string, ReplacerType>> policies = {{"LRU", ReplacerType::LRU},
+                                                                {"Clock", ReplacerType::CLOCK},
+                                                                {"LRU-2", ReplacerType::LRU_K},
+                                                                {"ARC", ReplacerType::ARC}};
+  std::unordered_map<std::string, double> lookup_hit_ratios;
+  for (auto &[name, replacer_type] : policies) {
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, nullptr, replacer_type);
+    TableHeap table(bpm, nullptr, nullptr, first_page_id);
+
+    // Warm the hot set up before measuring.
+    std::mt19937 rng(15445);
+    std::uniform_int_distribution<size_t> hot_dist(0, hot_pages - 1);
+    for (size_t i = 0; i < hot_pages * 4; i++) {
+      page_id_t page_id = hot_page_ids[hot_dist(rng)];
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+
+    // One point lookup for every other page the scans move on to.
+    BufferPoolStats start = bpm->GetStats();
+    size_t lookups = 0;
+    size_t lookup_hits = 0;
+    for (size_t scan = 0; scan < num_scans; scan++) {
+      page_id_t last_page_id = INVALID_PAGE_ID;
+      size_t pages_scanned = 0;
+      for (auto it = table.Begin(&txn); it != table.End(); ++it) {
+        if (it->GetRid().GetPageId() == last_page_id) {
+          continue;
+        }
+        last_page_id = it->GetRid().GetPageId();
+        if (pages_scanned++ % 2 == 0) {
+          page_id_t page_id = hot_page_ids[hot_dist(rng)];
+          uint64_t hits = bpm->GetStats().num_hits_;
+          ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+          lookup_hits += bpm->GetStats().num_hits_ - hits;
+          lookups++;
+          bpm->UnpinPage(page_id, false);
+        }
+      }
+      EXPECT_EQ(table_pages, pages_scanned);
+    }
+    BufferPoolStats stats = bpm->GetStats();
+    double all_hits = static_cast<double>(stats.num_hits_ - start.num_hits_) /
+                      (stats.num_hits_ - start.num_hits_ + stats.num_misses_ - start.num_misses_);
+    lookup_hit_ratios[name] = static_cast<double>(lookup_hits) / lookups;
+    std::printf("%-8s %19.1f%% %11.1f%%\n", name.c_str(), lookup_hit_ratios[name] * 100, all_hits * 100);
+
+    delete bpm;
+  }
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+
+  // Re-pinning the page a scan is on must not make it look hot.
+  EXPECT_GT(lookup_hit_ratios["LRU-2"], 0.9);
+  EXPECT_GT(lookup_hit_ratios["LRU-2"], lookup_hit_ratios["LRU"]);
+  EXPECT_GT(lookup_hit_ratios["LRU-2"], lookup_hit_ratios["Clock"]);
+  EXPECT_GT(lookup_hit_ratios["ARC"], 0.9);
+  EXPECT_GT(lookup_hit_ratios["ARC"], lookup_hit_ratios["LRU"]);
+  EXPECT_GT(lookup_hit_ratios["ARC"], lookup_hit_ratios["Clock"]);
+}
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bustub_instance_test.cpp
+//
+// Identification: test/common/bustub_instance_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "common/bustub_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BustubInstanceTest, DefaultConfigTest) {
+  auto *instance = new BustubInstance("test.db");
+  EXPECT_NE(nullptr, dynamic_cast<BufferPoolManagerInstance *>(instance->buffer_pool_manager_));
+  EXPECT_EQ(BUFFER_POOL_SIZE, instance->buffer_pool_manager_->GetPoolSize());
+  EXPECT_EQ(LOG_BUFFER_SIZE, instance->log_manager_->GetLogBufferSize());
+  delete instance;
+  remove("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(BustubInstanceTest, ShardedPoolTest) {
+  BustubInstanceConfig config;
+  config.buffer_pool_size_ = 100;
+  config.num_buffer_pool_instances_ = 3;
+  config.replacer_type_ = ReplacerType::ARC;
+  auto *instance = new BustubInstance("test.db", config);
+
+  // Scenario: the pool is split over three ARC instances, rounding up, and the log buffer follows the pool size.
+  auto *bpm = dynamic_cast<ParallelBufferPoolManager *>(instance->buffer_pool_manager_);
+  ASSERT_NE(nullptr, bpm);
+  EXPECT_EQ(3, bpm->GetNumInstances());
+  EXPECT_EQ(102, bpm->GetPoolSize());
+  EXPECT_NE(nullptr, dynamic_cast<ARCReplacer *>(bpm->GetInstance(0)->GetReplacer()));
+  EXPECT_EQ(LogManager::LogBufferSizeFor(100), instance->log_manager_->GetLogBufferSize());
+
+  // Scenario: every frame of every instance can be used, and pages round-trip through the shards.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  for (auto id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(id, true));
+  }
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  for (auto id : page_ids) {
+    Page *page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    char expected[PAGE_SIZE];
+    snprintf(expected, PAGE_SIZE, "page %d", id);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+
+  delete instance;
+  remove("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(BustubInstanceTest, LogBufferSizeTest) {
+  // Scenario: the derived log buffer size matches the compile-time one for the default pool, and is capped.
+  EXPECT_EQ(LOG_BUFFER_SIZE, LogManager::LogBufferSizeFor(BUFFER_POOL_SIZE));
+  EXPECT_EQ(MAX_LOG_BUFFER_SIZE, LogManager::LogBufferSizeFor(1 << 20));
+
+  BustubInstanceConfig config;
+  config.log_buffer_size_ = 4 * PAGE_SIZE;
+  auto *instance = new BustubInstance("test.db", config);
+  EXPECT_EQ(4 * PAGE_SIZE, instance->log_manager_->GetLogBufferSize());
+  delete instance;
+  remove("test.db");
+}
+
+}  // namespace bustub
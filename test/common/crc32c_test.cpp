@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_test.cpp
+//
+// Identification: test/common/crc32c_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/util/crc32c.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(Crc32cTest, KnownValuesTest) {
+  const char *check = "123456789";
+  EXPECT_EQ(0xe3069283, Crc32c::Compute(check, strlen(check)));
+  EXPECT_EQ(0xe3069283, Crc32c::ComputeSoftware(check, strlen(check)));
+  EXPECT_EQ(0U, Crc32c::Compute(check, 0));
+
+  // 32 zero bytes, from RFC 3720.
+  std::vector<char> zeros(32, 0);
+  EXPECT_EQ(0x8a9136aa, Crc32c::Compute(zeros.data(), zeros.size()));
+}
+
+// NOLINTNEXTLINE
+TEST(Crc32cTest, MatchesSoftwareTest) {
+  std::mt19937 rng(15445);
+  std::vector<char> data(3 * 4096 + 64);
+  for (auto &byte : data) {
+    byte = static_cast<char>(rng());
+  }
+  // Scenario: lengths around the block sizes of the interleaved hardware version, at unaligned starts.
+  for (size_t length : {0, 1, 7, 8, 255, 768, 769, 1000, 3071, 3072, 3073, 4096, 3 * 4096}) {
+    for (size_t start : {0, 1, 3, 8}) {
+      EXPECT_EQ(Crc32c::ComputeSoftware(data.data() + start, length), Crc32c::Compute(data.data() + start, length))
+          << "length " << length << ", start " << start;
+    }
+  }
+
+  // Scenario: a buffer checksummed in pieces gives the checksum of the whole.
+  uint32_t crc = Crc32c::Compute(data.data(), 1000);
+  crc = Crc32c::Compute(data.data() + 1000, 4096 - 1000, crc);
+  EXPECT_EQ(Crc32c::Compute(data.data(), 4096), crc);
+}
+
+}  // namespace bustub
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// latency_histogram_test.cpp
+//
+// Identification: test/common/latency_histogram_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/util/latency_histogram.h"
+#include "common/util/sharded_counters.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ShardedCountersTest, ConcurrentAddTest) {
+  const size_t num_threads = 24;
+  const size_t adds_per_thread = 10000;
+  ShardedCounters<3> counters;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&] {
+      for (size_t i = 0; i < adds_per_thread; i++) {
+        counters.Add(0);
+        counters.Add(2, 5);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * adds_per_thread, counters.Get(0));
+  EXPECT_EQ(0U, counters.Get(1));
+  EXPECT_EQ(5 * num_threads * adds_per_thread, counters.Get(2));
+}
+
+// NOLINTNEXTLINE
+TEST(LatencyHistogramTest, BucketsTest) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0U, histogram.GetSnapshot().PercentileNanos(0.5));
+
+  histogram.Record(std::chrono::nanoseconds(0));
+  histogram.Record(std::chrono::nanoseconds(1));
+  histogram.Record(std::chrono::nanoseconds(2));
+  histogram.Record(std::chrono::nanoseconds(1000));
+  histogram.Record(std::chrono::nanoseconds(1023));
+  histogram.Record(std::chrono::nanoseconds(1024));
+  histogram.Record(std::chrono::hours(1));
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(7U, snapshot.count_);
+  EXPECT_EQ(2U, snapshot.counts_[0]);
+  EXPECT_EQ(1U, snapshot.counts_[1]);
+  EXPECT_EQ(2U, snapshot.counts_[9]);
+  EXPECT_EQ(1U, snapshot.counts_[10]);
+  EXPECT_EQ(1U, snapshot.counts_[LatencyHistogram::NUM_BUCKETS - 1]);
+  EXPECT_EQ(1U + 2 + 1000 + 1023 + 1024 + 3600000000000ULL, snapshot.total_ns_);
+
+  EXPECT_EQ(2U, snapshot.PercentileNanos(0));
+  EXPECT_EQ(2U, snapshot.PercentileNanos(0.25));
+  EXPECT_EQ(4U, snapshot.PercentileNanos(0.4));
+  EXPECT_EQ(1024U, snapshot.PercentileNanos(0.5));
+  EXPECT_EQ(2048U, snapshot.PercentileNanos(0.8));
+  EXPECT_EQ(UINT64_MAX, snapshot.PercentileNanos(1));
+
+  LatencyHistogram other;
+  other.Record(std::chrono::microseconds(1));
+  snapshot += other.GetSnapshot();
+  EXPECT_EQ(8U, snapshot.count_);
+  EXPECT_EQ(3U, snapshot.counts_[9]);
+  EXPECT_DOUBLE_EQ(static_cast<double>(snapshot.total_ns_) / 8, snapshot.MeanNanos());
+}
+
+}  // namespace bustub
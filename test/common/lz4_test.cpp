@@ -0,0 +1,156 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_test.cpp
+//
+// Identification: test/common/lz4_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "lz4/lz4.h"
+
+namespace bustub {
+
+/** Compresses data and checks that it decompresses to the same bytes. Returns the compressed size. */
+static int RoundTrip(const std::vector<char> &data) {
+  const auto size = static_cast<int>(data.size());
+  std::vector<char> compressed(LZ4_compressBound(size));
+  int length = LZ4_compress_default(data.data(), compressed.data(), size, static_cast<int>(compressed.size()));
+  EXPECT_GT(length, 0) << "size " << size;
+  std::vector<char> decompressed(size + 1);
+  EXPECT_EQ(size, LZ4_decompress_safe(compressed.data(), decompressed.data(), length, size)) << "size " << size;
+  decompressed.pop_back();
+  EXPECT_EQ(data, decompressed) << "size " << size;
+  return length;
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, VersionTest) {
+  // Scenario: the library linked is the release pinned in third_party/versions.txt, whose header is vendored.
+  EXPECT_EQ(LZ4_VERSION_NUMBER, LZ4_versionNumber());
+  EXPECT_EQ(10904, LZ4_VERSION_NUMBER);
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, RoundTripTest) {
+  std::mt19937 rng(15445);
+  // Scenario: empty and tiny inputs, which are all literals.
+  for (int size : {0, 1, 4, 12, 13}) {
+    RoundTrip(std::vector<char>(size, 'x'));
+  }
+
+  // Scenario: a run of zeros compresses to a sliver of its size, with matches overlapping their own output.
+  EXPECT_LT(RoundTrip(std::vector<char>(4096, 0)), 32);
+
+  // Scenario: text with repeated words, at sizes around a page and past the largest match offset.
+  for (int size : {100, 4096, 65535, 65536, 200000}) {
+    std::vector<char> data(size);
+    for (auto &c : data) {
+      c = "aaabbbcccd  tuple page "[rng() % 23];
+    }
+    RoundTrip(data);
+  }
+
+  // Scenario: a block repeated further back than a match can reach is still reproduced exactly.
+  std::vector<char> block(70000);
+  for (auto &c : block) {
+    c = static_cast<char>(rng());
+  }
+  std::vector<char> data(block);
+  data.insert(data.end(), block.begin(), block.end());
+  RoundTrip(data);
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, IncompressibleTest) {
+  std::mt19937 rng(15445);
+  std::vector<char> noise(4096);
+  for (auto &c : noise) {
+    c = static_cast<char>(rng());
+  }
+
+  // Scenario: random bytes round-trip and stay within the bound.
+  const auto size = static_cast<int>(noise.size());
+  int length = RoundTrip(noise);
+  EXPECT_GE(length, size);
+  EXPECT_LE(length, LZ4_compressBound(size));
+
+  // Scenario: a destination smaller than the compressed block is never overrun; compression fails instead.
+  std::vector<char> compressed(size + 16, 0x5a);
+  EXPECT_EQ(0, LZ4_compress_default(noise.data(), compressed.data(), size, size - 1));
+  for (int i = size - 1; i < size + 16; i++) {
+    EXPECT_EQ(0x5a, compressed[i]);
+  }
+
+  // Scenario: inputs too large for the format are refused.
+  EXPECT_EQ(0, LZ4_compressBound(-1));
+  EXPECT_EQ(0, LZ4_compressBound(LZ4_MAX_INPUT_SIZE + 1));
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, ReferenceBlockTest) {
+  // Scenario: a block compressed by the reference library (lz4 1.x, LZ4_compress_default) decompresses. It has a
+  // literal run and a match length that continue in extra bytes, and matches that overlap their own output.
+  const unsigned char block[] = {0x8f, 0x42, 0x75, 0x73, 0x54, 0x75, 0x62, 0x20, 0x61, 0x01, 0x00, 0xff, 0x19, 0x5c,
+                                 0x20, 0x70, 0x61, 0x67, 0x65, 0x05, 0x00, 0xab, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35,
+                                 0x36, 0x37, 0x38, 0x39, 0x0a, 0x00, 0x50, 0x35, 0x36, 0x37, 0x38, 0x39};
+  std::string expected = "BusTub " + std::string(300, 'a') + " page page page page 012345678901234567890123456789";
+  char buf[512];
+  EXPECT_EQ(static_cast<int>(expected.size()), LZ4_decompress_safe(reinterpret_cast<const char *>(block), buf,
+                                                                       sizeof(block), sizeof(buf)));
+  EXPECT_EQ(expected, std::string(buf, expected.size()));
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, MalformedInputTest) {
+  std::vector<char> data(4096);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = "tuple page "[i % 11] + static_cast<char>(i / 512);
+  }
+  const auto size = static_cast<int>(data.size());
+  std::vector<char> compressed(LZ4_compressBound(size));
+  int length = LZ4_compress_default(data.data(), compressed.data(), size, static_cast<int>(compressed.size()));
+  ASSERT_GT(length, 0);
+  std::vector<char> buf(size);
+
+  // Scenario: no truncation of a block decompresses to the whole input. One that ends right after a run of literals
+  // is a valid, shorter block; any other is rejected. The copies are exactly as long as the truncated block, so any
+  // read past its end is caught by the address sanitizer.
+  for (int truncated = 0; truncated < length; truncated++) {
+    std::vector<char> prefix(compressed.begin(), compressed.begin() + truncated);
+    EXPECT_GT(size, LZ4_decompress_safe(prefix.data(), buf.data(), truncated, size)) << "length " << truncated;
+  }
+  EXPECT_GT(0, LZ4_decompress_safe(compressed.data(), buf.data(), length - 1, size));
+
+  // Scenario: a destination too small for the decompressed block is rejected rather than overrun.
+  EXPECT_GT(0, LZ4_decompress_safe(compressed.data(), buf.data(), length, size - 1));
+
+  // Scenario: a match offset reaching before the start of the output is rejected. One of zero, which the format
+  // forbids, is not rejected by every release of the library, but must still stay within the buffers.
+  const char zero_offset[] = {0x14, 'a', 0x00, 0x00, 0x50, 'a', 'a', 'a', 'a', 'a'};
+  EXPECT_GE(size, LZ4_decompress_safe(zero_offset, buf.data(), sizeof(zero_offset), size));
+  const char far_offset[] = {0x14, 'a', 0x02, 0x00, 0x50, 'a', 'a', 'a', 'a', 'a'};
+  EXPECT_GT(0, LZ4_decompress_safe(far_offset, buf.data(), sizeof(far_offset), size));
+
+  // Scenario: damaged blocks never make decompression read or write out of bounds, whatever they decode to.
+  std::mt19937 rng(15445);
+  for (int i = 0; i < 2000; i++) {
+    std::vector<char> damaged(compressed.begin(), compressed.begin() + length);
+    for (int j = 0; j < 4; j++) {
+      damaged[rng() % length] = static_cast<char>(rng());
+    }
+    int result = LZ4_decompress_safe(damaged.data(), buf.data(), length, size);
+    EXPECT_LE(result, size);
+  }
+}
+
+}  // namespace bustub
@@ -10,6 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <mutex>         // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <string>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -18,6 +25,7 @@
 
 namespace bustub {
 
+template <typename Latch = ReaderWriterLatch>
 class Counter {
  public:
   Counter() = default;
@@ -36,13 +44,13 @@ class Counter {
 
  private:
   int count_{0};
-  ReaderWriterLatch mutex_{};
+  Latch mutex_{};
 };
 
-// NOLINTNEXTLINE
-TEST(RWLatchTest, BasicTest) {
+template <typename Latch>
+void RunBasicTest() {
   int num_threads = 100;
-  Counter counter{};
+  Counter<Latch> counter{};
   counter.Add(5);
   std::vector<std::thread> threads;
   for (int tid = 0; tid < num_threads; tid++) {
@@ -57,4 +65,127 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, BasicTest) { RunBasicTest<ReaderWriterLatch>(); }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, ShardedBasicTest) { RunBasicTest<ShardedReaderWriterLatch>(); }
+
+/** A writer that waits for a reader to leave keeps out readers that come after it. */
+template <typename Latch>
+void RunWriterPreferenceTest() {
+  Latch latch;
+  std::mutex order_latch;
+  std::string order;
+  latch.RLock();
+  std::thread writer([&] {
+    latch.WLock();
+    {
+      std::scoped_lock lock(order_latch);
+      order += 'W';
+    }
+    latch.WUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::thread reader([&] {
+    latch.RLock();
+    {
+      std::scoped_lock lock(order_latch);
+      order += 'R';
+    }
+    latch.RUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ("", order);
+  latch.RUnlock();
+  writer.join();
+  reader.join();
+  EXPECT_EQ("WR", order);
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, WriterPreferenceTest) { RunWriterPreferenceTest<ReaderWriterLatch>(); }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, ShardedWriterPreferenceTest) { RunWriterPreferenceTest<ShardedReaderWriterLatch>(); }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, CrossThreadUnlockTest) {
+  // Scenario: read latches taken on one thread and released on another, as a transaction may do.
+  ShardedReaderWriterLatch latch;
+  latch.RLock();
+  latch.RLock();
+  std::thread([&] { latch.RUnlock(); }).join();
+  std::thread writer([&] { latch.WLock(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  latch.RUnlock();
+  writer.join();
+  latch.WUnlock();
+}
+
+/** std::shared_mutex behind the ReaderWriterLatch interface, as a baseline. */
+class SharedMutexLatch {
+ public:
+  void WLock() { mutex_.lock(); }
+  void WUnlock() { mutex_.unlock(); }
+  void RLock() { mutex_.lock_shared(); }
+  void RUnlock() { mutex_.unlock_shared(); }
+
+ private:
+  std::shared_mutex mutex_;
+};
+
+/**
+ * Has num_threads threads take a latch ops_per_thread times each, for writing one time in write_every, around a short
+ * critical section.
+ * @return latch acquisitions per second over all threads
+ */
+template <typename Latch>
+double MeasureThroughput(size_t num_threads, size_t ops_per_thread, size_t write_every) {
+  Latch latch;
+  uint64_t shared_value = 0;
+  // Keeps the reads from being optimized away.
+  std::atomic<uint64_t> checksum{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      uint64_t sum = 0;
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        if (write_every != 0 && (i + t) % write_every == 0) {
+          latch.WLock();
+          shared_value++;
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          sum += shared_value;
+          latch.RUnlock();
+        }
+      }
+      checksum += sum;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(num_threads * ops_per_thread) / elapsed.count();
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, ContentionBenchmark) {
+  const size_t ops_per_thread = 20000;
+  printf("%8s %12s %16s %16s %16s\n", "threads", "writes", "shared_mutex/s", "rwlatch/s", "sharded/s");
+  for (size_t num_threads : {1, 4, 16}) {
+    for (size_t write_every : {0, 100, 2}) {
+      double baseline = MeasureThroughput<SharedMutexLatch>(num_threads, ops_per_thread, write_every);
+      double latch = MeasureThroughput<ReaderWriterLatch>(num_threads, ops_per_thread, write_every);
+      double sharded = MeasureThroughput<ShardedReaderWriterLatch>(num_threads, ops_per_thread, write_every);
+      std::string writes = write_every == 0 ? "none" : "1 in " + std::to_string(write_every);
+      printf("%8zu %12s %16.0f %16.0f %16.0f\n", num_threads, writes.c_str(), baseline, latch, sharded);
+    }
+  }
+}
+
 }  // namespace bustub
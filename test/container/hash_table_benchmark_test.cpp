@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_benchmark_test.cpp
+//
+// Identification: test/container/hash_table_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/hash/extendible_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/index/int_comparator.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+// Concurrent inserts, then lookups, of the same keys by a growing number of threads.
+TEST(HashTableBenchmark, ConcurrentScaling) {
+  const int num_keys = 1 << 15;
+  printf("%8s %16s %16s %12s\n", "threads", "inserts/s", "lookups/s", "global depth");
+  for (int num_threads : {1, 2, 4, 8, 16, 32}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(256, disk_manager);
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+    // Each thread inserts, then looks up, an interleaved share of the keys.
+    auto measure = [&](auto &&op) {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+          for (int i = t; i < num_keys; i += num_threads) {
+            op(i);
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return num_keys / elapsed.count();
+    };
+    double inserts = measure([&](int key) { ASSERT_TRUE(ht.Insert(nullptr, key, key)); });
+    double lookups = measure([&](int key) {
+      std::vector<int> res;
+      ASSERT_TRUE(ht.GetValue(nullptr, key, &res));
+    });
+    printf("%8d %16.0f %16.0f %12u\n", num_threads, inserts, lookups, ht.GetGlobalDepth());
+    ht.VerifyIntegrity();
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete disk_manager;
+    delete bpm;
+  }
+}
+
+}  // namespace bustub
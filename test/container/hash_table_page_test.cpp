@@ -17,13 +17,14 @@
 #include "common/logger.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/page/extendible_hash_table_header_page.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
+TEST(HashTablePageTest, DirectoryPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -57,7 +58,47 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
+TEST(HashTablePageTest, HeaderPageTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+
+  page_id_t header_page_id = INVALID_PAGE_ID;
+  auto header_page =
+      reinterpret_cast<ExtendibleHashTableHeaderPage *>(bpm->NewPage(&header_page_id, nullptr)->GetData());
+  EXPECT_EQ(0, header_page->GetGlobalDepth());
+  EXPECT_EQ(1, header_page->NumDirectoryPages());
+
+  // The directory stays on one page until that page is full, then doubles the number of pages.
+  while (header_page->GetGlobalDepth() < ExtendibleHashTableHeaderPage::MAX_GLOBAL_DEPTH) {
+    header_page->IncrGlobalDepth();
+    EXPECT_EQ(header_page->GetGlobalDepthMask() + 1, header_page->Size());
+    EXPECT_EQ((header_page->Size() + DIRECTORY_ARRAY_SIZE - 1) / DIRECTORY_ARRAY_SIZE,
+              header_page->NumDirectoryPages());
+  }
+  // Past HEADER_ARRAY_SIZE directory pages, the header points to index pages of HEADER_ARRAY_SIZE page ids each.
+  EXPECT_LT(HEADER_ARRAY_SIZE, header_page->NumDirectoryPages());
+  EXPECT_GE(HEADER_ARRAY_SIZE * HEADER_ARRAY_SIZE, header_page->NumDirectoryPages());
+  EXPECT_LE(20, ExtendibleHashTableHeaderPage::MAX_GLOBAL_DEPTH);
+  for (uint32_t i = 0; i < HEADER_ARRAY_SIZE; i++) {
+    header_page->SetDirectoryPageId(i, i + 10);
+  }
+  for (uint32_t i = 0; i < HEADER_ARRAY_SIZE; i++) {
+    EXPECT_EQ(i + 10, header_page->GetDirectoryPageId(i));
+  }
+
+  uint32_t bucket_idx = 3 * DIRECTORY_ARRAY_SIZE + 5;
+  EXPECT_EQ(3, ExtendibleHashTableHeaderPage::DirectoryIndex(bucket_idx));
+  EXPECT_EQ(5, ExtendibleHashTableHeaderPage::DirectorySlot(bucket_idx));
+
+  bpm->UnpinPage(header_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
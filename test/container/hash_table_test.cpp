@@ -14,17 +14,17 @@
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "common/exception.h"
 #include "common/logger.h"
 #include "container/hash/extendible_hash_table.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-
-// NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
   ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
@@ -111,6 +111,226 @@ TEST(HashTableTest, DISABLED_SampleTest) {
 
   ht.VerifyIntegrity();
 
+  // Scenario: a duplicate insert and a remove of a missing pair leave every page clean, so nothing is written back.
+  EXPECT_TRUE(ht.Insert(nullptr, 1, 1));
+  bpm->FlushAllPages();
+  int num_writes = disk_manager->GetNumWrites();
+  EXPECT_FALSE(ht.Insert(nullptr, 1, 1));
+  EXPECT_FALSE(ht.Remove(nullptr, 1, 2));
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_writes, disk_manager->GetNumWrites());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, OutOfFramesTest) {
+  const size_t pool_size = 5;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+
+  // Scenario: with all but one frame pinned elsewhere, every operation runs out of frames part way through.
+  std::vector<page_id_t> pinned(pool_size - 1);
+  for (page_id_t &page_id : pinned) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  std::vector<int> res;
+  EXPECT_THROW(ht.GetValue(nullptr, 0, &res), Exception);
+  EXPECT_THROW(ht.Insert(nullptr, 5, 5), Exception);
+  EXPECT_THROW(ht.Remove(nullptr, 0, 0), Exception);
+  for (page_id_t page_id : pinned) {
+    bpm->UnpinPage(page_id, false);
+    bpm->DeletePage(page_id);
+  }
+
+  // Scenario: the failed operations released the table latch, or growing the directory and merging would block, and
+  // their pins, or the table would not fit in the pool.
+  const int num_keys = 2000;
+  for (int i = 5; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_LT(0, ht.GetGlobalDepth());
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  for (page_id_t &page_id : pinned) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  page_id_t last_page_id;
+  EXPECT_NE(nullptr, bpm->NewPage(&last_page_id));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentInsertRemoveTest) {
+  const int num_threads = 8;
+  const int keys_per_thread = 2000;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  auto run_threads = [&](auto &&fn) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back(fn, t);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  };
+
+  // Enough keys to split the first bucket many times over, with lookups racing the splits.
+  run_threads([&](int t) {
+    for (int i = t * keys_per_thread; i < (t + 1) * keys_per_thread; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+      std::vector<int> res;
+      EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+      EXPECT_EQ(std::vector<int>{i}, res);
+    }
+  });
+  EXPECT_GT(ht.GetGlobalDepth(), 0U);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+
+  run_threads([&](int t) {
+    for (int i = t * keys_per_thread; i < (t + 1) * keys_per_thread; i++) {
+      EXPECT_FALSE(ht.Insert(nullptr, i, i));
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+      EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    }
+  });
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_threads * keys_per_thread; i++) {
+    std::vector<int> res;
+    EXPECT_FALSE(ht.GetValue(nullptr, i, &res));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MultiLevelDirectoryTest) {
+  // Wide keys make for small buckets, so that the directory outgrows a single page after a few ten thousand keys.
+  const size_t bucket_size = 4 * PAGE_SIZE / (4 * sizeof(std::pair<GenericKey<64>, RID>) + 1);
+  const int64_t num_keys = 2 * DIRECTORY_ARRAY_SIZE * bucket_size;
+  if (num_keys > (1 << 17)) {
+    GTEST_SKIP() << "the directory only outgrows a page after " << num_keys << " keys at this page size";
+  }
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(2048, disk_manager);
+  ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>> ht("blah", bpm, comparator,
+                                                                     HashFunction<GenericKey<64>>());
+
+  GenericKey<64> index_key;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(ht.Insert(nullptr, index_key, RID(key)));
+  }
+  uint32_t global_depth = ht.GetGlobalDepth();
+  EXPECT_GT(global_depth, HashTableDirectoryPage::MAX_GLOBAL_DEPTH);
+  ht.VerifyIntegrity();
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    std::vector<RID> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, index_key, &res));
+    EXPECT_EQ(std::vector<RID>{RID(key)}, res);
+  }
+
+  // Emptying the table merges buckets and shrinks the directory again.
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(ht.Remove(nullptr, index_key, RID(key)));
+  }
+  EXPECT_LT(ht.GetGlobalDepth(), global_depth);
+  ht.VerifyIntegrity();
+  for (int64_t key = 0; key < num_keys; key += 97) {
+    index_key.SetFromInteger(key);
+    std::vector<RID> res;
+    EXPECT_FALSE(ht.GetValue(nullptr, index_key, &res));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, DirectoryIndexPageTest) {
+  // Keys whose hashes agree in the bits the header can address all land in one bucket, which splits until the
+  // directory has more pages than the header can point to.
+  const uint32_t header_depth = __builtin_ctzll(DIRECTORY_ARRAY_SIZE) + __builtin_ctzll(HEADER_ARRAY_SIZE);
+  const size_t bucket_size = 4 * PAGE_SIZE / (4 * sizeof(std::pair<GenericKey<64>, RID>) + 1);
+  if (header_depth > 18) {
+    GTEST_SKIP() << "the directory only outgrows the header at global depth " << header_depth << " at this page size";
+  }
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  HashFunction<GenericKey<64>> hash_fn;
+  GenericKey<64> index_key;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; keys.size() <= bucket_size; key++) {
+    index_key.SetFromInteger(key);
+    if ((static_cast<uint32_t>(hash_fn.GetHash(index_key)) & ((1U << header_depth) - 1)) == 0) {
+      keys.push_back(key);
+    }
+  }
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(2048, disk_manager);
+  ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>> ht("blah", bpm, comparator, hash_fn);
+
+  // Scenario: the directory grows past the header, which then points to index pages, and every key is found.
+  for (int round = 0; round < 2; round++) {
+    for (int64_t key : keys) {
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(ht.Insert(nullptr, index_key, RID(key)));
+    }
+    uint32_t global_depth = ht.GetGlobalDepth();
+    EXPECT_GT(global_depth, header_depth);
+    ht.VerifyIntegrity();
+    for (int64_t key : keys) {
+      index_key.SetFromInteger(key);
+      std::vector<RID> res;
+      ASSERT_TRUE(ht.GetValue(nullptr, index_key, &res));
+      EXPECT_EQ(std::vector<RID>{RID(key)}, res);
+    }
+
+    // Scenario: emptying the table shrinks the directory back into the header; the next round grows it again.
+    for (int64_t key : keys) {
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(ht.Remove(nullptr, index_key, RID(key)));
+    }
+    EXPECT_LE(ht.GetGlobalDepth(), header_depth);
+    ht.VerifyIntegrity();
+    for (int64_t key : keys) {
+      index_key.SetFromInteger(key);
+      std::vector<RID> res;
+      EXPECT_FALSE(ht.GetValue(nullptr, index_key, &res));
+    }
+  }
+
   disk_manager->ShutDown();
   remove("test.db");
   delete disk_manager;
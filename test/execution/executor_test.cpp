@@ -87,7 +87,7 @@ using ComparatorType = GenericComparator<8>;
 using HashFunctionType = HashFunction<KeyType>;
 
 // SELECT col_a, col_b FROM test_1 WHERE col_a < 500
-TEST_F(ExecutorTest, DISABLED_SimpleSeqScanTest) {
+TEST_F(ExecutorTest, SimpleSeqScanTest) {
   // Construct query plan
   TableInfo *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
   const Schema &schema = table_info->schema_;
@@ -110,6 +110,60 @@ TEST_F(ExecutorTest, DISABLED_SimpleSeqScanTest) {
   }
 }
 
+// SELECT colA FROM big_table, with a table several times larger than the buffer pool
+TEST_F(ExecutorTest, SeqScanBufferRingTest) {
+  // Construct a table of a few hundred pages, whatever the page size
+  Schema schema{{Column{"colA", TypeId::INTEGER}, Column{"colB", TypeId::VARCHAR, PAGE_SIZE / 8}}};
+  TableInfo *table_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "big_table", schema);
+  const std::string padding(PAGE_SIZE / 8 - 12, 'x');
+  const size_t num_tuples = 2000;
+  for (size_t i = 0; i < num_tuples; i++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(static_cast<int32_t>(i)), ValueFactory::GetVarcharValue(padding)},
+                &schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, GetTxn()));
+  }
+
+  // Pages used right before the scan
+  auto *bpm = dynamic_cast<BufferPoolManagerInstance *>(GetBPM());
+  std::vector<page_id_t> hot_pages;
+  for (size_t i = 0; i < 8; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, true);
+    hot_pages.push_back(page_id);
+  }
+  auto num_resident = [&] {
+    size_t count = 0;
+    for (page_id_t page_id : hot_pages) {
+      for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+        count += bpm->GetPages()[i].GetPageId() == page_id ? 1 : 0;
+      }
+    }
+    return count;
+  };
+
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}});
+  SeqScanPlanNode plan{out_schema, nullptr, table_info->oid_};
+
+  // A full scan through the ring leaves the hot pages alone
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(num_tuples, result_set.size());
+  for (size_t i = 0; i < num_tuples; i++) {
+    ASSERT_EQ(static_cast<int32_t>(i), result_set[i].GetValue(out_schema, 0).GetAs<int32_t>());
+  }
+  EXPECT_EQ(hot_pages.size(), num_resident());
+
+  // Without it, the same scan flushes them out of the pool
+  GetExecutorContext()->SetUseBulkReadStrategy(false);
+  result_set.clear();
+  GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(num_tuples, result_set.size());
+  EXPECT_EQ(0, num_resident());
+}
+
 // INSERT INTO empty_table2 VALUES (100, 10), (101, 11), (102, 12)
 TEST_F(ExecutorTest, DISABLED_SimpleRawInsertTest) {
   // Create Values to insert
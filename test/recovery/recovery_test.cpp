@@ -101,7 +101,8 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
   delete txn;
 
   LOG_INFO("Begin recovery");
-  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                      bustub_instance->log_manager_->GetLogBufferSize());
 
   ASSERT_FALSE(enable_logging);
 
@@ -185,7 +186,8 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
   delete txn;
 
   LOG_INFO("Recovery started..");
-  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                      bustub_instance->log_manager_->GetLogBufferSize());
 
   ASSERT_FALSE(enable_logging);
 
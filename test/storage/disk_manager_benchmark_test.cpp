@@ -0,0 +1,500 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_benchmark_test.cpp
+//
+// Identification: test/storage/disk_manager_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/table_generator.h"
+#include "common/util/crc32c.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/hash_table_page_defs.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/** Page reads the way DiskManager did them before positional I/O: one stream, one cursor, one latch. */
+class StreamPageReader {
+ public:
+  explicit StreamPageReader(const std::string &file_name) {
+    db_io_.open(file_name, std::ios::binary | std::ios::in | std::ios::out);
+  }
+
+  void ReadPage(page_id_t page_id, char *page_data) {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    db_io_.seekp(static_cast<int64_t>(page_id) * PAGE_SIZE);
+    db_io_.read(page_data, PAGE_SIZE);
+  }
+
+ private:
+  std::fstream db_io_;
+  std::mutex db_io_latch_;
+};
+
+/** @return page reads per second over all threads */
+double RunRandomReads(size_t num_threads, size_t num_pages, const std::function<void(page_id_t, char *)> &read_page) {
+  const size_t reads_per_thread = 20000;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(15445 + t);
+      char buf[PAGE_SIZE];
+      for (size_t i = 0; i < reads_per_thread; i++) {
+        auto page_id = static_cast<page_id_t>(rng() % num_pages);
+        read_page(page_id, buf);
+        EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(buf));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return num_threads * reads_per_thread / elapsed.count();
+}
+
+// NOLINTNEXTLINE
+// Concurrent random page reads of a file that sits in the page cache, so that the cost measured is the I/O path
+// itself rather than the device.
+TEST(DiskManagerBenchmark, ConcurrentRandomRead) {
+  const size_t num_pages = 4096;
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  char data[PAGE_SIZE] = {0};
+  for (size_t i = 0; i < num_pages; i++) {
+    *reinterpret_cast<page_id_t *>(data) = static_cast<page_id_t>(i);
+    disk_manager->WritePage(static_cast<page_id_t>(i), data);
+  }
+
+  StreamPageReader stream_reader("test.db");
+  std::printf("%-8s %20s %20s\n", "threads", "fstream reads/s", "pread reads/s");
+  for (size_t num_threads : {1, 4, 8}) {
+    double stream_rate = RunRandomReads(num_threads, num_pages, [&](page_id_t page_id, char *page_data) {
+      stream_reader.ReadPage(page_id, page_data);
+    });
+    double pread_rate = RunRandomReads(num_threads, num_pages, [&](page_id_t page_id, char *page_data) {
+      disk_manager->ReadPage(page_id, page_data);
+    });
+    std::printf("%-8zu %20.0f %20.0f\n", num_threads, stream_rate, pread_rate);
+  }
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+/** @return how many bytes of file_name are in the OS page cache */
+size_t PageCacheBytes(const std::string &file_name, size_t size) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  size_t os_page_size = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> resident((size + os_page_size - 1) / os_page_size);
+  size_t bytes = 0;
+  if (mapping != MAP_FAILED && mincore(mapping, size, resident.data()) == 0) {
+    bytes = std::count_if(resident.begin(), resident.end(), [](unsigned char r) { return (r & 1) != 0; }) *
+            os_page_size;
+  }
+  if (mapping != MAP_FAILED) {
+    munmap(mapping, size);
+  }
+  close(fd);
+  return bytes;
+}
+
+/** @return size of a file in bytes, -1 if it does not exist */
+int64_t GetFileSize(const std::string &file_name) {
+  struct stat stat_buf;
+  return stat(file_name.c_str(), &stat_buf) == 0 ? stat_buf.st_size : -1;
+}
+
+/** Writes file_name back and drops it from the OS page cache, so that it is read from the device again. */
+void DropFromPageCache(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/**
+ * Builds a table out of copies of TableGenerator's test_1, whatever the page size, and leaves it in the buffer pool.
+ * @param[out] first_page_id the first page of the table
+ * @return number of rows in the table
+ */
+size_t BuildTestTable(BufferPoolManager *bpm, int copies, page_id_t *first_page_id) {
+  Catalog catalog(bpm, nullptr, nullptr);
+  Transaction txn(0);
+  ExecutorContext exec_ctx(&txn, &catalog, bpm, nullptr, nullptr);
+  TableGenerator generator(&exec_ctx);
+  generator.GenerateTestTables();
+  TableHeap *source = catalog.GetTable("test_1")->table_.get();
+  // Append to the last page directly; TableHeap::InsertTuple looks for space from the first page on every insert.
+  auto *page = static_cast<TablePage *>(bpm->NewPage(first_page_id));
+  page->Init(*first_page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, &txn);
+  size_t num_rows = 0;
+  for (int i = 0; i < copies; i++) {
+    for (auto it = source->Begin(&txn); it != source->End(); ++it) {
+      RID rid;
+      if (!page->InsertTuple(*it, &rid, &txn, nullptr, nullptr)) {
+        page_id_t next_page_id;
+        auto *next_page = static_cast<TablePage *>(bpm->NewPageNear(&next_page_id, page->GetTablePageId()));
+        next_page->Init(next_page_id, PAGE_SIZE, page->GetTablePageId(), nullptr, &txn);
+        page->SetNextPageId(next_page_id);
+        bpm->UnpinPage(page->GetTablePageId(), true);
+        page = next_page;
+        EXPECT_TRUE(page->InsertTuple(*it, &rid, &txn, nullptr, nullptr));
+      }
+      num_rows++;
+    }
+  }
+  bpm->UnpinPage(page->GetTablePageId(), true);
+  return num_rows;
+}
+
+/** @return resident set size of this process in bytes */
+size_t ResidentSetBytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t total_pages = 0;
+  size_t resident_pages = 0;
+  statm >> total_pages >> resident_pages;
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+// NOLINTNEXTLINE
+// Reads every page of a file that is not in the page cache into a buffer pool large enough to hold it, once with
+// buffered I/O and once with O_DIRECT, and reports how much memory the pages end up taking outside the buffer pool.
+TEST(DiskManagerBenchmark, DirectIOColdRead) {
+  const size_t num_pages = 4096;
+  const size_t file_size = num_pages * PAGE_SIZE;
+  std::printf("%-10s %14s %18s %10s\n", "mode", "cold reads/s", "page cache (MB)", "RSS (MB)");
+  for (bool direct_io : {false, true}) {
+    remove("test.db");
+    remove("test.log");
+    auto *disk_manager = new DiskManager("test.db", direct_io);
+    if (direct_io && !disk_manager->IsDirectIO()) {
+      std::printf("%-10s %14s\n", "O_DIRECT", "unsupported");
+      delete disk_manager;
+      continue;
+    }
+    alignas(PAGE_SIZE) static char data[PAGE_SIZE];
+    for (size_t i = 0; i < num_pages; i++) {
+      *reinterpret_cast<page_id_t *>(data) = static_cast<page_id_t>(i);
+      disk_manager->WritePage(static_cast<page_id_t>(i), data);
+    }
+    // Push the file out of the page cache so the reads below are cold.
+    int fd = open("test.db", O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    auto *bpm = new BufferPoolManagerInstance(num_pages, disk_manager);
+    std::vector<page_id_t> order(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+      order[i] = static_cast<page_id_t>(i);
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(15445));
+    auto start = std::chrono::steady_clock::now();
+    for (auto page_id : order) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+      bpm->UnpinPage(page_id, false);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-10s %14.0f %18.1f %10.1f\n", direct_io ? "O_DIRECT" : "buffered", num_pages / elapsed.count(),
+                PageCacheBytes("test.db", file_size) / 1048576.0, ResidentSetBytes() / 1048576.0);
+    if (direct_io) {
+      // The buffer pool is the only copy: the reads left nothing behind in the page cache.
+      EXPECT_LT(PageCacheBytes("test.db", file_size), file_size / 4);
+    }
+
+    delete bpm;
+    disk_manager->ShutDown();
+    delete disk_manager;
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+// Writes a pool full of dirty pages the way FlushAllPages used to, one WritePage per page, and with the batched
+// FlushAllPages, and makes both durable with a sync at the end.
+TEST(DiskManagerBenchmark, FlushAllPages) {
+  const size_t pool_size = 4096;
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  for (size_t i = 0; i < pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    memset(page->GetData(), static_cast<int>(i), PAGE_SIZE);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  std::printf("%-18s %14s\n", "flush", "pages/s");
+  for (int round = 0; round < 2; round++) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pool_size; i++) {
+      disk_manager->WritePage(bpm->GetPages()[i].GetPageId(), bpm->GetPages()[i].GetData());
+    }
+    int fd = open("test.db", O_RDWR);
+    fdatasync(fd);
+    close(fd);
+    std::chrono::duration<double> page_at_a_time = std::chrono::steady_clock::now() - start;
+
+    // FlushAllPages only writes dirty pages.
+    for (size_t i = 0; i < pool_size; i++) {
+      page_id_t page_id = bpm->GetPages()[i].GetPageId();
+      bpm->FetchPage(page_id);
+      bpm->UnpinPage(page_id, true);
+    }
+    start = std::chrono::steady_clock::now();
+    bpm->FlushAllPages();
+    std::chrono::duration<double> batched = std::chrono::steady_clock::now() - start;
+    std::printf("%-18s %14.0f\n%-18s %14.0f\n", "page at a time", pool_size / page_at_a_time.count(), "WritePages",
+                pool_size / batched.count());
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+// Random page reads with and without checksums: from the page cache, where verifying costs the most relative to the
+// read itself, and with O_DIRECT, where every read goes to the device. Also reports the raw speed of the checksum.
+TEST(DiskManagerBenchmark, ChecksumReadOverhead) {
+  const size_t num_pages = 4096;
+  const int rounds = 15;
+  std::printf("%-10s %18s %18s %10s\n", "reads", "checksums off/s", "checksums on/s", "overhead");
+  for (bool use_direct_io : {false, true}) {
+    // One database without checksums and one with, read in alternating rounds so that drift in the machine's speed
+    // hits both alike, and compared by their medians, which a few disturbed rounds do not move.
+    std::vector<double> rates[2];
+    DiskManager *disk_managers[2];
+    for (bool use_checksums : {false, true}) {
+      std::string db_file = use_checksums ? "test_crc.db" : "test.db";
+      remove(db_file.c_str());
+      remove(use_checksums ? "test_crc.crc" : "test.crc");
+      disk_managers[use_checksums] = new DiskManager(db_file, use_direct_io, PAGES_PER_SEGMENT, use_checksums);
+      char data[PAGE_SIZE];
+      memset(data, 'x', PAGE_SIZE);
+      for (size_t i = 0; i < num_pages; i++) {
+        *reinterpret_cast<page_id_t *>(data) = static_cast<page_id_t>(i);
+        disk_managers[use_checksums]->WritePage(static_cast<page_id_t>(i), data);
+      }
+    }
+    // the first round of each warms up
+    for (int round = 0; round <= rounds; round++) {
+      for (bool use_checksums : {false, true}) {
+        double rate = RunRandomReads(1, num_pages, [&](page_id_t page_id, char *page_data) {
+          disk_managers[use_checksums]->ReadPage(page_id, page_data);
+        });
+        if (round > 0) {
+          rates[use_checksums].push_back(rate);
+        }
+      }
+    }
+    double medians[2];
+    for (bool use_checksums : {false, true}) {
+      std::vector<double> &samples = rates[use_checksums];
+      std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+      medians[use_checksums] = samples[samples.size() / 2];
+      disk_managers[use_checksums]->ShutDown();
+      delete disk_managers[use_checksums];
+    }
+    std::printf("%-10s %18.0f %18.0f %9.1f%%\n", use_direct_io ? "O_DIRECT" : "cached", medians[0], medians[1],
+                100 * (medians[0] / medians[1] - 1));
+  }
+
+  std::vector<char> buffer(PAGE_SIZE * 256, 'x');
+  const int crc_rounds = 64;
+  auto time_gb_per_second = [&](const std::function<uint32_t(const char *, size_t)> &crc) {
+    uint32_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < crc_rounds; i++) {
+      for (size_t offset = 0; offset < buffer.size(); offset += PAGE_SIZE) {
+        sum ^= crc(buffer.data() + offset, PAGE_SIZE);
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_NE(0, sum | 1);
+    return crc_rounds * buffer.size() / elapsed.count() / 1e9;
+  };
+  double hardware = time_gb_per_second([](const char *data, size_t length) { return Crc32c::Compute(data, length); });
+  double software =
+      time_gb_per_second([](const char *data, size_t length) { return Crc32c::ComputeSoftware(data, length); });
+  std::printf("CRC32C per page: %.2f GB/s (%s), %.2f GB/s table-driven\n", hardware,
+              Crc32c::IsHardwareAccelerated() ? "crc32 instruction" : "table-driven", software);
+
+  remove("test.db");
+  remove("test.crc");
+  remove("test.log");
+  remove("test_crc.db");
+  remove("test_crc.crc");
+  remove("test_crc.log");
+}
+
+// NOLINTNEXTLINE
+// Builds a table out of copies of a table from TableGenerator, once stored as it is and once compressed, and scans it
+// from a cold buffer pool with the file pushed out of the page cache.
+TEST(DiskManagerBenchmark, CompressedTableScan) {
+  const int copies = 200;
+  const size_t pool_size = 256;
+  int64_t uncompressed_size = 0;
+  std::printf("%-12s %12s %10s %16s %16s\n", "storage", "file (MB)", "saved", "cold scan rows/s", "scan MB/s");
+  for (bool use_compression : {false, true}) {
+    remove("test.db");
+    remove("test.log");
+    remove("test.map");
+    auto *disk_manager = new DiskManager("test.db", false, PAGES_PER_SEGMENT, false, use_compression);
+    page_id_t first_page_id;
+    size_t num_rows;
+    {
+      auto bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager);
+      num_rows = BuildTestTable(bpm.get(), copies, &first_page_id);
+      bpm->FlushAllPages();
+    }
+    int64_t file_size = GetFileSize("test.db");
+    uncompressed_size = use_compression ? uncompressed_size : file_size;
+    // Push the file out of the page cache so the scan below reads from the device.
+    DropFromPageCache("test.db");
+
+    auto bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager);
+    TableHeap table(bpm.get(), nullptr, nullptr, first_page_id);
+    Transaction txn(1);
+    size_t num_scanned = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto it = table.Begin(&txn); it != table.End(); ++it) {
+      num_scanned++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(num_rows, num_scanned);
+    // Throughput in table data, i.e. in uncompressed pages, either way.
+    std::printf("%-12s %12.1f %9.1f%% %16.0f %16.1f\n", use_compression ? "compressed" : "uncompressed",
+                file_size / 1048576.0, 100.0 * (uncompressed_size - file_size) / uncompressed_size,
+                num_scanned / elapsed.count(), uncompressed_size / 1048576.0 / elapsed.count());
+
+    bpm.reset();
+    disk_manager->ShutDown();
+    delete disk_manager;
+  }
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.map");
+  remove("test.seg");
+}
+
+// NOLINTNEXTLINE
+// What this build's page size gives: index fanout, and the speed of a cold table scan and of cold random page reads
+// over the same table. build_support/run_page_size_benchmarks.sh runs this for every page size.
+TEST(DiskManagerBenchmark, PageSize) {
+  const int copies = 300;
+  const size_t pool_size = 256;
+  const size_t num_random_reads = 2000;
+  size_t leaf_fanout;
+  size_t internal_fanout;
+  size_t bucket_capacity;
+  {
+    using KeyType = GenericKey<8>;
+    using ValueType = RID;
+    leaf_fanout = LEAF_PAGE_SIZE;
+    bucket_capacity = BUCKET_ARRAY_SIZE;
+  }
+  {
+    using KeyType = GenericKey<8>;
+    using ValueType = page_id_t;
+    internal_fanout = INTERNAL_PAGE_SIZE;
+  }
+  std::printf("page size %d: B+ tree leaf %zu, internal %zu, hash bucket %zu, directory %d entries (8 byte keys)\n",
+              PAGE_SIZE, leaf_fanout, internal_fanout, bucket_capacity, DIRECTORY_ARRAY_SIZE);
+
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  page_id_t first_page_id;
+  size_t num_rows;
+  {
+    auto bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager);
+    num_rows = BuildTestTable(bpm.get(), copies, &first_page_id);
+    bpm->FlushAllPages();
+  }
+  DropFromPageCache("test.db");
+
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager);
+  TableHeap table(bpm.get(), nullptr, nullptr, first_page_id);
+  Transaction txn(1);
+  std::vector<page_id_t> page_ids;
+  size_t num_scanned = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto it = table.Begin(&txn); it != table.End(); ++it) {
+    if (page_ids.empty() || page_ids.back() != it->GetRid().GetPageId()) {
+      page_ids.push_back(it->GetRid().GetPageId());
+    }
+    num_scanned++;
+  }
+  std::chrono::duration<double> scan_elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(num_rows, num_scanned);
+
+  DropFromPageCache("test.db");
+  std::mt19937 rng(15445);
+  std::vector<char> data(PAGE_SIZE);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_random_reads; i++) {
+    page_id_t page_id = page_ids[rng() % page_ids.size()];
+    disk_manager->ReadPage(page_id, data.data());
+    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(data.data()));
+  }
+  std::chrono::duration<double> read_elapsed = std::chrono::steady_clock::now() - start;
+
+  double table_mb = page_ids.size() * static_cast<double>(PAGE_SIZE) / 1048576.0;
+  std::printf("%-10s %8s %10s %16s %12s %16s %16s\n", "page size", "pages", "table (MB)", "cold scan rows/s",
+              "scan MB/s", "random reads/s", "random MB/s");
+  std::printf("%-10d %8zu %10.1f %16.0f %12.1f %16.0f %16.1f\n", PAGE_SIZE, page_ids.size(), table_mb,
+              num_scanned / scan_elapsed.count(), table_mb / scan_elapsed.count(),
+              num_random_reads / read_elapsed.count(),
+              num_random_reads * static_cast<double>(PAGE_SIZE) / 1048576.0 / read_elapsed.count());
+
+  bpm.reset();
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+}  // namespace bustub
@@ -10,7 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <cstring>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -18,18 +27,32 @@
 
 namespace bustub {
 
+/** @return size of a file in bytes, -1 if it does not exist */
+int64_t GetFileSize(const std::string &file_name) {
+  struct stat stat_buf;
+  return stat(file_name.c_str(), &stat_buf) == 0 ? stat_buf.st_size : -1;
+}
+
 class DiskManagerTest : public ::testing::Test {
  protected:
   // This function is called before every test.
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.crc");
+    remove("test.map");
+    remove("test.seg");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.crc");
+    remove("test.map");
+    remove("test.seg");
   };
 };
 
@@ -55,6 +78,460 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWritePageTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  auto dm = DiskManager("test.db");
+
+  // Scenario: threads writing and reading back their own pages at the same time see their own data.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&dm, t] {
+      char data[PAGE_SIZE];
+      char buf[PAGE_SIZE];
+      for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + t;
+          std::memset(data, page_id + round, sizeof(data));
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread * 4, dm.GetNumWrites());
+
+  // Scenario: a page past the end of the file reads as zeros.
+  char buf[PAGE_SIZE];
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPage(num_threads * pages_per_thread, buf);
+  char zeros[PAGE_SIZE] = {0};
+  EXPECT_EQ(0, std::memcmp(buf, zeros, sizeof(buf)));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  auto dm = DiskManager("test.db", true);
+  if (!dm.IsDirectIO()) {
+    GTEST_SKIP() << "O_DIRECT is not supported here";
+  }
+
+  // Scenario: aligned buffers go straight to the file, unaligned ones through the bounce buffer.
+  alignas(PAGE_SIZE) char aligned[PAGE_SIZE] = {0};
+  char unaligned_storage[PAGE_SIZE + 1] = {0};
+  char *unaligned = unaligned_storage + 1;
+  std::strncpy(aligned, "aligned", PAGE_SIZE);
+  std::strncpy(unaligned, "unaligned", PAGE_SIZE);
+  dm.WritePage(0, aligned);
+  dm.WritePage(1, unaligned);
+
+  dm.ReadPage(1, aligned);
+  EXPECT_STREQ("unaligned", aligned);
+  dm.ReadPage(0, unaligned);
+  EXPECT_STREQ("aligned", unaligned);
+
+  // Scenario: the pages reached the file, as a buffered reader sees them.
+  dm.ShutDown();
+  auto buffered = DiskManager("test.db");
+  EXPECT_FALSE(buffered.IsDirectIO());
+  buffered.ReadPage(0, unaligned);
+  EXPECT_STREQ("aligned", unaligned);
+  buffered.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreeSpaceMapTest) {
+  char data[PAGE_SIZE] = {0};
+  {
+    DiskManager dm("test.db");
+    // Scenario: pages are handed out lowest first, and a deallocated page is handed out again.
+    for (page_id_t i = 0; i < 4; i++) {
+      EXPECT_EQ(i, dm.AllocatePage());
+      dm.WritePage(i, data);
+    }
+    dm.DeallocatePage(1);
+    EXPECT_FALSE(dm.IsPageAllocated(1));
+    EXPECT_EQ(1, dm.AllocatePage());
+    EXPECT_EQ(4, dm.AllocatePage());
+
+    // Scenario: only page ids of the requested residue are handed out.
+    EXPECT_EQ(6, dm.AllocatePage(INVALID_PAGE_ID, 3, 0));
+    EXPECT_EQ(5, dm.AllocatePage(INVALID_PAGE_ID, 3, 2));
+
+    // Scenario: with a hint, a page follows it in its extent, and starts a fresh extent once that one is full.
+    dm.DeallocatePage(2);
+    EXPECT_EQ(7, dm.AllocatePage(6));
+    for (page_id_t i = 8; i < PAGES_PER_EXTENT; i++) {
+      EXPECT_EQ(i, dm.AllocatePage(i - 1));
+    }
+    EXPECT_EQ(PAGES_PER_EXTENT, dm.AllocatePage(PAGES_PER_EXTENT - 1));
+    EXPECT_EQ(2 * PAGES_PER_EXTENT, dm.AllocatePage(3));
+    EXPECT_EQ(2, dm.AllocatePage());
+
+    // Scenario: an extent emptied again is the first one a hint falls back to, ahead of those never used.
+    EXPECT_EQ(3 * PAGES_PER_EXTENT, dm.AllocatePage(3));
+    dm.DeallocatePage(2 * PAGES_PER_EXTENT);
+    EXPECT_EQ(2 * PAGES_PER_EXTENT, dm.AllocatePage(3));
+    EXPECT_EQ(4 * PAGES_PER_EXTENT, dm.AllocatePage(3));
+
+    // Scenario: a stride wider than an extent ignores the hint rather than handing out a page past the free extent.
+    EXPECT_EQ(PAGES_PER_EXTENT + 3, dm.AllocatePage(5 * PAGES_PER_EXTENT, PAGES_PER_EXTENT + 4, PAGES_PER_EXTENT + 3));
+    dm.DeallocatePage(PAGES_PER_EXTENT + 3);
+    dm.DeallocatePage(3);
+    dm.ShutDown();
+  }
+
+  // Scenario: the map survives a clean restart.
+  {
+    DiskManager dm("test.db");
+    EXPECT_TRUE(dm.IsPageAllocated(2 * PAGES_PER_EXTENT));
+    EXPECT_EQ(3, dm.AllocatePage());
+    dm.DeallocatePage(3);
+  }
+
+  // Scenario: without a cleanly saved map, every page of the file is taken to be in use.
+  remove("test.fsm");
+  {
+    DiskManager dm("test.db");
+    EXPECT_TRUE(dm.IsPageAllocated(3));
+    EXPECT_EQ(4, dm.AllocatePage());
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  const size_t pages_per_segment = 4;
+  DiskManager dm("test.db", false, pages_per_segment);
+  std::vector<std::vector<char>> data(12, std::vector<char>(PAGE_SIZE));
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  // Scenario: out of order, with gaps and runs that cross a segment boundary.
+  for (page_id_t page_id : {9, 2, 3, 0, 5, 4, 11, 6}) {
+    snprintf(data[page_id].data(), PAGE_SIZE, "page %d", page_id);
+    writes.emplace_back(page_id, data[page_id].data());
+  }
+  dm.WritePages(writes);
+  EXPECT_EQ(8, dm.GetNumWrites());
+
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < 12; page_id++) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_STREQ(data[page_id].data(), buf) << "page " << page_id;
+  }
+  dm.ShutDown();
+  remove("test.db.1");
+  remove("test.db.2");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, StatsTest) {
+  const size_t pages_per_segment = 4;
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  DiskManager dm("test.db", false, pages_per_segment);
+  for (page_id_t page_id = 0; page_id < 3; page_id++) {
+    dm.WritePage(page_id, data);
+  }
+  // Scenario: a batch in two segments is written with two vectored writes and syncs both segments.
+  dm.WritePages({{3, data}, {4, data}, {5, data}});
+  for (page_id_t page_id = 0; page_id < 6; page_id++) {
+    dm.ReadPage(page_id, buf);
+  }
+  // Scenario: a read past the end of the database does no I/O.
+  dm.ReadPage(100, buf);
+
+  DiskManagerStats stats = dm.GetStats();
+  EXPECT_EQ(6U, stats.num_writes_);
+  EXPECT_EQ(6U * PAGE_SIZE, stats.bytes_written_);
+  EXPECT_EQ(6U, stats.num_reads_);
+  EXPECT_EQ(6U * PAGE_SIZE, stats.bytes_read_);
+  EXPECT_EQ(2U, stats.num_syncs_);
+  EXPECT_EQ(0U, stats.num_corrupt_pages_);
+  EXPECT_EQ(3U, stats.write_latency_.count_);
+  EXPECT_EQ(7U, stats.read_latency_.count_);
+  EXPECT_EQ(6, dm.GetNumWrites());
+  dm.ShutDown();
+  remove("test.db.1");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  char data[PAGE_SIZE] = {0};
+  char old_data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  memset(old_data, 'o', PAGE_SIZE - 1);
+  memset(data, 'n', PAGE_SIZE - 1);
+  // overwrites part of page 1 behind the disk manager's back
+  auto overwrite = [](const char *bytes, size_t size) {
+    int fd = open("test.db", O_WRONLY);
+    EXPECT_EQ(static_cast<ssize_t>(size), pwrite(fd, bytes, size, PAGE_SIZE));
+    close(fd);
+  };
+  {
+    DiskManager dm("test.db", false, PAGES_PER_SEGMENT, true);
+    EXPECT_TRUE(dm.UsesChecksums());
+    dm.WritePage(0, data);
+    dm.WritePage(1, old_data);
+    dm.WritePage(1, data);
+    dm.ReadPage(1, buf);
+    EXPECT_STREQ(data, buf);
+
+    // Scenario: a write that never reached the disk leaves the old contents, which still verify.
+    overwrite(old_data, PAGE_SIZE);
+    dm.ReadPage(1, buf);
+    EXPECT_STREQ(old_data, buf);
+
+    // Scenario: a torn page, half old and half new, matches neither checksum.
+    overwrite(data, PAGE_SIZE / 2);
+    try {
+      dm.ReadPage(1, buf);
+      FAIL() << "corruption not detected";
+    } catch (Exception &e) {
+      EXPECT_EQ(ExceptionType::CORRUPTION, e.GetType());
+    }
+    EXPECT_EQ(1U, dm.GetStats().num_corrupt_pages_);
+
+    // Scenario: a batch syncs the checksums as well as the segment it wrote to.
+    uint64_t num_syncs = dm.GetStats().num_syncs_;
+    dm.WritePages({{2, data}, {3, data}});
+    EXPECT_EQ(num_syncs + 2, dm.GetStats().num_syncs_);
+    dm.ReadPage(3, buf);
+    EXPECT_STREQ(data, buf);
+
+    // Scenario: a single write syncs its checksum ahead of the page, unless the page is written unchanged.
+    num_syncs = dm.GetStats().num_syncs_;
+    dm.WritePage(4, data);
+    EXPECT_EQ(num_syncs + 1, dm.GetStats().num_syncs_);
+    dm.WritePage(4, data);
+    EXPECT_EQ(num_syncs + 1, dm.GetStats().num_syncs_);
+    dm.ShutDown();
+  }
+
+  // Scenario: the checksums survive a restart.
+  {
+    DiskManager dm("test.db", false, PAGES_PER_SEGMENT, true);
+    dm.ReadPage(0, buf);
+    EXPECT_STREQ(data, buf);
+    dm.ReadPage(4, buf);
+    EXPECT_STREQ(data, buf);
+    EXPECT_THROW(dm.ReadPage(1, buf), Exception);
+    dm.ShutDown();
+  }
+
+  // Scenario: opening without checksums drops them, so pages changed meanwhile are not flagged later.
+  {
+    DiskManager dm("test.db");
+    EXPECT_FALSE(dm.UsesChecksums());
+    dm.ReadPage(1, buf);
+    dm.ShutDown();
+  }
+  EXPECT_EQ(-1, GetFileSize("test.crc"));
+  {
+    DiskManager dm("test.db", false, PAGES_PER_SEGMENT, true);
+    dm.ReadPage(1, buf);
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressionTest) {
+  char buf[PAGE_SIZE] = {0};
+  char small[PAGE_SIZE] = {0};
+  char noise[PAGE_SIZE];
+  snprintf(small, sizeof(small), "mostly zeros");
+  std::mt19937 rng(15445);
+  for (char &c : noise) {
+    c = static_cast<char>(rng());
+  }
+  {
+    DiskManager dm("test.db", false, PAGES_PER_SEGMENT, true, true);
+    EXPECT_TRUE(dm.UsesCompression());
+    for (page_id_t i = 0; i < 16; i++) {
+      dm.WritePage(i, small);
+    }
+    // Scenario: compressible pages take a slot each, so sixteen fit in two pages' worth of file.
+    EXPECT_LE(GetFileSize("test.db"), 2 * PAGE_SIZE);
+    dm.ReadPage(5, buf);
+    EXPECT_EQ(0, memcmp(small, buf, PAGE_SIZE));
+
+    // Scenario: a page that does not compress is stored as it is. It moves, without disturbing its neighbours.
+    dm.WritePage(3, noise);
+    dm.ReadPage(3, buf);
+    EXPECT_EQ(0, memcmp(noise, buf, PAGE_SIZE));
+    dm.ReadPage(4, buf);
+    EXPECT_EQ(0, memcmp(small, buf, PAGE_SIZE));
+    const int64_t size = GetFileSize("test.db");
+    EXPECT_EQ(3 * PAGE_SIZE, size);
+
+    // Scenario: the slot it moved out of is reused.
+    dm.WritePage(20, small);
+    EXPECT_EQ(size, GetFileSize("test.db"));
+
+    // Scenario: when it shrinks again it moves to a new slot and gives back all of its old ones, so that the next
+    // uncompressible page fits where it was.
+    dm.WritePage(3, small);
+    dm.WritePage(21, noise);
+    EXPECT_EQ(size + COMPRESSION_SLOT_SIZE, GetFileSize("test.db"));
+    dm.ReadPage(3, buf);
+    EXPECT_EQ(0, memcmp(small, buf, PAGE_SIZE));
+    dm.ReadPage(21, buf);
+    EXPECT_EQ(0, memcmp(noise, buf, PAGE_SIZE));
+
+    // Scenario: a page never written reads as zeros.
+    dm.ReadPage(100, buf);
+    EXPECT_EQ(0, buf[0]);
+
+    // Scenario: deallocating a page frees its space.
+    dm.DeallocatePage(21);
+    dm.ShutDown();
+  }
+
+  // Scenario: after a restart every page is still found, and the space freed before is reused.
+  {
+    DiskManager dm("test.db", false, PAGES_PER_SEGMENT, true, true);
+    for (page_id_t i : {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 20}) {
+      dm.ReadPage(i, buf);
+      EXPECT_EQ(0, memcmp(small, buf, PAGE_SIZE)) << "page " << i;
+    }
+    dm.WritePage(30, noise);
+    EXPECT_EQ(3 * PAGE_SIZE + COMPRESSION_SLOT_SIZE, GetFileSize("test.db"));
+    dm.ReadPage(30, buf);
+    EXPECT_EQ(0, memcmp(noise, buf, PAGE_SIZE));
+
+    // Scenario: a write never overwrites the image the page map points to. The new image is synced before the map
+    // points to it, and the map is synced before the old slots are handed out again: a batch syncs the checksums,
+    // the segment and the page map.
+    uint64_t num_syncs = dm.GetStats().num_syncs_;
+    dm.WritePages({{5, noise}, {6, noise}});
+    EXPECT_EQ(num_syncs + 3, dm.GetStats().num_syncs_);
+    dm.ReadPage(5, buf);
+    EXPECT_EQ(0, memcmp(noise, buf, PAGE_SIZE));
+    dm.WritePages({{5, small}, {6, small}});
+    dm.ReadPage(6, buf);
+    EXPECT_EQ(0, memcmp(small, buf, PAGE_SIZE));
+
+    // Scenario: a damaged compressed image is reported as corruption.
+    int fd = open("test.db", O_WRONLY);
+    EXPECT_EQ(64, pwrite(fd, noise, 64, 0));
+    close(fd);
+    bool detected = false;
+    for (page_id_t i = 0; i < 16; i++) {
+      try {
+        dm.ReadPage(i, buf);
+      } catch (Exception &e) {
+        EXPECT_EQ(ExceptionType::CORRUPTION, e.GetType());
+        detected = true;
+      }
+    }
+    EXPECT_TRUE(detected);
+    dm.ShutDown();
+  }
+
+  // Scenario: a compressed database cannot be opened as an uncompressed one, nor the other way around.
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+  remove("test.map");
+  EXPECT_THROW(DiskManager("test.db", false, PAGES_PER_SEGMENT, false, true), Exception);
+
+  // Scenario: slots are too small for O_DIRECT, so compression cannot be combined with it.
+  remove("test.db");
+  EXPECT_THROW(DiskManager("test.db", true, PAGES_PER_SEGMENT, false, true), Exception);
+
+  // Scenario: an image never straddles two segment files; the space skipped at the end of one is used later.
+  remove("test.db");
+  {
+    DiskManager dm("test.db", false, 1, false, true);
+    dm.WritePage(0, small);
+    dm.WritePage(1, noise);
+    dm.WritePage(2, small);
+    EXPECT_EQ(2 * COMPRESSION_SLOT_SIZE, GetFileSize("test.db"));
+    EXPECT_EQ(PAGE_SIZE, GetFileSize("test.db.1"));
+    dm.ReadPage(1, buf);
+    EXPECT_EQ(0, memcmp(noise, buf, PAGE_SIZE));
+    dm.ReadPage(2, buf);
+    EXPECT_EQ(0, memcmp(small, buf, PAGE_SIZE));
+    dm.ShutDown();
+  }
+  remove("test.db.1");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SegmentTest) {
+  const size_t pages_per_segment = 4;
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  {
+    DiskManager dm("test.db", false, pages_per_segment);
+    for (page_id_t i = 0; i < 10; i++) {
+      snprintf(data, sizeof(data), "page %d", i);
+      dm.WritePage(i, data);
+    }
+    // Scenario: pages past the first segment go to segment files of their own, which are only as long as needed.
+    EXPECT_EQ(dm.GetSegmentFileName(1), "test.db.1");
+    EXPECT_EQ(static_cast<int64_t>(pages_per_segment) * PAGE_SIZE, GetFileSize("test.db.1"));
+    EXPECT_EQ(2 * PAGE_SIZE, GetFileSize("test.db.2"));
+    dm.ShutDown();
+  }
+
+  // Scenario: reopening finds every segment, and the end of the database is the end of the last one.
+  {
+    DiskManager dm("test.db", false, pages_per_segment);
+    for (page_id_t i = 0; i < 10; i++) {
+      snprintf(data, sizeof(data), "page %d", i);
+      dm.ReadPage(i, buf);
+      EXPECT_STREQ(data, buf);
+    }
+    memset(buf, 1, sizeof(buf));
+    dm.ReadPage(10, buf);
+    EXPECT_EQ(0, buf[0]);
+    dm.ShutDown();
+  }
+
+  // Scenario: reopening with another number of pages per segment, which would map pages to the wrong offsets, throws
+  // and leaves the database as it was.
+  EXPECT_THROW(DiskManager("test.db", false, 2 * pages_per_segment), Exception);
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+  {
+    DiskManager dm("test.db", false, pages_per_segment);
+    dm.ReadPage(9, buf);
+    EXPECT_STREQ("page 9", buf);
+    dm.ShutDown();
+  }
+  remove("test.db.1");
+  remove("test.db.2");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeFileTest) {
+  // Scenario: a page whose offset does not fit into 32 bits, in a segment past the first.
+  const page_id_t page_id = (int64_t{3} << 30) / PAGE_SIZE + 7;
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  snprintf(data, sizeof(data), "far away");
+  {
+    DiskManager dm("test.db");
+    dm.WritePage(page_id, data);
+    dm.ShutDown();
+  }
+  {
+    DiskManager dm("test.db");
+    dm.ReadPage(page_id, buf);
+    EXPECT_STREQ(data, buf);
+    dm.ReadPage(page_id - 1, buf);
+    EXPECT_EQ(0, buf[0]);
+    dm.ShutDown();
+  }
+  for (size_t i = 1; i <= page_id / PAGES_PER_SEGMENT; i++) {
+    remove(("test.db." + std::to_string(i)).c_str());
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
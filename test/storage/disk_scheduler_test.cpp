@@ -0,0 +1,244 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler_test.cpp
+//
+// Identification: test/storage/disk_scheduler_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_scheduler.h"
+
+namespace bustub {
+
+class DiskSchedulerTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.crc");
+  }
+
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.crc");
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_P(DiskSchedulerTest, ScheduleTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto disk_scheduler = std::make_unique<DiskScheduler>(disk_manager.get(), 16, GetParam());
+
+  // Scenario: a batch of writes completes, and the pages read back through the scheduler.
+  const int num_pages = 16;
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<DiskRequest> writes;
+  std::vector<std::future<bool>> write_futures;
+  for (int i = 0; i < num_pages; i++) {
+    snprintf(pages[i].data(), PAGE_SIZE, "page %d", i);
+    writes.push_back({true, pages[i].data(), i, disk_scheduler->CreatePromise()});
+    write_futures.push_back(writes.back().callback_.get_future());
+  }
+  disk_scheduler->Schedule(std::move(writes));
+  for (auto &future : write_futures) {
+    EXPECT_TRUE(future.get());
+  }
+  EXPECT_EQ(num_pages, disk_manager->GetNumWrites());
+
+  char buf[PAGE_SIZE];
+  for (int i = 0; i < num_pages; i++) {
+    auto promise = disk_scheduler->CreatePromise();
+    auto future = promise.get_future();
+    disk_scheduler->Schedule({false, buf, i, std::move(promise)});
+    ASSERT_TRUE(future.get());
+    EXPECT_STREQ(pages[i].data(), buf);
+  }
+
+  // Scenario: a page past the end of the file reads as zeros.
+  auto promise = disk_scheduler->CreatePromise();
+  auto future = promise.get_future();
+  std::memset(buf, 1, PAGE_SIZE);
+  disk_scheduler->Schedule({false, buf, 100, std::move(promise)});
+  ASSERT_TRUE(future.get());
+  std::vector<char> zeros(PAGE_SIZE);
+  EXPECT_EQ(0, std::memcmp(zeros.data(), buf, PAGE_SIZE));
+
+  // Scenario: a write ordered before a read into the same buffer writes the old contents out first.
+  snprintf(buf, PAGE_SIZE, "overwritten");
+  std::vector<DiskRequest> linked;
+  linked.push_back({true, buf, 20, disk_scheduler->CreatePromise(), true});
+  linked.push_back({false, buf, 3, disk_scheduler->CreatePromise()});
+  auto read_future = linked.back().callback_.get_future();
+  disk_scheduler->Schedule(std::move(linked));
+  ASSERT_TRUE(read_future.get());
+  EXPECT_STREQ("page 3", buf);
+  disk_manager->ReadPage(20, buf);
+  EXPECT_STREQ("overwritten", buf);
+
+  if (disk_scheduler->UsesIoUring()) {
+    // The batch of writes went out in far fewer submissions than requests.
+    EXPECT_LT(disk_scheduler->GetNumSubmissions(), disk_scheduler->GetNumCompleted());
+  }
+  disk_scheduler.reset();
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_P(DiskSchedulerTest, ChecksumTest) {
+  const int num_pages = 8;
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  {
+    DiskManager disk_manager("test.db", false, PAGES_PER_SEGMENT, true);
+    DiskScheduler disk_scheduler(&disk_manager, 16, GetParam());
+    std::vector<DiskRequest> writes;
+    std::vector<std::future<bool>> write_futures;
+    for (int i = 0; i < num_pages; i++) {
+      snprintf(pages[i].data(), PAGE_SIZE, "page %d", i);
+      writes.push_back({true, pages[i].data(), i, disk_scheduler.CreatePromise()});
+      write_futures.push_back(writes.back().callback_.get_future());
+    }
+    disk_scheduler.Schedule(std::move(writes));
+    for (auto &future : write_futures) {
+      EXPECT_TRUE(future.get());
+    }
+    if (disk_scheduler.UsesIoUring()) {
+      // Scenario: the checksums of a batch of writes are synced once, before the writes are submitted.
+      EXPECT_EQ(1U, disk_manager.GetStats().num_syncs_);
+    }
+    disk_manager.ShutDown();
+  }
+
+  // Scenario: every page written through the scheduler verifies after a restart.
+  DiskManager disk_manager("test.db", false, PAGES_PER_SEGMENT, true);
+  char buf[PAGE_SIZE];
+  for (int i = 0; i < num_pages; i++) {
+    disk_manager.ReadPage(i, buf);
+    EXPECT_STREQ(pages[i].data(), buf);
+  }
+  EXPECT_EQ(0U, disk_manager.GetStats().num_corrupt_pages_);
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_P(DiskSchedulerTest, BufferPoolTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto disk_scheduler = std::make_unique<DiskScheduler>(disk_manager.get(), DISK_SCHEDULER_QUEUE_DEPTH, GetParam());
+  const size_t pool_size = 4;
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager.get());
+  bpm->SetDiskScheduler(disk_scheduler.get());
+
+  // Scenario: dirty pages evicted by misses are written back through the scheduler and read back intact.
+  const int num_pages = 20;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      char expected[PAGE_SIZE];
+      snprintf(expected, PAGE_SIZE, "page %d", i);
+      EXPECT_STREQ(expected, page->GetData());
+      // Dirty them again so the next round's misses evict dirty pages.
+      EXPECT_TRUE(bpm->UnpinPage(i, true));
+    }
+  }
+
+  // Scenario: the background writer writes its rounds through the scheduler too.
+  bpm->StartBackgroundWriter(1.0, pool_size);
+  for (int i = 0; i < 200 && bpm->GetNumCleanFrames() < pool_size; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(pool_size, bpm->GetNumCleanFrames());
+  EXPECT_GT(bpm->GetNumBackgroundWrites(), 0);
+
+  bpm.reset();
+  disk_scheduler.reset();
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_P(DiskSchedulerTest, ConcurrentMissTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto disk_scheduler = std::make_unique<DiskScheduler>(disk_manager.get(), DISK_SCHEDULER_QUEUE_DEPTH, GetParam());
+  const size_t pool_size = 4;
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager.get());
+  bpm->SetDiskScheduler(disk_scheduler.get());
+  const int num_pages = 16;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    std::memset(page->GetData(), 0, PAGE_SIZE);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: misses read in and write back pages with the instance latch released. A miss on a page still being
+  // written back, or read in by another thread, waits for that I/O, so no increment is lost to a stale read.
+  const int num_threads = 8;
+  const int num_increments = 500;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < num_increments; i++) {
+        page_id_t page_id = (t * 7 + i * 5) % num_pages;
+        Page *page;
+        while ((page = bpm->FetchPage(page_id)) == nullptr) {
+          std::this_thread::yield();
+        }
+        page->WLatch();
+        int count;
+        std::memcpy(&count, page->GetData(), sizeof(count));
+        count++;
+        std::memcpy(page->GetData(), &count, sizeof(count));
+        page->WUnlatch();
+        bpm->UnpinPage(page_id, true);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int total = 0;
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    int count;
+    std::memcpy(&count, page->GetData(), sizeof(count));
+    total += count;
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(num_threads * num_increments, total);
+
+  bpm.reset();
+  disk_scheduler.reset();
+  disk_manager->ShutDown();
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, DiskSchedulerTest, ::testing::Bool(),
+                         [](const ::testing::TestParamInfo<bool> &info) {
+                           return info.param ? "IoUring" : "ThreadPool";
+                         });
+
+}  // namespace bustub
@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_iterator_test.cpp
+//
+// Identification: test/storage/index_iterator_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/exception.h"
+#include "gtest/gtest.h"
+#include "storage/index/index_iterator.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+using Iterator = IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
+
+// NOLINTNEXTLINE
+TEST(IndexIteratorTest, LeafChainReadAheadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+
+  // Scenario: build a chain of leaves, with an empty one in the middle, and write it out.
+  const int num_leaves = 20;
+  const int keys_per_leaf = 10;
+  const int empty_leaf = 5;
+  std::vector<page_id_t> leaf_page_ids;
+  {
+    auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+    LeafPage *prev = nullptr;
+    for (int i = 0; i < num_leaves; i++) {
+      page_id_t page_id;
+      auto *leaf = reinterpret_cast<LeafPage *>(bpm->NewPage(&page_id)->GetData());
+      leaf->Init(page_id);
+      for (int j = 0; i != empty_leaf && j < keys_per_leaf; j++) {
+        GenericKey<8> key;
+        int64_t value = i * keys_per_leaf + j;
+        key.SetFromInteger(value);
+        leaf->Insert(key, RID(0, value), comparator);
+      }
+      if (prev != nullptr) {
+        prev->SetNextPageId(page_id);
+        bpm->UnpinPage(prev->GetPageId(), true);
+      }
+      prev = leaf;
+      leaf_page_ids.push_back(page_id);
+    }
+    bpm->UnpinPage(prev->GetPageId(), true);
+    bpm->FlushAllPages();
+    delete bpm;
+  }
+
+  // Scenario: iterating from a cold pool reads the following leaves ahead.
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  const size_t distance = bpm->GetReadAheadDistance();
+  auto is_resident = [&](page_id_t page_id) {
+    for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+      if (bpm->GetPages()[i].GetPageId() == page_id) {
+        return true;
+      }
+    }
+    return false;
+  };
+  {
+    Iterator iterator(bpm, leaf_page_ids[0], 0);
+    for (int i = 0; i < 100 && !is_resident(leaf_page_ids[distance]); i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (size_t i = 1; i <= distance; i++) {
+      EXPECT_TRUE(is_resident(leaf_page_ids[i])) << "leaf " << i;
+    }
+
+    // Scenario: every key comes back in order, skipping the empty leaf, and the end compares equal to End().
+    int64_t expected = 0;
+    for (; !iterator.IsEnd(); ++iterator) {
+      if (expected == empty_leaf * keys_per_leaf) {
+        expected += keys_per_leaf;
+      }
+      EXPECT_EQ(expected, (*iterator).second.GetSlotNum());
+      expected++;
+    }
+    EXPECT_EQ(num_leaves * keys_per_leaf, expected);
+    EXPECT_TRUE(iterator == Iterator());
+  }
+
+  // Scenario: a position past the end of a leaf starts on the next one.
+  {
+    Iterator iterator(bpm, leaf_page_ids[0], keys_per_leaf);
+    ASSERT_FALSE(iterator.IsEnd());
+    EXPECT_EQ(keys_per_leaf, (*iterator).second.GetSlotNum());
+  }
+
+  // Scenario: the iterator let go of every leaf it visited.
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+  delete bpm;
+
+  // Scenario: from a cold pool again, the window moves along with the iterator, leaf by leaf, to the same distance.
+  bpm = new BufferPoolManagerInstance(32, disk_manager);
+  {
+    const int leaf = 10;
+    Iterator iterator(bpm, leaf_page_ids[0], 0);
+    while ((*iterator).second.GetSlotNum() != leaf * keys_per_leaf) {
+      ++iterator;
+    }
+    // Leaves that entered the window while a request was running are read ahead at a later step.
+    for (int i = 0; i < 100 && !is_resident(leaf_page_ids[leaf + distance]); i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      if ((*iterator).second.GetSlotNum() < (leaf + 1) * keys_per_leaf - 1) {
+        ++iterator;
+      }
+    }
+    EXPECT_TRUE(is_resident(leaf_page_ids[leaf + distance]));
+  }
+
+  // Scenario: a leaf that no frame can be freed for is an error, not a crash.
+  std::vector<page_id_t> pinned(leaf_page_ids.end() - 3, leaf_page_ids.end());
+  auto *small_bpm = new BufferPoolManagerInstance(pinned.size(), disk_manager);
+  for (page_id_t page_id : pinned) {
+    ASSERT_NE(nullptr, small_bpm->FetchPage(page_id));
+  }
+  try {
+    Iterator iterator(small_bpm, leaf_page_ids[0], 0);
+    FAIL() << "no exception";
+  } catch (Exception &e) {
+    EXPECT_EQ(ExceptionType::OUT_OF_MEMORY, e.GetType());
+  }
+  for (page_id_t page_id : pinned) {
+    EXPECT_TRUE(small_bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete small_bpm;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_test.cpp
+//
+// Identification: test/storage/page_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageTest, OptimisticReadTest) {
+  Page page;
+  uint64_t version;
+  ASSERT_TRUE(page.TryOptimisticRead(&version));
+  EXPECT_TRUE(page.ValidateOptimisticRead(version));
+
+  // Scenario: readers that take the read latch do not invalidate optimistic reads.
+  page.RLatch();
+  EXPECT_TRUE(page.ValidateOptimisticRead(version));
+  page.RUnlatch();
+  EXPECT_TRUE(page.ValidateOptimisticRead(version));
+
+  // Scenario: a writer invalidates reads started before it, and reads started while it is in fail right away.
+  page.WLatch();
+  EXPECT_FALSE(page.ValidateOptimisticRead(version));
+  uint64_t version_during_write;
+  EXPECT_FALSE(page.TryOptimisticRead(&version_during_write));
+  page.WUnlatch();
+  EXPECT_FALSE(page.ValidateOptimisticRead(version));
+
+  // Scenario: reads started after the writer left are valid again.
+  ASSERT_TRUE(page.TryOptimisticRead(&version));
+  EXPECT_TRUE(page.ValidateOptimisticRead(version));
+}
+
+// NOLINTNEXTLINE
+TEST(PageTest, ConcurrentOptimisticReadTest) {
+  const int num_writes = 2000;
+  const int num_readers = 2;
+  Page page;
+  std::atomic<bool> done{false};
+  std::atomic<int> num_torn{0};
+
+  // Scenario: the writer fills the whole page with one byte value at a time, so a validated read never sees two.
+  std::thread writer([&] {
+    for (int i = 1; i <= num_writes; i++) {
+      page.WLatch();
+      memset(page.GetData(), i % 128, PAGE_SIZE);
+      page.WUnlatch();
+    }
+    done = true;
+  });
+  std::vector<std::thread> readers;
+  for (int t = 0; t < num_readers; t++) {
+    readers.emplace_back([&] {
+      while (!done) {
+        uint64_t version;
+        if (!page.TryOptimisticRead(&version)) {
+          continue;
+        }
+        char first = page.GetData()[0];
+        char last = page.GetData()[PAGE_SIZE - 1];
+        if (page.ValidateOptimisticRead(version) && first != last) {
+          num_torn++;
+        }
+      }
+    });
+  }
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, num_torn);
+
+  uint64_t version;
+  ASSERT_TRUE(page.TryOptimisticRead(&version));
+  EXPECT_EQ(num_writes % 128, page.GetData()[PAGE_SIZE - 1]);
+  EXPECT_TRUE(page.ValidateOptimisticRead(version));
+}
+
+}  // namespace bustub
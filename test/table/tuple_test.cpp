@@ -11,12 +11,16 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "common/exception.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
@@ -71,4 +75,137 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+/** @return true if page_id is held by one of the pool's frames */
+bool IsResident(BufferPoolManagerInstance *bpm, page_id_t page_id) {
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    if (bpm->GetPages()[i].GetPageId() == page_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, TableHeapReadAheadTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Column col3{"c", TypeId::BIGINT};
+  Column col4{"d", TypeId::BOOLEAN};
+  Column col5{"e", TypeId::VARCHAR, 16};
+  std::vector<Column> cols{col1, col2, col3, col4, col5};
+  Schema schema{cols};
+  Tuple tuple = ConstructTuple(&schema);
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+
+  // Scenario: write a table several times larger than the pool that will scan it.
+  std::vector<page_id_t> table_pages;
+  size_t num_tuples = 0;
+  page_id_t first_page_id;
+  {
+    auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+    auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+    while (table_pages.size() < 100) {
+      RID rid;
+      ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+      if (table_pages.empty() || table_pages.back() != rid.GetPageId()) {
+        table_pages.push_back(rid.GetPageId());
+      }
+      num_tuples++;
+    }
+    first_page_id = table->GetFirstPageId();
+    buffer_pool_manager->FlushAllPages();
+    delete table;
+    delete buffer_pool_manager;
+  }
+
+  // Scenario: opening a scan on a cold pool reads the next pages of the chain ahead, without pinning them.
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(32, disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, first_page_id);
+  const size_t distance = buffer_pool_manager->GetReadAheadDistance();
+  ASSERT_EQ(8, distance);
+  TableIterator itr = table->Begin(transaction);
+  for (int i = 0; i < 100 && !IsResident(buffer_pool_manager, table_pages[distance]); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  for (size_t i = 1; i <= distance; i++) {
+    EXPECT_TRUE(IsResident(buffer_pool_manager, table_pages[i])) << "page " << i << " of the table";
+  }
+  EXPECT_FALSE(IsResident(buffer_pool_manager, table_pages[distance + 1]));
+  for (size_t i = 0; i < buffer_pool_manager->GetPoolSize(); i++) {
+    EXPECT_EQ(0, buffer_pool_manager->GetPages()[i].GetPinCount());
+  }
+
+  // Scenario: the whole table is still scanned, once, in order.
+  size_t num_scanned = 0;
+  std::unordered_set<page_id_t> scanned_pages;
+  for (; itr != table->End(); ++itr) {
+    scanned_pages.insert(itr->GetRid().GetPageId());
+    num_scanned++;
+  }
+  EXPECT_EQ(num_tuples, num_scanned);
+  EXPECT_EQ(table_pages.size(), scanned_pages.size());
+  delete table;
+  delete buffer_pool_manager;
+
+  // Scenario: from a cold pool again, the window moves along with the scan, page by page, to the same distance.
+  buffer_pool_manager = new BufferPoolManagerInstance(32, disk_manager);
+  table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, first_page_id);
+  {
+    const size_t page = 10;
+    TableIterator scan = table->Begin(transaction);
+    while (scan->GetRid().GetPageId() != table_pages[page]) {
+      ++scan;
+    }
+    // Pages that entered the window while a request was running are read ahead at a later step.
+    for (int i = 0; i < 100 && !IsResident(buffer_pool_manager, table_pages[page + distance]); i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      TableIterator next = scan;
+      if ((++next)->GetRid().GetPageId() == table_pages[page]) {
+        scan = next;
+      }
+    }
+    EXPECT_TRUE(IsResident(buffer_pool_manager, table_pages[page + distance]));
+  }
+  delete table;
+  delete buffer_pool_manager;
+
+  // Scenario: a page that no frame can be freed for is an error, not a crash, and leaves no pin behind.
+  buffer_pool_manager = new BufferPoolManagerInstance(3, disk_manager);
+  table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, first_page_id);
+  {
+    TableIterator scan = table->Begin(transaction);
+    std::vector<page_id_t> pinned(table_pages.end() - 2, table_pages.end());
+    for (page_id_t page_id : pinned) {
+      ASSERT_NE(nullptr, buffer_pool_manager->FetchPage(page_id));
+    }
+    try {
+      for (; scan != table->End(); ++scan) {
+      }
+      FAIL() << "no exception";
+    } catch (Exception &e) {
+      EXPECT_EQ(ExceptionType::OUT_OF_MEMORY, e.GetType());
+    }
+    for (page_id_t page_id : pinned) {
+      EXPECT_TRUE(buffer_pool_manager->UnpinPage(page_id, false));
+    }
+    for (size_t i = 0; i < buffer_pool_manager->GetPoolSize(); i++) {
+      EXPECT_EQ(0, buffer_pool_manager->GetPages()[i].GetPinCount());
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");  // remove db file
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub
@@ -0,0 +1,258 @@
+/*
+ * LZ4 block codec: the one-shot block functions declared in lz4.h.
+ *
+ * This is not upstream's lib/lz4.c. It implements, against the LZ4 block format
+ * (https://github.com/lz4/lz4/blob/v1.9.4/doc/lz4_Block_format.md), the subset of
+ * the lz4.h API that BusTub uses, with the contracts lz4.h documents for them:
+ *   LZ4_versionNumber, LZ4_versionString, LZ4_compressBound,
+ *   LZ4_compress_default, LZ4_compress_fast, LZ4_decompress_safe.
+ * Blocks it writes decompress with the reference library and vice versa. The
+ * streaming, dictionary and partial-decoding functions are not provided. See
+ * third_party/versions.txt.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lz4.h"
+
+/* Every match is at least this long; the token stores the length minus it. */
+#define MIN_MATCH 4
+/* The last bytes of a block are always literals. */
+#define LAST_LITERALS 5
+/* The last match starts at least this many bytes before the end of the block. */
+#define MF_LIMIT 12
+/* Offsets are stored in two bytes. */
+#define MAX_DISTANCE 65535
+/* Length nibbles of the token saturate at this value and continue in extra bytes. */
+#define RUN_MASK 15U
+/* The hash table of the match finder has 1 << HASH_LOG entries. */
+#define HASH_LOG 12
+/* Unsuccessful searches move on faster the longer they last, so incompressible data is skipped over quickly. */
+#define SKIP_TRIGGER 6
+
+static uint32_t LZ4_read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t LZ4_hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_LOG); }
+
+/* Returns the number of bytes at a and b that are equal, stopping at limit. */
+static size_t LZ4_commonLength(const uint8_t *a, const uint8_t *b, const uint8_t *limit) {
+  const uint8_t *start = a;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (a + sizeof(uint64_t) <= limit) {
+    uint64_t x;
+    uint64_t y;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    if (x != y) {
+      return (size_t)(a - start) + (size_t)__builtin_ctzll(x ^ y) / 8;
+    }
+    a += sizeof(uint64_t);
+    b += sizeof(uint64_t);
+  }
+#endif
+  while (a < limit && *a == *b) {
+    a++;
+    b++;
+  }
+  return (size_t)(a - start);
+}
+
+/* Appends the continuation bytes of a length that did not fit in its nibble. */
+static uint8_t *LZ4_writeLength(uint8_t *op, size_t length) {
+  for (; length >= 255; length -= 255) {
+    *op++ = 255;
+  }
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+/*
+ * Appends a sequence: literal_length literals, then, unless has_match is 0, a match of match_length + MIN_MATCH bytes
+ * at offset. Returns NULL if it does not fit before op_end.
+ */
+static uint8_t *LZ4_writeSequence(uint8_t *op, const uint8_t *op_end, const uint8_t *literals, size_t literal_length,
+                                  int has_match, size_t offset, size_t match_length) {
+  size_t needed = 1 + literal_length + (literal_length + 255 - RUN_MASK) / 255;
+  uint8_t *token;
+  if (has_match) {
+    needed += 2 + (match_length + 255 - RUN_MASK) / 255;
+  }
+  if (needed > (size_t)(op_end - op)) {
+    return NULL;
+  }
+  token = op++;
+  *token = (uint8_t)((literal_length < RUN_MASK ? literal_length : RUN_MASK) << 4);
+  if (literal_length >= RUN_MASK) {
+    op = LZ4_writeLength(op, literal_length - RUN_MASK);
+  }
+  if (literal_length > 0) {
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+  }
+  if (has_match) {
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    *token |= (uint8_t)(match_length < RUN_MASK ? match_length : RUN_MASK);
+    if (match_length >= RUN_MASK) {
+      op = LZ4_writeLength(op, match_length - RUN_MASK);
+    }
+  }
+  return op;
+}
+
+/* Adds the continuation bytes of a length to *length. Returns 0 if the input ends first. */
+static int LZ4_readLength(const uint8_t **ip, const uint8_t *ip_end, size_t *length) {
+  uint8_t byte;
+  do {
+    if (*ip >= ip_end) {
+      return 0;
+    }
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return 1;
+}
+
+int LZ4_versionNumber(void) { return LZ4_VERSION_NUMBER; }
+
+const char *LZ4_versionString(void) { return LZ4_VERSION_STRING; }
+
+int LZ4_compressBound(int inputSize) { return LZ4_COMPRESSBOUND(inputSize); }
+
+int LZ4_compress_fast(const char *src, char *dst, int srcSize, int dstCapacity, int acceleration) {
+  const uint8_t *base = (const uint8_t *)src;
+  const uint8_t *end;
+  const uint8_t *anchor = base;
+  uint8_t *op = (uint8_t *)dst;
+  const uint8_t *op_end;
+  if (srcSize < 0 || srcSize > LZ4_MAX_INPUT_SIZE || dstCapacity <= 0) {
+    return 0;
+  }
+  if (acceleration < 1) {
+    acceleration = 1;
+  }
+  if (acceleration > 65537) {
+    acceleration = 65537;
+  }
+  end = base + srcSize;
+  op_end = op + dstCapacity;
+
+  if (srcSize > MF_LIMIT) {
+    const uint8_t *match_limit = end - LAST_LITERALS;
+    const uint8_t *last_match_start = end - MF_LIMIT;
+    /* Position of the last occurrence of each hashed 4-byte sequence, plus one; 0 if there is none. */
+    uint32_t table[1 << HASH_LOG] = {0};
+    const uint8_t *ip = base;
+    unsigned search_count = (unsigned)acceleration << SKIP_TRIGGER;
+    while (ip <= last_match_start) {
+      uint32_t sequence = LZ4_read32(ip);
+      uint32_t *slot = &table[LZ4_hash(sequence)];
+      const uint8_t *match = *slot == 0 ? NULL : base + *slot - 1;
+      size_t match_length;
+      *slot = (uint32_t)(ip - base + 1);
+      if (match == NULL || ip - match > MAX_DISTANCE || LZ4_read32(match) != sequence) {
+        ip += search_count++ >> SKIP_TRIGGER;
+        continue;
+      }
+      search_count = (unsigned)acceleration << SKIP_TRIGGER;
+      /* Extend the match backwards over literals not yet emitted, then forwards. */
+      while (ip > anchor && match > base && ip[-1] == match[-1]) {
+        ip--;
+        match--;
+      }
+      match_length = LZ4_commonLength(ip + MIN_MATCH, match + MIN_MATCH, match_limit);
+      op = LZ4_writeSequence(op, op_end, anchor, (size_t)(ip - anchor), 1, (size_t)(ip - match), match_length);
+      if (op == NULL) {
+        return 0;
+      }
+      ip += MIN_MATCH + match_length;
+      anchor = ip;
+      /* Index a position inside the match as well, which helps runs of repeated data. */
+      table[LZ4_hash(LZ4_read32(ip - 2))] = (uint32_t)(ip - 2 - base + 1);
+    }
+  }
+
+  op = LZ4_writeSequence(op, op_end, anchor, (size_t)(end - anchor), 0, 0, 0);
+  if (op == NULL) {
+    return 0;
+  }
+  return (int)(op - (uint8_t *)dst);
+}
+
+int LZ4_compress_default(const char *src, char *dst, int srcSize, int dstCapacity) {
+  return LZ4_compress_fast(src, dst, srcSize, dstCapacity, 1);
+}
+
+int LZ4_decompress_safe(const char *src, char *dst, int compressedSize, int dstCapacity) {
+  const uint8_t *ip = (const uint8_t *)src;
+  const uint8_t *ip_end;
+  uint8_t *op = (uint8_t *)dst;
+  uint8_t *op_start = op;
+  const uint8_t *op_end;
+  if (compressedSize <= 0 || dstCapacity < 0) {
+    return -1;
+  }
+  ip_end = ip + compressedSize;
+  op_end = op + dstCapacity;
+
+  for (;;) {
+    uint8_t token;
+    size_t literal_length;
+    size_t offset;
+    size_t match_length;
+    const uint8_t *match;
+    if (ip >= ip_end) {
+      return -1;
+    }
+    token = *ip++;
+    literal_length = token >> 4;
+    if (literal_length == RUN_MASK && !LZ4_readLength(&ip, ip_end, &literal_length)) {
+      return -1;
+    }
+    if (literal_length > (size_t)(ip_end - ip) || literal_length > (size_t)(op_end - op)) {
+      return -1;
+    }
+    memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    /* The last sequence has no match. */
+    if (ip == ip_end) {
+      break;
+    }
+
+    if (ip_end - ip < 2) {
+      return -1;
+    }
+    offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - op_start)) {
+      return -1;
+    }
+    match_length = token & RUN_MASK;
+    if (match_length == RUN_MASK && !LZ4_readLength(&ip, ip_end, &match_length)) {
+      return -1;
+    }
+    match_length += MIN_MATCH;
+    if (match_length > (size_t)(op_end - op)) {
+      return -1;
+    }
+    match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      /* The match overlaps the bytes it produces, e.g. a run of one repeated byte. */
+      size_t i;
+      for (i = 0; i < match_length; i++) {
+        *op++ = *match++;
+      }
+    }
+  }
+  return (int)(op - op_start);
+}